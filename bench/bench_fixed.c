@@ -0,0 +1,196 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gx_define.h"
+#include "gx_fixed.h"
+#include "gx_math.h"
+
+//
+// Throughput of the vec2 backend the simulation is built with against native
+// Q16.16. The kernel is the ship steering step from tick_game: normalize
+// toward a target, scale by speed, integrate, then test arrival.
+//
+
+#define ENTITY_COUNT 100000
+#define STEP_COUNT   16
+#define REPEAT_COUNT 9
+
+struct FloatEntity
+{
+    vec2 position;
+    vec2 target;
+};
+
+struct FixedEntity
+{
+    fixed2 position;
+    fixed2 target;
+};
+
+static double get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32 steer_vec2(struct FloatEntity *entities, uint32 count, float dt)
+{
+    uint32 arrived = 0;
+    for (uint32 step = 0; step < STEP_COUNT; ++step)
+    {
+        for (uint32 i = 0; i < count; ++i)
+        {
+            struct FloatEntity *entity = &entities[i];
+            vec2 direction = vec2_normalize(vec2_sub(entity->target, entity->position));
+            vec2 velocity = vec2_mul(direction, 2.0f);
+            entity->position = vec2_add(entity->position, vec2_mul(velocity, dt));
+
+            if (vec2_distance2(entity->position, entity->target) < 0.1f)
+                ++arrived;
+        }
+    }
+
+    return arrived;
+}
+
+static uint32 steer_fixed2(struct FixedEntity *entities, uint32 count, fixed dt)
+{
+    const fixed speed = fixed_from_int(2);
+    const int64 arrive_distance2 = (int64)fixed_from_float(0.1f) << FIXED_SHIFT;
+
+    uint32 arrived = 0;
+    for (uint32 step = 0; step < STEP_COUNT; ++step)
+    {
+        for (uint32 i = 0; i < count; ++i)
+        {
+            struct FixedEntity *entity = &entities[i];
+            fixed2 direction = fixed2_normalize(fixed2_sub(entity->target, entity->position));
+            fixed2 velocity = fixed2_mul(direction, speed);
+            entity->position = fixed2_add(entity->position, fixed2_mul(velocity, dt));
+
+            if (fixed2_length2(fixed2_sub(entity->position, entity->target)) < arrive_distance2)
+                ++arrived;
+        }
+    }
+
+    return arrived;
+}
+
+static float direction_vec2(float *angles, uint32 count)
+{
+    float sum = 0.0f;
+    for (uint32 i = 0; i < count; ++i)
+        sum += vec2_direction(angles[i]).x;
+    return sum;
+}
+
+static int64 direction_fixed2(fixed *angles, uint32 count)
+{
+    int64 sum = 0;
+    for (uint32 i = 0; i < count; ++i)
+        sum += fixed2_direction(angles[i]).x;
+    return sum;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x < y) ? -1 : (x > y);
+}
+
+static void report(const char *label, double *times, uint64 operation_count)
+{
+    qsort(times, REPEAT_COUNT, sizeof(double), compare_double);
+    double median = times[REPEAT_COUNT / 2];
+    fprintf(stdout, "%-26s median %8.3f ms  min %8.3f ms  %7.2f ns/op\n",
+            label, median * 1000.0, times[0] * 1000.0, median * 1e9 / (double)operation_count);
+}
+
+int main(int argc, char *argv[])
+{
+    struct Random random = create_random(23932487);
+
+    uint32 count = ENTITY_COUNT;
+    struct FloatEntity *float_source = malloc(count * sizeof(struct FloatEntity));
+    struct FloatEntity *float_entities = malloc(count * sizeof(struct FloatEntity));
+    struct FixedEntity *fixed_source = malloc(count * sizeof(struct FixedEntity));
+    struct FixedEntity *fixed_entities = malloc(count * sizeof(struct FixedEntity));
+    float *float_angles = malloc(count * sizeof(float));
+    fixed *fixed_angles = malloc(count * sizeof(fixed));
+    ASSERT(float_source && float_entities && fixed_source && fixed_entities && float_angles && fixed_angles);
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        float_source[i].position = vec2_new(random_float_r(&random, -64.0f, 64.0f), random_float_r(&random, -64.0f, 64.0f));
+        float_source[i].target = vec2_new(random_float_r(&random, -64.0f, 64.0f), random_float_r(&random, -64.0f, 64.0f));
+        fixed_source[i].position = fixed2_from_floats(float_source[i].position.x, float_source[i].position.y);
+        fixed_source[i].target = fixed2_from_floats(float_source[i].target.x, float_source[i].target.y);
+
+        float_angles[i] = random_float_r(&random, -TWO_PI, TWO_PI);
+        fixed_angles[i] = fixed_from_float(float_angles[i]);
+    }
+
+#ifdef GX_FIXED_POINT
+    fprintf(stdout, "vec2 backend: fixed point (float storage, Q16.16 arithmetic)\n");
+#else
+    fprintf(stdout, "vec2 backend: float\n");
+#endif
+
+    const float dt = 1.0f / 60.0f;
+    uint64 steer_operations = (uint64)count * STEP_COUNT;
+    double times[REPEAT_COUNT];
+    uint32 arrived = 0;
+
+    for (uint32 i = 0; i < REPEAT_COUNT; ++i)
+    {
+        memcpy(float_entities, float_source, count * sizeof(struct FloatEntity));
+        double start = get_time();
+        arrived += steer_vec2(float_entities, count, dt);
+        times[i] = get_time() - start;
+    }
+    report("steer vec2", times, steer_operations);
+
+    for (uint32 i = 0; i < REPEAT_COUNT; ++i)
+    {
+        memcpy(fixed_entities, fixed_source, count * sizeof(struct FixedEntity));
+        double start = get_time();
+        arrived += steer_fixed2(fixed_entities, count, fixed_from_float(dt));
+        times[i] = get_time() - start;
+    }
+    report("steer fixed2", times, steer_operations);
+
+    float float_sum = 0.0f;
+    for (uint32 i = 0; i < REPEAT_COUNT; ++i)
+    {
+        double start = get_time();
+        float_sum += direction_vec2(float_angles, count);
+        times[i] = get_time() - start;
+    }
+    report("direction vec2", times, count);
+
+    int64 fixed_sum = 0;
+    for (uint32 i = 0; i < REPEAT_COUNT; ++i)
+    {
+        double start = get_time();
+        fixed_sum += direction_fixed2(fixed_angles, count);
+        times[i] = get_time() - start;
+    }
+    report("direction fixed2", times, count);
+
+    // Keeps the kernels from being optimized away.
+    fprintf(stdout, "(checksum %u %f %lld)\n", arrived, (double)float_sum, (long long)fixed_sum);
+
+    free(fixed_angles);
+    free(float_angles);
+    free(fixed_entities);
+    free(fixed_source);
+    free(float_entities);
+    free(float_source);
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gx_define.h"
+#include "gx_math.h"
+#include "gx_morton.h"
+#include "gx.h"
+
+//
+// Measures how entity array order affects a neighbour query over 50k ships:
+// shuffled order (what swap-removes leave behind) versus Morton order.
+//
+
+#define ENTITY_COUNT 50000
+#define GRID_SIZE    256
+#define REPEAT_COUNT 9
+
+struct NeighborGrid
+{
+    float cell_size;
+    vec2 origin;
+
+    uint32 cell_offsets[GRID_SIZE * GRID_SIZE + 1];
+    uint32 indices[ENTITY_COUNT];
+};
+
+static double get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32 calc_cell(struct NeighborGrid *grid, vec2 position)
+{
+    int32 x = (int32)((position.x - grid->origin.x) / grid->cell_size);
+    int32 y = (int32)((position.y - grid->origin.y) / grid->cell_size);
+    x = min_int32(max_int32(x, 0), GRID_SIZE - 1);
+    y = min_int32(max_int32(y, 0), GRID_SIZE - 1);
+    return (uint32)(y * GRID_SIZE + x);
+}
+
+static void build_neighbor_grid(struct NeighborGrid *grid, struct Ship *ships, uint32 count)
+{
+    memset(grid->cell_offsets, 0, sizeof(grid->cell_offsets));
+    for (uint32 i = 0; i < count; ++i)
+        ++grid->cell_offsets[calc_cell(grid, ships[i].position) + 1];
+    for (uint32 i = 1; i <= GRID_SIZE * GRID_SIZE; ++i)
+        grid->cell_offsets[i] += grid->cell_offsets[i - 1];
+
+    static uint32 cursors[GRID_SIZE * GRID_SIZE];
+    memcpy(cursors, grid->cell_offsets, sizeof(cursors));
+    for (uint32 i = 0; i < count; ++i)
+        grid->indices[cursors[calc_cell(grid, ships[i].position)]++] = i;
+}
+
+// For every ship, count the ships within 'radius' by visiting the 3x3 neighbouring cells.
+static uint64 query_neighbors(struct NeighborGrid *grid, struct Ship *ships, uint32 count, float radius)
+{
+    uint64 neighbor_count = 0;
+    float radius2 = radius * radius;
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        vec2 position = ships[i].position;
+        uint32 cell = calc_cell(grid, position);
+        int32 cx = cell % GRID_SIZE;
+        int32 cy = cell / GRID_SIZE;
+
+        for (int32 y = max_int32(cy - 1, 0); y <= min_int32(cy + 1, GRID_SIZE - 1); ++y)
+        {
+            for (int32 x = max_int32(cx - 1, 0); x <= min_int32(cx + 1, GRID_SIZE - 1); ++x)
+            {
+                uint32 c = y * GRID_SIZE + x;
+                for (uint32 k = grid->cell_offsets[c]; k < grid->cell_offsets[c + 1]; ++k)
+                {
+                    struct Ship *other = &ships[grid->indices[k]];
+                    float dx = other->position.x - position.x;
+                    float dy = other->position.y - position.y;
+                    if (dx * dx + dy * dy < radius2)
+                        ++neighbor_count;
+                }
+            }
+        }
+    }
+
+    return neighbor_count;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x < y) ? -1 : (x > y);
+}
+
+static void measure(const char *label, struct NeighborGrid *grid, struct Ship *ships, uint32 count)
+{
+    build_neighbor_grid(grid, ships, count);
+
+    double times[REPEAT_COUNT];
+    uint64 cycles[REPEAT_COUNT];
+    uint64 neighbor_count = 0;
+    for (uint32 i = 0; i < REPEAT_COUNT; ++i)
+    {
+        double start = get_time();
+        uint64 start_cycles = rdtsc();
+        neighbor_count = query_neighbors(grid, ships, count, grid->cell_size);
+        cycles[i] = rdtsc() - start_cycles;
+        times[i] = get_time() - start;
+    }
+
+    qsort(times, REPEAT_COUNT, sizeof(double), compare_double);
+    fprintf(stdout, "%-10s median %8.3f ms  min %8.3f ms  max %8.3f ms  %6.1f cycles/entity  (%llu neighbours)\n",
+            label, times[REPEAT_COUNT / 2] * 1000.0, times[0] * 1000.0, times[REPEAT_COUNT - 1] * 1000.0,
+            (double)cycles[REPEAT_COUNT / 2] / (double)count, (unsigned long long)neighbor_count);
+}
+
+int main(int argc, char *argv[])
+{
+    init_random(23932487);
+
+    uint32 count = ENTITY_COUNT;
+    struct Ship *ships = calloc(count, sizeof(struct Ship));
+    struct SortKey *keys = malloc(count * sizeof(struct SortKey));
+    struct SortKey *scratch = malloc(count * sizeof(struct SortKey));
+    struct NeighborGrid *grid = malloc(sizeof(struct NeighborGrid));
+    ASSERT(ships && keys && scratch && grid);
+
+    // ~3 ships per cell on average.
+    const float world_size = 512.0f;
+    grid->cell_size = world_size / GRID_SIZE;
+    grid->origin = vec2_scalar(-world_size / 2.0f);
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        ships[i].id = i;
+        ships[i].position = vec2_new(random_float(-world_size / 2.0f, world_size / 2.0f), random_float(-world_size / 2.0f, world_size / 2.0f));
+        ships[i].size = vec2_new(1, 1);
+    }
+
+    fprintf(stdout, "%u ships, %zu bytes each (%.1f MB)\n", count, sizeof(struct Ship), (double)(count * sizeof(struct Ship)) / (1024.0 * 1024.0));
+
+    measure("shuffled", grid, ships, count);
+
+    struct AABB bounds;
+    bounds.min = grid->origin;
+    bounds.max = vec2_add(grid->origin, vec2_scalar(world_size));
+
+    double sort_start = get_time();
+    for (uint32 i = 0; i < count; ++i)
+    {
+        keys[i].key = morton_key(ships[i].position, bounds);
+        keys[i].index = i;
+    }
+    radix_sort(keys, scratch, count);
+    double sort_time = get_time() - sort_start;
+
+    struct Ship temp;
+    double permute_start = get_time();
+    apply_sort_order(ships, sizeof(struct Ship), keys, count, &temp);
+    double permute_time = get_time() - permute_start;
+
+    fprintf(stdout, "morton key + radix sort %.3f ms, permute %.3f ms\n", sort_time * 1000.0, permute_time * 1000.0);
+
+    measure("morton", grid, ships, count);
+
+    free(grid);
+    free(scratch);
+    free(keys);
+    free(ships);
+
+    return 0;
+}
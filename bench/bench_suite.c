@@ -0,0 +1,670 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// The subsystems measured here are static in gx.c, so it is compiled into
+// this file instead of linked.
+#include "gx.c"
+
+//
+// Scaling curves for the core subsystems. Every benchmark runs over a sweep
+// of sizes and prints one CSV row per size: the median time per call and its
+// spread over SAMPLE_COUNT samples, in nanoseconds.
+//
+// usage: bench_suite [--output FILE] [--baseline FILE] [--threshold PERCENT]
+//
+// --output also writes the rows to FILE. --baseline compares each median
+// against a file written that way and exits with 1 if any grew by more than
+// the threshold, 10% unless given.
+//
+// The suite is built against the stress caps (see the Makefile), so
+// simulation sizes run up to what the stress scenario holds: MAX_SHIPS ships,
+// MAX_PROJECTILES projectiles, and MAX_BUILDINGS buildings.
+//
+
+#define SAMPLE_COUNT       15
+#define MAX_BENCH_RESULTS  256
+#define DEFAULT_THRESHOLD  10.0
+
+// Ticks simulated per sample, from the same starting state every time.
+#define BENCH_TICK_COUNT 16
+#define BENCH_TICK_DT    (1.0f / 30.0f)
+
+#define BENCH_PATH_COUNT 64
+
+// Building queries per sample, for the occupancy grid comparisons.
+#define BENCH_QUERY_COUNT 1024
+
+struct BenchResult
+{
+    char name[48];
+    uint32 size;
+
+    double median;
+    double deviation; // median absolute deviation
+    double min;
+    double max;
+};
+
+struct BenchSuite
+{
+    FILE *output;
+
+    struct BenchResult results[MAX_BENCH_RESULTS];
+    uint32 result_count;
+};
+
+// What a benchmark runs on.
+struct BenchContext
+{
+    struct GameMemory memory;
+    struct GameState *game_state;
+    struct GameState *saved_state;
+
+    uint32 size;
+
+    vec2 path_points[BENCH_PATH_COUNT][2];
+    vec2 segments[BENCH_QUERY_COUNT][2];
+    struct AABB query_aabbs[BENCH_QUERY_COUNT];
+    uint32 *keys;
+    struct SpriteBatch sprite_batch;
+    float sink;
+};
+
+typedef void bench_function(struct BenchContext *context);
+
+// Where place_entities puts ships.
+enum BenchLayout
+{
+    // Anywhere on the map.
+    BENCH_LAYOUT_UNIFORM,
+    // A few dense clumps, as ships gather in battle.
+    BENCH_LAYOUT_CLUSTERED,
+
+    BENCH_LAYOUT_COUNT,
+};
+
+#define BENCH_CLUSTER_COUNT 4
+
+// Testing every pair of this many ships already takes seconds a sample.
+#define BENCH_BRUTE_FORCE_MAX_SHIPS 2048
+
+static double get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x < y) ? -1 : (x > y);
+}
+
+// 'prepare' runs untimed before every sample; 'calls' is how many calls of
+// the measured operation one sample makes.
+static void run_benchmark(struct BenchSuite *suite, const char *name, struct BenchContext *context, bench_function *prepare, bench_function *run, uint32 calls)
+{
+    double samples[SAMPLE_COUNT + 1];
+
+    // The first sample warms caches and is dropped.
+    for (uint32 i = 0; i < SAMPLE_COUNT + 1; ++i)
+    {
+        if (prepare)
+            prepare(context);
+
+        double start = get_time();
+        run(context);
+        samples[i] = (get_time() - start) * 1e9 / (double)calls;
+    }
+
+    double *kept = &samples[1];
+    qsort(kept, SAMPLE_COUNT, sizeof(double), compare_double);
+
+    ASSERT(suite->result_count < MAX_BENCH_RESULTS);
+    struct BenchResult *result = &suite->results[suite->result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->size = context->size;
+    result->median = kept[SAMPLE_COUNT / 2];
+    result->min = kept[0];
+    result->max = kept[SAMPLE_COUNT - 1];
+
+    double deviations[SAMPLE_COUNT];
+    for (uint32 i = 0; i < SAMPLE_COUNT; ++i)
+        deviations[i] = (kept[i] > result->median) ? kept[i] - result->median : result->median - kept[i];
+    qsort(deviations, SAMPLE_COUNT, sizeof(double), compare_double);
+    result->deviation = deviations[SAMPLE_COUNT / 2];
+
+    const char *format = "%s,%u,%.1f,%.1f,%.1f,%.1f\n";
+    fprintf(stdout, format, result->name, result->size, result->median, result->deviation, result->min, result->max);
+    if (suite->output)
+        fprintf(suite->output, format, result->name, result->size, result->median, result->deviation, result->min, result->max);
+}
+
+
+//
+// game state
+//
+
+// init_game and the map queries report everything they build.
+static void run_quietly(bench_function *function, struct BenchContext *context)
+{
+    fflush(stderr);
+    int saved = dup(STDERR_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDERR_FILENO);
+    close(null);
+
+    function(context);
+
+    fflush(stderr);
+    dup2(saved, STDERR_FILENO);
+    close(saved);
+}
+
+static void init_bench_game(struct BenchContext *context)
+{
+    struct GameConfig config = {0};
+    config.seed = 23932487;
+    config.worker_count = 1;
+
+    init_game(&context->memory, &config);
+    context->game_state = (struct GameState *)context->memory.game_memory;
+}
+
+// calc_visibility_graph expects the zeroed graph a new game starts with.
+static void clear_visibility_graph(struct BenchContext *context)
+{
+    struct VisibilityGraph *graph = &context->game_state->visibility_graph;
+    for (uint32 i = 0; i < graph->node_count; ++i)
+        graph->nodes[i].neighbor_index_count = 0;
+}
+
+static void rebuild_visibility_graph(struct BenchContext *context)
+{
+    calc_visibility_graph(context->game_state, &context->game_state->visibility_graph);
+}
+
+static void rebuild_map(struct BenchContext *context)
+{
+    build_building_queries(context->game_state);
+    clear_visibility_graph(context);
+    rebuild_visibility_graph(context);
+}
+
+static void place_buildings(struct BenchContext *context, uint32 count)
+{
+    ASSERT(count <= MAX_BUILDINGS);
+
+    struct GameState *game_state = context->game_state;
+    game_state->building_count = 0;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        struct Building *building = create_building(game_state);
+        building->position = vec2_new(random_int(-28, 28), random_int(-28, 28));
+        building->size = vec2_new(2, 2);
+    }
+
+    run_quietly(rebuild_map, context);
+}
+
+// Half the side of the square uniform layouts spread over. Up to 64 ships it
+// is the +-30 map; larger counts keep that density and spread past it.
+static float uniform_extent(uint32 ship_count)
+{
+    return 30.0f * max_float(sqrt_float((float)ship_count / 64.0f), 1.0f);
+}
+
+// 'ship_count' ships on alternating teams, all active and drifting, plus
+// 'projectile_count' projectiles in flight. Clustered ships are packed about
+// as densely as a formation.
+static void place_entities(struct GameState *game_state, uint32 ship_count, uint32 projectile_count, enum BenchLayout layout, enum BroadphaseType broadphase_type)
+{
+    ASSERT((ship_count <= MAX_SHIPS) && (projectile_count <= MAX_PROJECTILES));
+
+    game_state->ship_count = 0;
+    game_state->projectile_count = 0;
+    game_state->ship_id_map = create_uint_hash_map();
+    init_broadphase(&game_state->ship_broadphase, broadphase_type, 4.0f);
+
+    vec2 cluster_centers[BENCH_CLUSTER_COUNT];
+    for (uint32 i = 0; i < BENCH_CLUSTER_COUNT; ++i)
+        cluster_centers[i] = vec2_new(random_float(-20.0f, 20.0f), random_float(-20.0f, 20.0f));
+    float cluster_radius = FORMATION_SPACING * sqrt_float((float)ship_count / BENCH_CLUSTER_COUNT) / 2.0f;
+    float extent = uniform_extent(ship_count);
+
+    for (uint32 i = 0; i < ship_count; ++i)
+    {
+        struct Ship *ship = create_ship(game_state);
+        ship->team = (i % 2) ? TEAM_ENEMY : TEAM_ALLY;
+        if (layout == BENCH_LAYOUT_CLUSTERED)
+            ship->position = vec2_add(cluster_centers[i % BENCH_CLUSTER_COUNT], vec2_new(random_float(-cluster_radius, cluster_radius), random_float(-cluster_radius, cluster_radius)));
+        else
+            ship->position = vec2_new(random_float(-extent, extent), random_float(-extent, extent));
+        ship->size = vec2_new(1, 1);
+        ship->move_velocity = vec2_new(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f));
+        ship->health = 1000;
+        ship->fire_cooldown = 2.0f;
+        ship->tier = TIER_ACTIVE;
+        ship->step_dt = BENCH_TICK_DT;
+
+        // create_ship registered the proxy before the ship was placed.
+        move_broadphase_proxy(&game_state->ship_broadphase, ship->broadphase_proxy, aabb_from_transform(ship->position, ship->size));
+    }
+
+    for (uint32 i = 0; i < projectile_count; ++i)
+    {
+        struct Projectile *projectile = create_projectile(game_state);
+        projectile->owner = UINT32_MAX;
+        projectile->team = TEAM_ENEMY;
+        projectile->damage = 1;
+        projectile->position = vec2_new(random_float(-extent, extent), random_float(-extent, extent));
+        projectile->size = vec2_new(0.1f, 0.1f);
+        projectile->velocity = vec2_mul(vec2_normalize(vec2_new(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f))), 5.0f);
+        projectile->lifetime = PROJECTILE_LIFETIME;
+    }
+
+    // Sweep and prune sorts new proxies in on their first update, which is
+    // quadratic. Doing it here keeps it out of every sample.
+    update_broadphase(&game_state->ship_broadphase);
+}
+
+static void save_game_state(struct BenchContext *context)
+{
+    memcpy(context->saved_state, context->game_state, sizeof(struct GameState));
+}
+
+static void restore_game_state(struct BenchContext *context)
+{
+    memcpy(context->game_state, context->saved_state, sizeof(struct GameState));
+}
+
+
+//
+// benchmarks
+//
+
+static void run_find_path(struct BenchContext *context)
+{
+    struct GameState *game_state = context->game_state;
+    uint32 expanded_count = 0;
+    for (uint32 i = 0; i < BENCH_PATH_COUNT; ++i)
+    {
+        struct Path path = find_path(&game_state->visibility_graph, context->path_points[i][0], context->path_points[i][1], &context->memory.transient_arena, &expanded_count);
+        context->sink += (float)path.node_count;
+    }
+}
+
+static void run_calc_visibility_graph(struct BenchContext *context)
+{
+    run_quietly(rebuild_visibility_graph, context);
+}
+
+static void run_tick_physics(struct BenchContext *context)
+{
+    for (uint32 i = 0; i < BENCH_TICK_COUNT; ++i)
+        tick_physics(context->game_state, BENCH_TICK_DT, &context->memory.transient_arena);
+}
+
+// The occupancy grid as an early-out in front of the BVH, against the BVH
+// alone, on the queries the game makes: unpadded segments between
+// visibility graph vertices and projectile-sized boxes.
+static void run_segment_bvh(struct BenchContext *context)
+{
+    struct GameState *game_state = context->game_state;
+    for (uint32 i = 0; i < BENCH_QUERY_COUNT; ++i)
+        context->sink += (float)bvh_segment_blocked(&game_state->building_bvh, context->segments[i][0], context->segments[i][1], 0.0f);
+}
+
+static void run_segment_grid_bvh(struct BenchContext *context)
+{
+    struct GameState *game_state = context->game_state;
+    for (uint32 i = 0; i < BENCH_QUERY_COUNT; ++i)
+    {
+        bool blocked = !occupancy_segment_clear(&game_state->building_occupancy, context->segments[i][0], context->segments[i][1]) &&
+                       bvh_segment_blocked(&game_state->building_bvh, context->segments[i][0], context->segments[i][1], 0.0f);
+        context->sink += (float)blocked;
+    }
+}
+
+static void run_aabb_bvh(struct BenchContext *context)
+{
+    struct GameState *game_state = context->game_state;
+    uint32 building_index;
+    for (uint32 i = 0; i < BENCH_QUERY_COUNT; ++i)
+        context->sink += (float)bvh_overlap_aabb(&game_state->building_bvh, context->query_aabbs[i], &building_index, 1);
+}
+
+static void run_aabb_grid_bvh(struct BenchContext *context)
+{
+    struct GameState *game_state = context->game_state;
+    uint32 building_index;
+    for (uint32 i = 0; i < BENCH_QUERY_COUNT; ++i)
+    {
+        if (!occupancy_aabb_clear(&game_state->building_occupancy, context->query_aabbs[i]))
+            context->sink += (float)bvh_overlap_aabb(&game_state->building_bvh, context->query_aabbs[i], &building_index, 1);
+    }
+}
+
+// Moves the ships and updates the broadphase, as tick_physics does, without
+// resolving anything.
+static void run_broadphase(struct BenchContext *context)
+{
+    struct GameState *game_state = context->game_state;
+    struct Broadphase *broadphase = &game_state->ship_broadphase;
+
+    for (uint32 i = 0; i < BENCH_TICK_COUNT; ++i)
+    {
+        for (uint32 j = 0; j < game_state->ship_count; ++j)
+        {
+            struct Ship *ship = &game_state->ships[j];
+            ship->position = vec2_add(ship->position, vec2_mul(ship->move_velocity, BENCH_TICK_DT));
+            move_broadphase_proxy(broadphase, ship->broadphase_proxy, aabb_from_transform(ship->position, ship->size));
+        }
+
+        update_broadphase(broadphase);
+        context->sink += (float)broadphase->pair_count;
+    }
+}
+
+static void run_tick_combat(struct BenchContext *context)
+{
+    // Projectiles fired here would pile up, so each tick starts without them.
+    // The ship grid is rebuilt every tick, as tick_game does.
+    struct MemoryArena *arena = &context->memory.transient_arena;
+    for (uint32 i = 0; i < BENCH_TICK_COUNT; ++i)
+    {
+        context->game_state->projectile_count = 0;
+
+        struct TempArena ship_grid_memory = begin_temp_arena(arena);
+        struct ShipGrid ship_grid;
+        build_ship_grid(context->game_state, &ship_grid, arena);
+        tick_combat(context->game_state, &ship_grid, BENCH_TICK_DT);
+        end_temp_arena(ship_grid_memory);
+    }
+}
+
+static void clear_hash_map(struct BenchContext *context)
+{
+    context->game_state->ship_id_map = create_uint_hash_map();
+}
+
+static void run_hash_map(struct BenchContext *context)
+{
+    struct UIntHashMap *map = &context->game_state->ship_id_map;
+
+    for (uint32 i = 0; i < context->size; ++i)
+        emplace(map, context->keys[i], i);
+    for (uint32 i = 0; i < context->size; ++i)
+        context->sink += (float)find_pair(map, context->keys[i])->value;
+    for (uint32 i = 0; i < context->size; ++i)
+        remove_pair(map, context->keys[i]);
+}
+
+static void run_mat4_mul(struct BenchContext *context)
+{
+    mat4 result = mat4_identity();
+    mat4 step = mat4_translate(mat4_identity(), vec3_new(0.001f, 0.002f, 0.0f));
+    for (uint32 i = 0; i < context->size; ++i)
+        result = mat4_mul(result, step);
+
+    context->sink += result.m[12];
+}
+
+static void run_draw_quad(struct BenchContext *context)
+{
+    struct SpriteBatch *batch = &context->sprite_batch;
+    batch->current_quad_count = 0;
+
+    for (uint32 i = 0; i < context->size; ++i)
+        draw_quad(batch, vec2_new((float)(i % 256), (float)(i / 256)), vec2_new(1, 1), vec3_new(1, 1, 1));
+
+    context->sink += batch->data[0].position.x;
+}
+
+static void run_fractal_noise(struct BenchContext *context)
+{
+    for (uint32 i = 0; i < context->size; ++i)
+        context->sink += fractal_noise((float)(i % 256) * 0.1f, (float)(i / 256) * 0.1f, 0.0f, 4, 0.05f, 0.5f);
+}
+
+
+//
+// baseline comparison
+//
+
+static uint32 read_bench_results(const char *path, struct BenchResult *results, uint32 capacity)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "[ERROR] Failed to open baseline '%s'.\n", path);
+        return 0;
+    }
+
+    uint32 count = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) && (count < capacity))
+    {
+        struct BenchResult *result = &results[count];
+        if (sscanf(line, "%47[^,],%u,%lf,%lf,%lf,%lf", result->name, &result->size, &result->median, &result->deviation, &result->min, &result->max) == 6)
+            ++count;
+    }
+
+    fclose(file);
+    return count;
+}
+
+// Returns the number of regressions.
+static uint32 compare_bench_results(struct BenchSuite *suite, const char *baseline_path, double threshold)
+{
+    static struct BenchResult baseline[MAX_BENCH_RESULTS];
+    uint32 baseline_count = read_bench_results(baseline_path, baseline, ARRAY_SIZE(baseline));
+    if (baseline_count == 0)
+        return 1;
+
+    uint32 regression_count = 0;
+    for (uint32 i = 0; i < suite->result_count; ++i)
+    {
+        struct BenchResult *result = &suite->results[i];
+        for (uint32 j = 0; j < baseline_count; ++j)
+        {
+            struct BenchResult *base = &baseline[j];
+            if (strcmp(base->name, result->name) || (base->size != result->size) || (base->median <= 0.0))
+                continue;
+
+            double change = (result->median / base->median - 1.0) * 100.0;
+            if (change > threshold)
+            {
+                fprintf(stderr, "Regression: %s at %u is %.1f%% slower (%.1f ns, was %.1f ns).\n",
+                        result->name, result->size, change, result->median, base->median);
+                ++regression_count;
+            }
+            break;
+        }
+    }
+
+    fprintf(stderr, "%u of %u benchmarks regressed by more than %.1f%% against '%s'.\n",
+            regression_count, suite->result_count, threshold, baseline_path);
+    return regression_count;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *output_path = NULL;
+    const char *baseline_path = NULL;
+    double threshold = DEFAULT_THRESHOLD;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--output") && (i + 1 < argc))
+        {
+            output_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--baseline") && (i + 1 < argc))
+        {
+            baseline_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--threshold") && (i + 1 < argc))
+        {
+            threshold = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--output FILE] [--baseline FILE] [--threshold PERCENT]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    static struct BenchSuite suite;
+    if (output_path)
+    {
+        suite.output = fopen(output_path, "w");
+        if (!suite.output)
+        {
+            fprintf(stderr, "[ERROR] Failed to open '%s' for writing.\n", output_path);
+            return 1;
+        }
+
+        fprintf(suite.output, "benchmark,size,median_ns,deviation_ns,min_ns,max_ns\n");
+    }
+
+    fprintf(stdout, "benchmark,size,median_ns,deviation_ns,min_ns,max_ns\n");
+
+    init_random(23932487);
+
+    // Game memory laid out like allocate_game_memory() does, minus the mapping.
+    static struct BenchContext context;
+    size_t permanent_size = sizeof(struct GameState) + KILOBYTES(4);
+    size_t transient_size = GAME_TRANSIENT_SIZE;
+    context.memory.game_memory_size = permanent_size + transient_size;
+    context.memory.game_memory = aligned_alloc(KILOBYTES(4), context.memory.game_memory_size);
+    context.saved_state = malloc(sizeof(struct GameState));
+    ASSERT(context.memory.game_memory && context.saved_state);
+
+    init_arena(&context.memory.permanent_arena, "permanent", context.memory.game_memory, permanent_size);
+    init_arena(&context.memory.transient_arena, "transient", (uint8 *)context.memory.game_memory + permanent_size, transient_size);
+
+    run_quietly(init_bench_game, &context);
+
+    const uint32 building_counts[] = { 1, 4, 16, 64, MAX_BUILDINGS };
+    for (uint32 i = 0; i < ARRAY_SIZE(building_counts); ++i)
+    {
+        context.size = building_counts[i];
+        place_buildings(&context, context.size);
+        run_benchmark(&suite, "calc_visibility_graph", &context, clear_visibility_graph, run_calc_visibility_graph, 1);
+
+        for (uint32 j = 0; j < BENCH_PATH_COUNT; ++j)
+        {
+            context.path_points[j][0] = vec2_new(random_float(-30.0f, 30.0f), random_float(-30.0f, 30.0f));
+            context.path_points[j][1] = vec2_new(random_float(-30.0f, 30.0f), random_float(-30.0f, 30.0f));
+        }
+        run_benchmark(&suite, "find_path", &context, NULL, run_find_path, BENCH_PATH_COUNT);
+
+        struct VisibilityGraph *graph = &context.game_state->visibility_graph;
+        for (uint32 j = 0; j < BENCH_QUERY_COUNT; ++j)
+        {
+            context.segments[j][0] = graph->vertices[random_int(0, (int32)graph->vertex_count - 1)];
+            context.segments[j][1] = graph->vertices[random_int(0, (int32)graph->vertex_count - 1)];
+            context.query_aabbs[j] = aabb_from_transform(vec2_new(random_float(-30.0f, 30.0f), random_float(-30.0f, 30.0f)), vec2_new(0.1f, 0.1f));
+        }
+        run_benchmark(&suite, "segment_bvh", &context, NULL, run_segment_bvh, BENCH_QUERY_COUNT);
+        run_benchmark(&suite, "segment_grid_bvh", &context, NULL, run_segment_grid_bvh, BENCH_QUERY_COUNT);
+        run_benchmark(&suite, "aabb_bvh", &context, NULL, run_aabb_bvh, BENCH_QUERY_COUNT);
+        run_benchmark(&suite, "aabb_grid_bvh", &context, NULL, run_aabb_grid_bvh, BENCH_QUERY_COUNT);
+    }
+
+    // A fifth of the entities are ships, the rest projectiles.
+    place_buildings(&context, 4);
+    const uint32 entity_counts[] = { 10, 40, 160, 640, 2560, 10240, 40960, MAX_SHIPS + MAX_PROJECTILES };
+    for (uint32 i = 0; i < ARRAY_SIZE(entity_counts); ++i)
+    {
+        context.size = entity_counts[i];
+        uint32 ship_count = min_uint32(context.size / 5, MAX_SHIPS);
+        place_entities(context.game_state, ship_count, min_uint32(context.size - ship_count, MAX_PROJECTILES), BENCH_LAYOUT_UNIFORM, BROADPHASE_SWEEP_AND_PRUNE);
+        save_game_state(&context);
+        run_benchmark(&suite, "tick_physics", &context, restore_game_state, run_tick_physics, BENCH_TICK_COUNT);
+    }
+
+    const uint32 ship_counts[] = { 2, 8, 32, 128, 512, 2048, 8192, MAX_SHIPS };
+    for (uint32 i = 0; i < ARRAY_SIZE(ship_counts); ++i)
+    {
+        context.size = ship_counts[i];
+        place_entities(context.game_state, context.size, 0, BENCH_LAYOUT_UNIFORM, BROADPHASE_SWEEP_AND_PRUNE);
+        save_game_state(&context);
+        run_benchmark(&suite, "tick_combat", &context, restore_game_state, run_tick_combat, BENCH_TICK_COUNT);
+    }
+
+    // Every backend on the same ships.
+    static const char *layout_names[BENCH_LAYOUT_COUNT] = { "uniform", "clustered" };
+    for (uint32 layout = 0; layout < BENCH_LAYOUT_COUNT; ++layout)
+    {
+        for (uint32 type = 0; type < BROADPHASE_TYPE_COUNT; ++type)
+        {
+            char name[48];
+            snprintf(name, sizeof(name), "broadphase_%s_%s", broadphase_type_name((enum BroadphaseType)type), layout_names[layout]);
+
+            for (uint32 i = 0; i < ARRAY_SIZE(ship_counts); ++i)
+            {
+                if ((type == BROADPHASE_BRUTE_FORCE) && (ship_counts[i] > BENCH_BRUTE_FORCE_MAX_SHIPS))
+                    continue;
+
+                context.size = ship_counts[i];
+                place_entities(context.game_state, context.size, 0, (enum BenchLayout)layout, (enum BroadphaseType)type);
+                save_game_state(&context);
+                run_benchmark(&suite, name, &context, restore_game_state, run_broadphase, BENCH_TICK_COUNT);
+            }
+        }
+    }
+
+    // Ship IDs are handed out in order. Stays under 3/4 of the buckets.
+    const uint32 key_counts[] = { 10, 100, 1000, 10000, MAX_SHIPS };
+    context.keys = malloc(MAX_SHIPS * sizeof(uint32));
+    ASSERT(context.keys);
+    for (uint32 i = 0; i < MAX_SHIPS; ++i)
+        context.keys[i] = 1000 + i;
+    for (uint32 i = 0; i < ARRAY_SIZE(key_counts); ++i)
+    {
+        context.size = key_counts[i];
+        run_benchmark(&suite, "uint_hash_map", &context, clear_hash_map, run_hash_map, 3 * context.size);
+    }
+
+    // Vertex generation needs no GL until the batch is flushed, which the
+    // capacity avoids.
+    const uint32 item_counts[] = { 10, 100, 1000, 10000, 100000 };
+    uint32 max_item_count = item_counts[ARRAY_SIZE(item_counts) - 1];
+    context.sprite_batch.max_quad_count = max_item_count + 2;
+    context.sprite_batch.data = malloc(context.sprite_batch.max_quad_count * 4 * sizeof(struct SpriteVertex));
+    context.sprite_batch.drawing = true;
+    ASSERT(context.sprite_batch.data);
+
+    for (uint32 i = 0; i < ARRAY_SIZE(item_counts); ++i)
+    {
+        context.size = item_counts[i];
+        run_benchmark(&suite, "mat4_mul", &context, NULL, run_mat4_mul, context.size);
+        run_benchmark(&suite, "draw_quad", &context, NULL, run_draw_quad, context.size);
+        run_benchmark(&suite, "fractal_noise", &context, NULL, run_fractal_noise, context.size);
+    }
+
+    int result = 0;
+    if (baseline_path && (compare_bench_results(&suite, baseline_path, threshold) > 0))
+        result = 1;
+
+    if (suite.output)
+        fclose(suite.output);
+
+    free(context.sprite_batch.data);
+    free(context.keys);
+    free(context.saved_state);
+    free(context.memory.game_memory);
+
+    // Keeps the results above from being optimized away.
+    return (context.sink == 12345.0f) ? 2 : result;
+}
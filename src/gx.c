@@ -1,9 +1,47 @@
 #include "gx.h"
 #include "gx_io.h"
+#include "gx_point_grid.h"
+#include "gx_profile.h"
 #include "gx_renderer.h"
 
+#include <string.h>
+
 #define NULL_UINT_HASH_KEY UINT32_MAX
 
+// Ships and projectiles are re-sorted by Morton key every N ticks, or sooner
+// once swap-removes have shuffled more than 1/N of them.
+#define SPATIAL_SORT_INTERVAL 120
+#define SPATIAL_SORT_REMOVAL_FRACTION 4
+
+#define PROJECTILE_LIFETIME 10.0f
+
+// Below this many buildings the BVH alone answers a projectile query faster
+// than with the occupancy grid in front of it (aabb_bvh against
+// aabb_grid_bvh in bench_suite).
+#define OCCUPANCY_MIN_BUILDINGS 16
+
+// Seconds between shots. Cannons are what every ship carried before
+// scenarios; repeaters fill the sky for the projectile-heavy ones.
+#define CANNON_FIRE_COOLDOWN   2.0f
+#define REPEATER_FIRE_COOLDOWN 0.25f
+
+// Buildings and the visibility graph's border stay within +-MAP_EXTENT.
+// Formations may reach past it.
+#define MAP_EXTENT        32
+#define FORMATION_SPACING 2.0f
+
+// Simulation LOD, see enum SimulationTier. The interval is kept small
+// enough that a distant ship's longer step cannot jump over a path node: at
+// 30 Hz a step covers 2 units/s * 4/30 s = 0.27 units, less than the 0.63
+// unit wide arrival circle.
+#define DISTANT_TICK_INTERVAL 4
+#define SLEEP_DELAY_TICKS     30
+// Ships this far outside the view still count as on screen.
+#define ON_SCREEN_MARGIN      4.0f
+
+// About two ship lengths, so a collision query touches a handful of cells.
+#define SHIP_GRID_CELL_SIZE 4.0f
+
 static struct UIntHashMap create_uint_hash_map()
 {
     struct UIntHashMap map = {0};
@@ -80,85 +118,6 @@ static void remove_pair(struct UIntHashMap *map, uint32 key)
     pair->value = 0;
 }
 
-static struct AABB aabb_from_transform(vec2 center, vec2 size)
-{
-    vec2 half_size = vec2_div(size, 2.0f);
-
-    struct AABB aabb;
-    aabb.min = vec2_sub(center, half_size);
-    aabb.max = vec2_add(center, half_size);
-    return aabb;
-}
-
-static bool aabb_aabb_intersection(struct AABB a, struct AABB b)
-{
-    if ((a.max.x > b.min.x) && (a.min.x < b.max.x))
-    {
-        if ((a.max.y > b.min.y) && (a.min.y < b.max.y))
-            return true;
-    }
-
-    return false;
-}
-
-static bool line_line_intersection(vec2 a0, vec2 a1, vec2 b0, vec2 b1)
-{
-#if 1
-    // Implemented based on http://stackoverflow.com/a/17198094/4354008
-    vec2 v = vec2_sub(a0, a1);
-    vec2 normal = vec2_new(v.y, -v.x);
-
-    vec2 v0 = vec2_sub(b0, a0);
-    vec2 v1 = vec2_sub(b1, a0);
-
-    float proj0 = vec2_dot(v0, normal);
-    float proj1 = vec2_dot(v1, normal);
-
-    if ((proj0 == 0) || (proj1 == 0))
-        return true;
-
-    // TODO: float_sign()
-    if ((proj0 > 0) && (proj1 < 0))
-        return true;
-    if ((proj0 < 0) && (proj1 > 0))
-        return true;
-
-    return false;
-#else
-    vec2 intersection = vec2_zero();
-
-    vec2 b = vec2_sub(a1, a0);
-    vec2 d = vec2_sub(b1, b0);
-    float b_dot_p_perp = (b.x * d.y) - (b.y * d.x);
-
-    if (b_dot_p_perp == 0)
-        return false;
-
-    vec2 c = vec2_sub(b0, a0);
-    float t = ((c.x * d.y) - (c.y * d.x)) / b_dot_p_perp;
-    if ((t < 0) || (t > 1))
-        return false;
-
-    float u = ((c.x * b.y) - (c.y * b.x)) / b_dot_p_perp;
-    if ((u < 0) || (u > 1))
-        return false;
-
-    // TODO: make this an output parameter
-    intersection = vec2_add(a0, vec2_mul(b, t));
-
-    return true;
-#endif
-}
-
-static bool line_aabb_intersection(struct AABB aabb, vec2 line_start, vec2 line_end)
-{
-    // TODO: optimize?
-    return (line_line_intersection(line_start, line_end, vec2_new(aabb.min.x, aabb.min.y), vec2_new(aabb.max.x, aabb.min.y)) ||
-            line_line_intersection(line_start, line_end, vec2_new(aabb.max.x, aabb.min.y), vec2_new(aabb.max.x, aabb.max.y)) ||
-            line_line_intersection(line_start, line_end, vec2_new(aabb.max.x, aabb.max.y), vec2_new(aabb.min.x, aabb.max.y)) ||
-            line_line_intersection(line_start, line_end, vec2_new(aabb.min.x, aabb.max.y), vec2_new(aabb.min.x, aabb.min.y)));
-}
-
 static void tick_camera(struct Input *input, struct Camera *camera, float dt)
 {
     //
@@ -188,7 +147,7 @@ static void tick_camera(struct Input *input, struct Camera *camera, float dt)
         camera->move_velocity = vec2_add(camera->move_velocity, vec2_mul(move_acceleration, dt));
 
         // Clamp move velocity.
-        const float max_move_speed = 5.0f * sqrtf(camera->zoom);
+        const float max_move_speed = 5.0f * sqrt_float(camera->zoom);
         if (vec2_length2(camera->move_velocity) > (max_move_speed * max_move_speed))
             camera->move_velocity = vec2_mul(vec2_normalize(camera->move_velocity), max_move_speed);
     }
@@ -267,23 +226,53 @@ static struct Ship *create_ship(struct GameState *game_state)
     uint32 array_index = game_state->ship_count;
     ++game_state->ship_count;
 
+    // Slots are reused, so clear whatever the previous occupant left behind.
     struct Ship *ship = &game_state->ships[array_index];
+    memset(ship, 0, sizeof(*ship));
     ship->id = generate_ship_id(game_state);
 
     emplace(&game_state->ship_id_map, ship->id, array_index);
 
+    struct AABB aabb = aabb_from_transform(ship->position, ship->size);
+    ship->broadphase_proxy = create_broadphase_proxy(&game_state->ship_broadphase, aabb, ship->id);
+
     return ship;
 }
 
+// Everything but taking the ship out of the array: its id, proxy and selection.
+static void release_ship(struct GameState *game_state, struct Ship *ship)
+{
+    remove_pair(&game_state->ship_id_map, ship->id);
+    destroy_broadphase_proxy(&game_state->ship_broadphase, ship->broadphase_proxy);
+
+    // Drop the ship from the selection, keeping the order of the rest.
+    for (uint32 i = 0; i < game_state->selected_ship_count; ++i)
+    {
+        if (game_state->selected_ships[i] != ship->id)
+            continue;
+
+        --game_state->selected_ship_count;
+        memmove(&game_state->selected_ships[i], &game_state->selected_ships[i + 1],
+                (game_state->selected_ship_count - i) * sizeof(game_state->selected_ships[0]));
+        break;
+    }
+
+    ++game_state->removals_since_spatial_sort;
+}
+
+// Swap-removes the ship. Deterministic games keep creation order instead,
+// see destroy_dead_ships.
 static void destroy_ship(struct GameState *game_state, struct Ship *ship)
 {
+    ASSERT(!game_state->deterministic);
+
     struct UIntHashPair *pair = find_pair(&game_state->ship_id_map, ship->id);
     ASSERT_NOT_NULL(pair);
 
     uint32 array_index = pair->value;
     ASSERT(array_index < game_state->ship_count);
 
-    remove_pair(&game_state->ship_id_map, ship->id);
+    release_ship(game_state, ship);
 
     // Ship is already at the end of the array.
     if (array_index == game_state->ship_count - 1)
@@ -304,61 +293,71 @@ static void destroy_ship(struct GameState *game_state, struct Ship *ship)
     last_pair->value = array_index;
 }
 
-static void damage_ship(struct GameState *game_state, struct Ship *ship, int32 damage)
+// Removes the dead ships in one stable pass, keeping creation order, and
+// points the id map at each survivor's new index as it moves.
+static void destroy_dead_ships(struct GameState *game_state, struct ShipDeathEvent *deaths, uint32 death_count, struct MemoryArena *scratch)
 {
-    ship->health -= damage;
+    ASSERT(game_state->deterministic);
+    if (death_count == 0)
+        return;
 
-    if (ship->health <= 0)
-        destroy_ship(game_state, ship);
-}
+    bool *dead = push_array(scratch, bool, game_state->ship_count);
+    uint32 first_dead = game_state->ship_count;
+    for (uint32 i = 0; i < death_count; ++i)
+    {
+        struct UIntHashPair *pair = find_pair(&game_state->ship_id_map, deaths[i].ship_id);
+        ASSERT_NOT_NULL(pair);
 
-static struct Ship *find_nearest_enemy(struct GameState *game_state, struct Ship *ship)
-{
-    struct Ship *nearest = NULL;
-    float min_distance = FLOAT_MAX;
+        uint32 array_index = pair->value;
+        ASSERT(array_index < game_state->ship_count);
 
-    for (uint32 i = 0; i < game_state->ship_count; ++i)
+        dead[array_index] = true;
+        first_dead = min_uint32(first_dead, array_index);
+        release_ship(game_state, &game_state->ships[array_index]);
+    }
+
+    uint32 kept = first_dead;
+    for (uint32 i = first_dead; i < game_state->ship_count; ++i)
     {
-        struct Ship *candidate = &game_state->ships[i];
-        if (candidate->team == ship->team)
+        if (dead[i])
             continue;
 
-        float distance = vec2_distance2(candidate->position, ship->position);
-        if (distance < min_distance)
-        {
-            nearest = candidate;
-            min_distance = distance;
-        }
+        game_state->ships[kept] = game_state->ships[i];
+
+        struct UIntHashPair *pair = find_pair(&game_state->ship_id_map, game_state->ships[kept].id);
+        ASSERT_NOT_NULL(pair);
+        pair->value = kept;
+        ++kept;
     }
 
-    return nearest;
+    game_state->ship_count = kept;
 }
 
 static struct Projectile *create_projectile(struct GameState *game_state)
 {
     ASSERT(game_state->projectile_count < ARRAY_SIZE(game_state->projectiles));
     struct Projectile *projectile = &game_state->projectiles[game_state->projectile_count++];
+    memset(projectile, 0, sizeof(*projectile));
     return projectile;
 }
 
-static void destroy_projectile(struct GameState *game_state, struct Projectile *projectile)
+static void destroy_projectile(struct GameState *game_state, uint32 index)
 {
-    ASSERT(game_state->projectile_count > 0);
+    ASSERT(index < game_state->projectile_count);
 
-    // TODO: optimize if needed!
-    for (uint32 i = 0; i < game_state->projectile_count; ++i)
-    {
-        if (&game_state->projectiles[i] == projectile)
-        {
-            // Swap the projectile with the last active item in the array.
-            struct Projectile last = game_state->projectiles[game_state->projectile_count - 1];
-            game_state->projectiles[i] = last;
-
-            --game_state->projectile_count;
+    --game_state->projectile_count;
+    ++game_state->removals_since_spatial_sort;
 
-            return;
-        }
+    if (game_state->deterministic)
+    {
+        // Keep creation order.
+        memmove(&game_state->projectiles[index], &game_state->projectiles[index + 1],
+                (game_state->projectile_count - index) * sizeof(struct Projectile));
+        return;
     }
+
+    // Swap the projectile with the last active item in the array.
+    game_state->projectiles[index] = game_state->projectiles[game_state->projectile_count];
 }
 
 static void fire_projectile(struct GameState *game_state, struct Ship *source, struct Ship *target, int32 damage)
@@ -374,7 +373,9 @@ static void fire_projectile(struct GameState *game_state, struct Ship *source, s
     projectile->damage = damage;
 
     projectile->position = source->position;
+    projectile->previous_position = projectile->position;
     projectile->size = vec2_new(0.1f, 0.1f);
+    projectile->lifetime = PROJECTILE_LIFETIME;
 
     vec2 direction = vec2_normalize(vec2_sub(target->position, projectile->position));
     projectile->velocity = vec2_mul(direction, 5.0f);
@@ -391,18 +392,25 @@ static struct Building *create_building(struct GameState *game_state)
     return building;
 }
 
-static bool is_visible(struct GameState *game_state, vec2 start, vec2 end, float edge_padding)
+static void build_building_queries(struct GameState *game_state)
 {
+    struct AABB aabbs[ARRAY_SIZE(game_state->buildings)];
     for (uint32 i = 0; i < game_state->building_count; ++i)
     {
         struct Building *building = &game_state->buildings[i];
-        struct AABB aabb = aabb_from_transform(building->position, vec2_add(building->size, vec2_scalar(edge_padding)));
-
-        if (line_aabb_intersection(aabb, start, end))
-            return false;
+        aabbs[i] = aabb_from_transform(building->position, building->size);
     }
 
-    return true;
+    build_bvh(&game_state->building_bvh, aabbs, game_state->building_count);
+    build_occupancy_grid(&game_state->building_occupancy, aabbs, game_state->building_count, vec2_new(-64.0f, -64.0f), 0.25f);
+}
+
+// The occupancy grid is no early-out here: walking a long segment's rows costs
+// more than the BVH query at every building count (segment_bvh against
+// segment_grid_bvh in bench_suite).
+static bool is_visible(struct GameState *game_state, vec2 start, vec2 end, float edge_padding)
+{
+    return !bvh_segment_blocked(&game_state->building_bvh, start, end, edge_padding);
 }
 
 static void calc_visibility_graph(struct GameState *game_state, struct VisibilityGraph *graph)
@@ -411,7 +419,7 @@ static void calc_visibility_graph(struct GameState *game_state, struct Visibilit
     graph->node_count = 0;
 
     const uint32 resolution = 4;
-    const float world_size = 64.0f;
+    const float world_size = 2.0f * MAP_EXTENT;
 
     // Add border vertices.
     for (uint32 x = 0; x < resolution; ++x)
@@ -473,11 +481,17 @@ static void calc_visibility_graph(struct GameState *game_state, struct Visibilit
     fprintf(stderr, "Generated visibility graph containing %u verts, %u nodes.\n", graph->vertex_count, graph->node_count);
 }
 
-static bool is_node_in_list(struct WorkingPathNode *list, uint32 list_size, struct VisibilityNode *node, struct WorkingPathNode **match)
+static vec2 path_node_position(struct VisibilityGraph *graph, struct Path *path, uint32 index)
+{
+    ASSERT(index < path->node_count);
+    return graph->vertices[graph->nodes[path->node_indices[index]].vertex_index];
+}
+
+static bool is_node_in_list(struct WorkingPathNode *list, uint32 list_size, uint32 node_index, struct WorkingPathNode **match)
 {
     for (uint32 i = 0; i < list_size; ++i)
     {
-        if (list[i].node == node)
+        if (list[i].node_index == node_index)
         {
             *match = &list[i];
             return true;
@@ -499,12 +513,14 @@ static float calc_h_cost(vec2 start, vec2 end)
     return vec2_distance(start, end);
 }
 
-static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end)
+// The open and closed lists live in 'scratch' and are released before
+// returning. Adds the number of nodes the search closed to 'expanded_count'.
+static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end, struct MemoryArena *scratch, uint32 *expanded_count)
 {
     float min_start_distance = FLOAT_MAX;
     float min_end_distance = FLOAT_MAX;
-    struct VisibilityNode *starting_visibility_node = NULL;
-    struct VisibilityNode *ending_visibility_node = NULL;
+    uint32 starting_node_index = UINT32_MAX;
+    uint32 ending_node_index = UINT32_MAX;
 
     // TODO: optimize this O(n) search if needed.
     // Find the node closest to the starting/ending positions
@@ -519,7 +535,7 @@ static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end
         if (start_distance < min_start_distance)
         {
             min_start_distance = start_distance;
-            starting_visibility_node = candidate_node;
+            starting_node_index = i;
         }
 
         // Test for a closer 'end' node.
@@ -527,14 +543,14 @@ static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end
         if (end_distance < min_end_distance)
         {
             min_end_distance = end_distance;
-            ending_visibility_node = candidate_node;
+            ending_node_index = i;
         }
     }
 
-    ASSERT_NOT_NULL(starting_visibility_node);
-    ASSERT_NOT_NULL(ending_visibility_node);
+    ASSERT(starting_node_index != UINT32_MAX);
+    ASSERT(ending_node_index != UINT32_MAX);
 
-    if (starting_visibility_node == ending_visibility_node)
+    if (starting_node_index == ending_node_index)
     {
         //fprintf(stderr, "empty path, exiting early\n");
         struct Path empty_path = {0};
@@ -548,17 +564,18 @@ static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end
     //fprintf(stderr, "found starting node: %u neighbors, distance %f, index %u\n", starting_visibility_node->neighbor_index_count, min_start_distance, si);
     //fprintf(stderr, "found ending node: %u neighbors, distance %f, index %u\n", ending_visibility_node->neighbor_index_count, min_end_distance, ei);
 
-    // TODO: optimize this size
-    // Set up the temporary working node lists.
-    struct WorkingPathNode open_nodes[64];
-    struct WorkingPathNode closed_nodes[64];
+    // Set up the temporary working node lists. Each node enters either list
+    // at most once, so the node count bounds both.
+    struct TempArena working_memory = begin_temp_arena(scratch);
+    struct WorkingPathNode *open_nodes = push_array(scratch, struct WorkingPathNode, graph->node_count);
+    struct WorkingPathNode *closed_nodes = push_array(scratch, struct WorkingPathNode, graph->node_count);
     uint32 open_node_count = 0;
     uint32 closed_node_count = 0;
 
     // Add the starting node to the open node list.
     struct WorkingPathNode starting_node = {0};
-    starting_node.node = starting_visibility_node;
-    starting_node.parent = NULL;
+    starting_node.node_index = starting_node_index;
+    starting_node.parent_index = UINT32_MAX;
     open_nodes[open_node_count++] = starting_node;
     
     // Variable that will eventually point to the actual ending node.
@@ -595,7 +612,7 @@ static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end
         *current_node = *cheapest_node;
 
         // Found the ending node! End the search.
-        if (current_node->node == ending_visibility_node)
+        if (current_node->node_index == ending_node_index)
         {
             ending_node = current_node;
             break;
@@ -617,35 +634,33 @@ static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end
         }
 
         // Consider the node's neighbors.
-        struct VisibilityNode *current_visibility_node = current_node->node;
+        uint32 current_index = closed_node_count - 1;
+        struct VisibilityNode *current_visibility_node = &graph->nodes[current_node->node_index];
         //fprintf(stderr, "considering %u neighbors: %u, %u\n", current_visibility_node->neighbor_index_count, open_node_count, closed_node_count);
         for (uint32 i = 0; i < current_visibility_node->neighbor_index_count; ++i)
         {
             uint32 neighbor_index = current_visibility_node->neighbor_indices[i];
-            struct VisibilityNode *neighbor = &graph->nodes[neighbor_index];
-            ASSERT_NOT_NULL(neighbor);
-
             // Out parameter of is_node_in_list().
             struct WorkingPathNode *match = NULL;
 
             // Ignore the node if it's already in the closed list.
-            if (is_node_in_list(closed_nodes, closed_node_count, neighbor, &match))
+            if (is_node_in_list(closed_nodes, closed_node_count, neighbor_index, &match))
             {
                 //fprintf(stderr, "in closed list, ignoring: %u, %u\n", open_node_count, closed_node_count);
                 continue;
             }
 
             // Check if the node is already in the open list.
-            if (!is_node_in_list(open_nodes, open_node_count, neighbor, &match))
+            if (!is_node_in_list(open_nodes, open_node_count, neighbor_index, &match))
             {
                 //fprintf(stderr, "not in open list, adding: %u, %u\n", open_node_count, closed_node_count);
 
                 // Not in the open list, so add it and calculate its F=G+H cost.
                 struct WorkingPathNode *new_node = &open_nodes[open_node_count++];
-                new_node->node = neighbor;
-                new_node->parent = current_node;
+                new_node->node_index = neighbor_index;
+                new_node->parent_index = current_index;
 
-                vec2 new_node_position = graph->vertices[new_node->node->vertex_index];
+                vec2 new_node_position = graph->vertices[graph->nodes[neighbor_index].vertex_index];
 
                 // F = G + H
                 new_node->g_cost = calc_g_cost(start, new_node_position);
@@ -660,13 +675,13 @@ static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end
 
                 //fprintf(stderr, "already in open list, reconsidering: %u, %u\n", open_node_count, closed_node_count);
 
-                vec2 node_position = graph->vertices[match->node->vertex_index];
+                vec2 node_position = graph->vertices[graph->nodes[match->node_index].vertex_index];
                 float candidate_g_cost = calc_g_cost(start, node_position);
 
                 if (candidate_g_cost < match->g_cost)
                 {
                     // Better path found, so adjust the parent and F/G costs.
-                    match->parent = current_node;
+                    match->parent_index = current_index;
                     match->g_cost = candidate_g_cost;
                     match->f_cost = match->g_cost + match->h_cost;
                 }
@@ -674,18 +689,27 @@ static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end
         }
     }
 
-    ASSERT_NOT_NULL(ending_node);
+    // Crowded maps can wall a node in, e.g. a corner inside a neighbouring
+    // building sees nothing. Without a route, head straight for the end.
+    *expanded_count += closed_node_count;
 
-    // Construct the final path.
     struct Path path = {0};
     path.start = start;
     path.end = end;
 
+    if (!ending_node)
+    {
+        end_temp_arena(working_memory);
+        return path;
+    }
+
+    // Construct the final path.
     // Move backward through the path nodes, adding each one to the final path list.
-    while (ending_node->parent != NULL)
+    while (ending_node->parent_index != UINT32_MAX)
     {
-        path.nodes[path.node_count++] = ending_node->node;
-        ending_node = ending_node->parent;
+        ASSERT(path.node_count < ARRAY_SIZE(path.node_indices));
+        path.node_indices[path.node_count++] = ending_node->node_index;
+        ending_node = &closed_nodes[ending_node->parent_index];
     }
 
     // Reverse the path list.
@@ -695,272 +719,931 @@ static struct Path find_path(struct VisibilityGraph *graph, vec2 start, vec2 end
         uint32 j = path.node_count - 1;
         while (i < j)
         {
-            struct VisibilityNode *temp = path.nodes[i];
-            path.nodes[i] = path.nodes[j];
-            path.nodes[j] = temp;
+            uint32 temp = path.node_indices[i];
+            path.node_indices[i] = path.node_indices[j];
+            path.node_indices[j] = temp;
 
             ++i;
             --j;
         }
     }
 
+    end_temp_arena(working_memory);
     return path;
 }
 
-void init_game(struct GameMemory *memory)
+// Called before a tick moves anything, so render_game can blend from here to
+// the tick's result.
+static void store_previous_transforms(struct GameState *game_state)
 {
-    ASSERT(memory->game_memory_size >= sizeof(struct GameState));
-    struct GameState *game_state = (struct GameState *)memory->game_memory;
+    game_state->camera.previous_position = game_state->camera.position;
+    game_state->camera.previous_zoom = game_state->camera.zoom;
 
-    struct Camera *camera = &game_state->camera;
-    camera->zoom = 20.0f;
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+        game_state->ships[i].previous_position = game_state->ships[i].position;
 
-    game_state->ship_id_map = create_uint_hash_map();
+    for (uint32 i = 0; i < game_state->projectile_count; ++i)
+        game_state->projectiles[i].previous_position = game_state->projectiles[i].position;
+}
+
+//
+// scenario
+//
 
-    uint32 unit_count = 5;
-    for (uint32 i = 0; i < unit_count; ++i)
+// Rows centered on x = 0, filling away from the front line, about four times
+// as wide as they are deep. Repeaters are spread evenly through the rows.
+static void spawn_formation(struct GameState *game_state, struct Scenario *scenario, enum ShipTeam team, float front_distance)
+{
+    uint32 ship_count = scenario->ship_counts[team];
+    if (ship_count == 0)
+        return;
+
+    uint32 columns = 1;
+    while (columns * columns < 4 * ship_count)
+        ++columns;
+    columns = min_uint32(columns, ship_count);
+
+    float side = (team == TEAM_ALLY) ? -1.0f : 1.0f;
+    for (uint32 i = 0; i < ship_count; ++i)
     {
         struct Ship *ship = create_ship(game_state);
 
         ship->size = vec2_new(1, 1);
         ship->move_velocity = vec2_new(0, 0);
 
-        float xp = 2.0f * ((float)i - unit_count/2.0f);
-        float yp = -camera->zoom/4.0f;
+        uint32 row = i / columns;
+        uint32 column = i % columns;
+        float xp = FORMATION_SPACING * ((float)column - columns/2.0f);
+        float yp = side * (front_distance + FORMATION_SPACING * (float)row);
         ship->position = vec2_new(xp, yp);
 
         ship->health = 5;
-        ship->fire_cooldown = 2.0f;
 
-        ship->team = TEAM_ALLY;
+        bool repeater = (uint32)((float)(i + 1) * scenario->repeater_share) > (uint32)((float)i * scenario->repeater_share);
+        ship->fire_cooldown = repeater ? REPEATER_FIRE_COOLDOWN : CANNON_FIRE_COOLDOWN;
+
+        ship->team = (uint8)team;
     }
+}
 
-#if 0
-    for (uint32 i = 0; i < unit_count; ++i)
+static void place_random_buildings(struct GameState *game_state, struct Scenario *scenario)
+{
+    for (uint32 i = 0; i < scenario->building_count; ++i)
     {
-        struct Ship *ship = create_ship(game_state);
-        ship->size = vec2_new(1, 1);
-        ship->move_velocity = vec2_new(0, 0);
+        struct Building *building = create_building(game_state);
+        building->position = vec2_new(random_int_r(&game_state->random, -MAP_EXTENT, MAP_EXTENT), random_int_r(&game_state->random, -MAP_EXTENT, MAP_EXTENT));
+        building->size = vec2_scalar(scenario->building_size);
+    }
+}
 
-        float xp = 2.0f * ((float)i - unit_count/2.0f);
-        float yp = camera->zoom/4.0f;
-        ship->position = vec2_new(xp, yp);
+// Fills the blocks of a square grid row by row. Buildings are shrunk if
+// needed to leave streets two ships wide.
+static void place_grid_buildings(struct GameState *game_state, struct Scenario *scenario)
+{
+    uint32 columns = 1;
+    while (columns * columns < scenario->building_count)
+        ++columns;
 
-        ship->health = 5;
-        ship->fire_cooldown = 2.0f;
+    float pitch = 2.0f * MAP_EXTENT / (float)columns;
+    float size = min_float(scenario->building_size, pitch - 2.0f * FORMATION_SPACING);
+    for (uint32 i = 0; i < scenario->building_count; ++i)
+    {
+        float xp = pitch * ((float)(i % columns) + 0.5f) - MAP_EXTENT;
+        float yp = pitch * ((float)(i / columns) + 0.5f) - MAP_EXTENT;
 
-        ship->team = TEAM_ENEMY;
+        struct Building *building = create_building(game_state);
+        building->position = vec2_new(xp, yp);
+        building->size = vec2_scalar(max_float(size, 1.0f));
     }
-#endif
+}
+
+static void place_clustered_buildings(struct GameState *game_state, struct Scenario *scenario)
+{
+    uint32 cluster_count = max_uint32(scenario->cluster_count, 1);
+    ASSERT(cluster_count <= MAX_BUILDINGS);
 
-    for (uint32 i = 0; i < 4; ++i)
+    const int32 cluster_radius = MAP_EXTENT / 4;
+    vec2 centers[MAX_BUILDINGS];
+    for (uint32 i = 0; i < cluster_count; ++i)
     {
-        struct Building *building = create_building(game_state);
-        building->position = vec2_new(random_int(-32, 32), random_int(-32, 32));
-        building->size = vec2_new(2, 2);
+        int32 extent = MAP_EXTENT - cluster_radius;
+        centers[i] = vec2_new(random_int_r(&game_state->random, -extent, extent), random_int_r(&game_state->random, -extent, extent));
     }
 
-    calc_visibility_graph(game_state, &game_state->visibility_graph);
+    for (uint32 i = 0; i < scenario->building_count; ++i)
+    {
+        vec2 offset = vec2_new(random_int_r(&game_state->random, -cluster_radius, cluster_radius), random_int_r(&game_state->random, -cluster_radius, cluster_radius));
+
+        struct Building *building = create_building(game_state);
+        building->position = vec2_add(centers[i % cluster_count], offset);
+        building->size = vec2_scalar(scenario->building_size);
+    }
 }
 
-static void tick_combat(struct GameState *game_state, float dt)
+// Every ship heads for the spot mirrored across y = 0, which is where the
+// enemy's formation started.
+static void issue_initial_orders(struct GameState *game_state, enum InitialOrders orders, struct MemoryArena *scratch)
 {
     for (uint32 i = 0; i < game_state->ship_count; ++i)
     {
         struct Ship *ship = &game_state->ships[i];
+        vec2 target = vec2_new(ship->position.x, -ship->position.y);
 
-        if (ship->fire_cooldown_timer <= 0.0f)
+        if (orders == ORDERS_ROUTE)
         {
-            struct Ship *target = find_nearest_enemy(game_state, ship);
-            if (target == NULL)
-                continue;
-
-            fire_projectile(game_state, ship, target, 1);
+            BEGIN_PROFILE_ZONE(PROFILE_FIND_PATH);
+            ship->path = find_path(&game_state->visibility_graph, ship->position, target, scratch, &game_state->stats.path_nodes_expanded);
+            END_PROFILE_ZONE(PROFILE_FIND_PATH);
+            ++game_state->path_request_count;
+            ++game_state->stats.path_requests;
         }
         else
         {
-            ship->fire_cooldown_timer -= dt;
+            // No nodes: the move order steers straight at the end.
+            memset(&ship->path, 0, sizeof(ship->path));
+            ship->path.start = ship->position;
+            ship->path.end = target;
         }
+
+        ship->flags |= UNIT_MOVE_ORDER;
     }
 }
 
-static void tick_physics(struct GameState *game_state, float dt)
+void init_game(struct GameMemory *memory, struct GameConfig *config)
 {
-    // Projectile kinematics.
-    for (uint32 i = 0; i < game_state->projectile_count; ++i)
-    {
-        struct Projectile *projectile = &game_state->projectiles[i];
+    // GameState always sits at the start of game memory; snapshots, rewind and
+    // the other entry points rely on it.
+    reset_arena(&memory->permanent_arena);
+    struct GameState *game_state = push_struct(&memory->permanent_arena, struct GameState);
+    ASSERT(game_state == memory->game_memory);
 
-        // r = r0 + (v*t) + (a*t^2)/2
-        projectile->position = vec2_add(projectile->position, vec2_mul(projectile->velocity, dt));
+    game_state->deterministic = config->deterministic;
+    game_state->random = create_random(config->seed);
+    game_state->worker_count = config->worker_count;
+
+    struct Camera *camera = &game_state->camera;
+    camera->zoom = 20.0f;
+
+    struct Scenario *scenario = &config->scenario;
+    ASSERT(scenario->ship_counts[TEAM_ALLY] + scenario->ship_counts[TEAM_ENEMY] <= MAX_SHIPS);
+    ASSERT(scenario->building_count <= MAX_BUILDINGS);
+    ASSERT(scenario->broadphase < BROADPHASE_TYPE_COUNT);
+
+    game_state->ship_id_map = create_uint_hash_map();
+    init_broadphase(&game_state->ship_broadphase, (enum BroadphaseType)scenario->broadphase, 4.0f);
+
+    // The front lines start this far either side of y = 0.
+    float front_distance = camera->zoom/4.0f;
+    for (uint32 team = 0; team < TEAM_COUNT; ++team)
+        spawn_formation(game_state, scenario, (enum ShipTeam)team, front_distance);
+
+    switch (scenario->building_layout)
+    {
+        case BUILDING_LAYOUT_RANDOM:    place_random_buildings(game_state, scenario);    break;
+        case BUILDING_LAYOUT_GRID:      place_grid_buildings(game_state, scenario);      break;
+        case BUILDING_LAYOUT_CLUSTERED: place_clustered_buildings(game_state, scenario); break;
+        default: ASSERT(false);
     }
 
-    // Ship kinematics.
+    build_building_queries(game_state);
+    BEGIN_PROFILE_ZONE(PROFILE_VISIBILITY_GRAPH);
+    calc_visibility_graph(game_state, &game_state->visibility_graph);
+    END_PROFILE_ZONE(PROFILE_VISIBILITY_GRAPH);
+
+    // Routes need the visibility graph, so orders go out last.
+    if (scenario->orders != ORDERS_HOLD)
+        issue_initial_orders(game_state, (enum InitialOrders)scenario->orders, &memory->transient_arena);
+
+    store_previous_transforms(game_state);
+}
+
+void get_static_state_range(size_t *offset, size_t *size)
+{
+    *offset = offsetof(struct GameState, visibility_graph);
+    *size = offsetof(struct GameState, ships) - *offset;
+}
+
+size_t get_game_state_size(void)
+{
+    return sizeof(struct GameState);
+}
+
+//
+// simulation level of detail
+//
+
+static void wake_ship(struct Ship *ship)
+{
+    ship->idle_ticks = 0;
+}
+
+static uint8 enemy_team_mask(uint8 team)
+{
+    return (uint8)(((1 << TEAM_COUNT) - 1) & ~(1 << team));
+}
+
+// Ship positions bucketed by team, rebuilt whenever ships have moved.
+// Ships are boxes around their position, so a box query grows by the
+// largest half size to find every ship overlapping it.
+struct ShipGrid
+{
+    struct PointGrid points;
+    vec2 max_half_size;
+};
+
+static void build_ship_grid(struct GameState *game_state, struct ShipGrid *grid, struct MemoryArena *arena)
+{
+    vec2 *positions = push_array(arena, vec2, game_state->ship_count);
+    uint8 *teams = push_array(arena, uint8, game_state->ship_count);
+    grid->max_half_size = vec2_zero();
     for (uint32 i = 0; i < game_state->ship_count; ++i)
     {
         struct Ship *ship = &game_state->ships[i];
+        positions[i] = ship->position;
+        teams[i] = (uint8)(1 << ship->team);
+        grid->max_half_size = max_vec2(grid->max_half_size, vec2_div(ship->size, 2.0f));
+    }
 
-        vec2 move_acceleration = vec2_zero();
+    build_point_grid(&grid->points, positions, teams, game_state->ship_count, SHIP_GRID_CELL_SIZE, arena);
+}
 
-        // v = v0 + (a*t)
-        ship->move_velocity = vec2_add(ship->move_velocity, vec2_mul(move_acceleration, dt));
+// Assigns every ship a tier and the time it steps this tick. Depends only on
+// game state and the screen size passed to tick_game, so lockstep peers and
+// replays schedule identically.
+static void update_simulation_tiers(struct GameState *game_state, uint32 screen_width, uint32 screen_height, float dt)
+{
+    vec2 view_corner_a = screen_to_world_coords(vec2_zero(), &game_state->camera, screen_width, screen_height);
+    vec2 view_corner_b = screen_to_world_coords(vec2_new((float)screen_width, (float)screen_height), &game_state->camera, screen_width, screen_height);
 
-        // r = r0 + (v*t) + (a*t^2)/2
-        ship->position = vec2_add(vec2_add(ship->position, vec2_mul(ship->move_velocity, dt)), vec2_div(vec2_mul(move_acceleration, dt * dt), 2.0f));
-    }
+    struct AABB view;
+    view.min = vec2_sub(min_vec2(view_corner_a, view_corner_b), vec2_scalar(ON_SCREEN_MARGIN));
+    view.max = vec2_add(max_vec2(view_corner_a, view_corner_b), vec2_scalar(ON_SCREEN_MARGIN));
 
-    //
-    // TODO: spatial hashing
-    //
+    memset(game_state->tier_counts, 0, sizeof(game_state->tier_counts));
 
-    // Projectile collision.
-    for (uint32 i = 0; i < game_state->projectile_count; ++i)
+    uint32 team_ship_counts[TEAM_COUNT] = {0};
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+        ++team_ship_counts[game_state->ships[i].team];
+
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
     {
-        struct Projectile *projectile = &game_state->projectiles[i];
-        struct AABB projectile_aabb = aabb_from_transform(projectile->position, projectile->size);
+        struct Ship *ship = &game_state->ships[i];
 
-        // Projectile-building collision.
-        for (uint32 j = 0; j < game_state->building_count; ++j)
+        // Weapons reach any distance, so a ship is engaged for as long as the
+        // other team has ships. Stepping an engaged ship less often would
+        // change where and when it fires, so only ships out of the fight go
+        // distant, and only those that have also finished reloading sleep.
+        bool engaged = team_ship_counts[ship->team] < game_state->ship_count;
+        bool idle = !(ship->flags & UNIT_MOVE_ORDER) && vec2_equal(ship->move_velocity, vec2_zero()) && !engaged &&
+                    (ship->fire_cooldown_timer <= 0.0f);
+
+        if (!idle)
+            ship->idle_ticks = 0;
+        else if (ship->idle_ticks < UINT16_MAX)
+            ++ship->idle_ticks;
+
+        if (ship->idle_ticks >= SLEEP_DELAY_TICKS)
+            ship->tier = TIER_SLEEPING;
+        else if (engaged || aabb_aabb_intersection(view, aabb_from_transform(ship->position, ship->size)))
+            ship->tier = TIER_ACTIVE;
+        else
+            ship->tier = TIER_DISTANT;
+
+        switch (ship->tier)
         {
-            struct Building *building = &game_state->buildings[j];
-            struct AABB building_aabb = aabb_from_transform(building->position, building->size);
+            case TIER_ACTIVE:
+            {
+                // Includes time owed from being distant, so nothing is lost on promotion.
+                ship->step_dt = ship->pending_dt + dt;
+                ship->pending_dt = 0.0f;
+            } break;
 
-            if (aabb_aabb_intersection(projectile_aabb, building_aabb))
+            case TIER_DISTANT:
             {
-                // TODO: damage building if not friendly
-                destroy_projectile(game_state, projectile);
-                break;
-            }
+                // Staggered by ID so distant ships spread over the interval.
+                ship->pending_dt += dt;
+                ship->step_dt = 0.0f;
+                if (((game_state->tick_count + ship->id) % DISTANT_TICK_INTERVAL) == 0)
+                {
+                    ship->step_dt = ship->pending_dt;
+                    ship->pending_dt = 0.0f;
+                }
+            } break;
+
+            case TIER_SLEEPING:
+            {
+                // Nothing moves while asleep, so no time is owed. Cooldowns pause.
+                ship->step_dt = 0.0f;
+                ship->pending_dt = 0.0f;
+            } break;
         }
 
-        // NOTE: owner may be dead and destroyed at this point, so checking for NULL might be required.
-        struct Ship *owner = get_ship_by_id(game_state, projectile->owner);
+        ++game_state->tier_counts[ship->tier];
+    }
+}
+
+static struct Ship *find_nearest_enemy(struct GameState *game_state, struct ShipGrid *ship_grid, struct Ship *ship)
+{
+    uint32 nearest = point_grid_nearest(&ship_grid->points, ship->position, enemy_team_mask(ship->team));
+    if (nearest == UINT32_MAX)
+        return NULL;
+
+    return &game_state->ships[nearest];
+}
+
+// 'ship_grid' must hold the ships' current positions. Distant ships fire
+// and reload every tick like active ones, so LOD never changes when a shot
+// goes out.
+static void tick_combat(struct GameState *game_state, struct ShipGrid *ship_grid, float dt)
+{
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+    {
+        struct Ship *ship = &game_state->ships[i];
+        if (ship->tier == TIER_SLEEPING)
+            continue;
 
-        // Projectile-ship collision.
-        for (uint32 j = 0; j < game_state->ship_count; ++j)
+        if (ship->fire_cooldown_timer <= 0.0f)
         {
-            struct Ship *ship = &game_state->ships[j];
-            if (ship->id == projectile->owner)
+            // Ships hold fire while every projectile slot is in flight.
+            if (game_state->projectile_count == ARRAY_SIZE(game_state->projectiles))
                 continue;
 
-#if 0
-            // Allow projectiles to pass through teammates.
-            if (ship->team == projectile->team)
+            struct Ship *target = find_nearest_enemy(game_state, ship_grid, ship);
+            if (target == NULL)
                 continue;
-#endif
-
-            struct AABB ship_aabb = aabb_from_transform(ship->position, ship->size);
-
-            if (aabb_aabb_intersection(projectile_aabb, ship_aabb))
-            {
-                // Disable friendly fire.
-                if (ship->team != projectile->team)
-                    damage_ship(game_state, ship, projectile->damage);
 
-                destroy_projectile(game_state, projectile);
-                break;
-            }
+            fire_projectile(game_state, ship, target, 1);
+        }
+        else
+        {
+            ship->fire_cooldown_timer -= dt;
         }
     }
+}
+
+// An empty buffer for events of up to 'projectile_capacity' projectiles and 'ship_capacity' ships.
+static void push_event_buffer(struct EventBuffer *buffer, uint32 projectile_capacity, uint32 ship_capacity, struct MemoryArena *arena)
+{
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->projectile_capacity = projectile_capacity;
+    buffer->ship_capacity = ship_capacity;
+
+    buffer->hits = push_array(arena, struct ProjectileHitEvent, projectile_capacity);
+    buffer->damages = push_array(arena, struct ShipDamageEvent, projectile_capacity);
+    buffer->deaths = push_array(arena, struct ShipDeathEvent, ship_capacity);
+    buffer->expirations = push_array(arena, struct ProjectileExpiredEvent, projectile_capacity);
+}
 
-    // TODO: optimize
-    // Ship collision.
-    if (game_state->ship_count >= 2)
+// Collision phase for projectiles [begin, end). Only reads game state and
+// only writes to 'events', so disjoint ranges can run on separate workers.
+static void collide_projectiles(struct GameState *game_state, struct ShipGrid *ship_grid, uint32 begin, uint32 end, struct EventBuffer *events)
+{
+    for (uint32 i = begin; i < end; ++i)
     {
-        for (uint32 i = 0; i < game_state->ship_count - 1; ++i)
+        struct Projectile *projectile = &game_state->projectiles[i];
+        struct AABB projectile_aabb = aabb_from_transform(projectile->position, projectile->size);
+
+        if (projectile->lifetime <= 0.0f)
         {
-            struct Ship *a = &game_state->ships[i];
-            struct AABB a_aabb = aabb_from_transform(a->position, a->size);
-            vec2 a_center = vec2_div(vec2_add(a_aabb.min, a_aabb.max), 2.0f);
-            vec2 a_half_extents = vec2_div(vec2_sub(a_aabb.max, a_aabb.min), 2.0f);
+            struct ProjectileExpiredEvent *event = &events->expirations[events->expiration_count++];
+            event->projectile_index = i;
+            event->reason = PROJECTILE_EXPIRE_LIFETIME;
+            event->position = projectile->position;
+            continue;
+        }
 
-            // Ship-building collision.
-            for (uint32 j = 0; j < game_state->building_count; ++j)
-            {
-                struct Building *building = &game_state->buildings[j];
-                struct AABB b_aabb = aabb_from_transform(building->position, building->size);
+        // Projectile-building collision.
+        uint32 building_index;
+        bool grid_clear = (game_state->building_count >= OCCUPANCY_MIN_BUILDINGS) && occupancy_aabb_clear(&game_state->building_occupancy, projectile_aabb);
+        ++events->building_query_count;
+        events->building_grid_hit_count += grid_clear;
 
-                if (aabb_aabb_intersection(a_aabb, b_aabb))
-                {
-                    vec2 b_center = vec2_div(vec2_add(b_aabb.min, b_aabb.max), 2.0f);
-                    vec2 b_half_extents = vec2_div(vec2_sub(b_aabb.max, b_aabb.min), 2.0f);
+        if (!grid_clear && bvh_overlap_aabb(&game_state->building_bvh, projectile_aabb, &building_index, 1) > 0)
+        {
+            // TODO: damage building if not friendly
+            struct ProjectileExpiredEvent *event = &events->expirations[events->expiration_count++];
+            event->projectile_index = i;
+            event->reason = PROJECTILE_EXPIRE_BUILDING;
+            event->position = projectile->position;
+            continue;
+        }
 
-                    vec2 intersection = vec2_sub(vec2_abs(vec2_sub(b_center, a_center)), vec2_add(a_half_extents, b_half_extents));
-                    if (intersection.x > intersection.y)
+        // Projectile-ship collision. A projectile overlapping several ships
+        // hits the first in array order, which the grid cells do not keep, so
+        // every candidate is tested and the lowest index wins.
+        struct AABB query_aabb;
+        query_aabb.min = vec2_sub(projectile_aabb.min, ship_grid->max_half_size);
+        query_aabb.max = vec2_add(projectile_aabb.max, ship_grid->max_half_size);
+
+        struct PointGrid *points = &ship_grid->points;
+        uint32 hit_index = UINT32_MAX;
+        uint32 min_x, min_y, max_x, max_y;
+        if (point_grid_cell_range(points, query_aabb, &min_x, &min_y, &max_x, &max_y))
+        {
+            for (uint32 y = min_y; y <= max_y; ++y)
+            {
+                for (uint32 x = min_x; x <= max_x; ++x)
+                {
+                    uint32 cell = y * points->width + x;
+                    for (uint32 k = points->cell_offsets[cell]; k < points->cell_offsets[cell + 1]; ++k)
                     {
-                        a->move_velocity.x = 0.0f;
+                        // Indices ascend within a cell.
+                        uint32 j = points->indices[k];
+                        if (j >= hit_index)
+                            break;
 
-                        if (a->position.x < building->position.x)
-                            a->position.x += intersection.x/2.0f;
-                        else
-                            a->position.x -= intersection.x/2.0f;
-                    }
-                    else
-                    {
-                        a->move_velocity.y = 0.0f;
+                        struct Ship *ship = &game_state->ships[j];
+                        if (ship->id == projectile->owner)
+                            continue;
+
+#if 0
+                        // Allow projectiles to pass through teammates.
+                        if (ship->team == projectile->team)
+                            continue;
+#endif
 
-                        if (a->position.y < building->position.y)
-                            a->position.y += intersection.y/2.0f;
-                        else
-                            a->position.y -= intersection.y/2.0f;
+                        ++events->projectile_test_count;
+                        if (aabb_aabb_intersection(projectile_aabb, aabb_from_transform(ship->position, ship->size)))
+                            hit_index = j;
                     }
                 }
             }
+        }
 
-            // Ship-ship collision.
-            for (uint32 j = i + 1; j < game_state->ship_count; ++j)
-            {
-                struct Ship *b = &game_state->ships[j];
-                struct AABB b_aabb = aabb_from_transform(b->position, b->size);
+        if (hit_index != UINT32_MAX)
+        {
+            struct Ship *ship = &game_state->ships[hit_index];
 
-                if (aabb_aabb_intersection(a_aabb, b_aabb))
-                {
-                    vec2 b_center = vec2_div(vec2_add(b_aabb.min, b_aabb.max), 2.0f);
-                    vec2 b_half_extents = vec2_div(vec2_sub(b_aabb.max, b_aabb.min), 2.0f);
+            struct ProjectileHitEvent *hit = &events->hits[events->hit_count++];
+            hit->projectile_index = i;
+            hit->ship_id = ship->id;
+            hit->owner_id = projectile->owner;
+            hit->position = projectile->position;
 
-                    vec2 intersection = vec2_sub(vec2_abs(vec2_sub(b_center, a_center)), vec2_add(a_half_extents, b_half_extents));
-                    if (intersection.x > intersection.y)
-                    {
-                        if (abs_float(a->move_velocity.x) > abs_float(b->move_velocity.x))
-                            a->move_velocity.x = 0.0f;
-                        else
-                            b->move_velocity.x = 0.0f;
-
-                        if (a->position.x < b->position.x)
-                        {
-                            a->position.x += intersection.x/2.0f;
-                            b->position.x -= intersection.x/2.0f;
-                        }
-                        else
-                        {
-                            a->position.x -= intersection.x/2.0f;
-                            b->position.x += intersection.x/2.0f;
-                        }
-                    }
-                    else
-                    {
-                        if (abs_float(a->move_velocity.y) > abs_float(b->move_velocity.y))
-                            a->move_velocity.y = 0.0f;
-                        else
-                            b->move_velocity.y = 0.0f;
-
-                        if (a->position.y < b->position.y)
-                        {
-                            a->position.y += intersection.y/2.0f;
-                            b->position.y -= intersection.y/2.0f;
-                        }
-                        else
-                        {
-                            a->position.y -= intersection.y/2.0f;
-                            b->position.y += intersection.y/2.0f;
-                        }
-                    }
-                }
+            // Disable friendly fire.
+            if (ship->team != projectile->team)
+            {
+                struct ShipDamageEvent *damage = &events->damages[events->damage_count++];
+                damage->ship_id = ship->id;
+                damage->source_id = projectile->owner;
+                damage->damage = projectile->damage;
             }
         }
     }
 }
 
+static void merge_event_buffer(struct EventBuffer *destination, struct EventBuffer *source)
+{
+    ASSERT(destination->hit_count + source->hit_count <= destination->projectile_capacity);
+    memcpy(&destination->hits[destination->hit_count], source->hits, source->hit_count * sizeof(source->hits[0]));
+    destination->hit_count += source->hit_count;
+
+    ASSERT(destination->damage_count + source->damage_count <= destination->projectile_capacity);
+    memcpy(&destination->damages[destination->damage_count], source->damages, source->damage_count * sizeof(source->damages[0]));
+    destination->damage_count += source->damage_count;
+
+    ASSERT(destination->death_count + source->death_count <= destination->ship_capacity);
+    memcpy(&destination->deaths[destination->death_count], source->deaths, source->death_count * sizeof(source->deaths[0]));
+    destination->death_count += source->death_count;
+
+    ASSERT(destination->expiration_count + source->expiration_count <= destination->projectile_capacity);
+    memcpy(&destination->expirations[destination->expiration_count], source->expirations, source->expiration_count * sizeof(source->expirations[0]));
+    destination->expiration_count += source->expiration_count;
+
+    destination->projectile_test_count += source->projectile_test_count;
+    destination->building_query_count += source->building_query_count;
+    destination->building_grid_hit_count += source->building_grid_hit_count;
+}
+
+// Resolve phase. Workers cover contiguous projectile ranges in order, so merging
+// their buffers in worker order yields the same stream for any worker count.
+// 'events' is empty on entry and receives the merged stream; the spent flags
+// come from 'scratch'.
+static void resolve_events(struct GameState *game_state, struct EventBuffer *worker_events, struct EventBuffer *events, struct MemoryArena *scratch)
+{
+    for (uint32 i = 0; i < game_state->worker_count; ++i)
+        merge_event_buffer(events, &worker_events[i]);
+
+    // Apply damage. Ships that drop to zero health die once, credited to the first source that got them there.
+    for (uint32 i = 0; i < events->damage_count; ++i)
+    {
+        struct ShipDamageEvent *damage = &events->damages[i];
+        struct Ship *ship = get_ship_by_id(game_state, damage->ship_id);
+        if ((ship == NULL) || (ship->health <= 0))
+            continue;
+
+        ship->health -= damage->damage;
+        wake_ship(ship);
+        if (ship->health <= 0)
+        {
+            ASSERT(events->death_count < events->ship_capacity);
+            struct ShipDeathEvent *death = &events->deaths[events->death_count++];
+            death->ship_id = ship->id;
+            death->killer_id = damage->source_id;
+            death->team = ship->team;
+            death->position = ship->position;
+        }
+    }
+
+    // Remove spent projectiles from the back so pending indices stay valid.
+    bool *spent = push_array(scratch, bool, game_state->projectile_count);
+    for (uint32 i = 0; i < events->hit_count; ++i)
+        spent[events->hits[i].projectile_index] = true;
+    for (uint32 i = 0; i < events->expiration_count; ++i)
+        spent[events->expirations[i].projectile_index] = true;
+
+    if (game_state->deterministic)
+    {
+        // Same result as removing one at a time, without a memmove per removal.
+        uint32 kept = 0;
+        for (uint32 i = 0; i < game_state->projectile_count; ++i)
+        {
+            if (!spent[i])
+                game_state->projectiles[kept++] = game_state->projectiles[i];
+        }
+
+        game_state->removals_since_spatial_sort += game_state->projectile_count - kept;
+        game_state->projectile_count = kept;
+    }
+    else
+    {
+        for (uint32 i = game_state->projectile_count; i > 0; --i)
+        {
+            if (spent[i - 1])
+                destroy_projectile(game_state, i - 1);
+        }
+    }
+
+    if (game_state->deterministic)
+    {
+        destroy_dead_ships(game_state, events->deaths, events->death_count, scratch);
+    }
+    else
+    {
+        for (uint32 i = 0; i < events->death_count; ++i)
+        {
+            struct Ship *ship = get_ship_by_id(game_state, events->deaths[i].ship_id);
+            ASSERT_NOT_NULL(ship);
+            destroy_ship(game_state, ship);
+        }
+    }
+}
+
+// 'scratch' holds the ship grid and the event buffers for the projectile
+// collision and resolve phases.
+static void tick_physics(struct GameState *game_state, float dt, struct MemoryArena *scratch)
+{
+    // Projectile kinematics.
+    for (uint32 i = 0; i < game_state->projectile_count; ++i)
+    {
+        struct Projectile *projectile = &game_state->projectiles[i];
+
+        // r = r0 + (v*t) + (a*t^2)/2
+        projectile->position = vec2_add(projectile->position, vec2_mul(projectile->velocity, dt));
+        projectile->lifetime -= dt;
+    }
+
+    // Ship kinematics, each with its own LOD step.
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+    {
+        struct Ship *ship = &game_state->ships[i];
+        float ship_dt = ship->step_dt;
+        if (ship_dt <= 0.0f)
+            continue;
+
+        vec2 move_acceleration = vec2_zero();
+
+        // v = v0 + (a*t)
+        ship->move_velocity = vec2_add(ship->move_velocity, vec2_mul(move_acceleration, ship_dt));
+
+        // r = r0 + (v*t) + (a*t^2)/2
+        ship->position = vec2_add(vec2_add(ship->position, vec2_mul(ship->move_velocity, ship_dt)), vec2_div(vec2_mul(move_acceleration, ship_dt * ship_dt), 2.0f));
+    }
+
+    // Projectile collision, against the ships where they moved to.
+    ASSERT((game_state->worker_count > 0) && (game_state->worker_count <= MAX_SIMULATION_WORKERS));
+    struct TempArena event_memory = begin_temp_arena(scratch);
+    struct EventBuffer *worker_events = push_array(scratch, struct EventBuffer, game_state->worker_count);
+    uint32 *worker_begins = push_array(scratch, uint32, game_state->worker_count + 1);
+    for (uint32 i = 0; i <= game_state->worker_count; ++i)
+        worker_begins[i] = (game_state->projectile_count * i) / game_state->worker_count;
+
+    for (uint32 i = 0; i < game_state->worker_count; ++i)
+        push_event_buffer(&worker_events[i], worker_begins[i + 1] - worker_begins[i], 0, scratch);
+
+    struct TempArena ship_grid_memory = begin_temp_arena(scratch);
+    struct ShipGrid ship_grid;
+    build_ship_grid(game_state, &ship_grid, scratch);
+
+    for (uint32 i = 0; i < game_state->worker_count; ++i)
+        collide_projectiles(game_state, &ship_grid, worker_begins[i], worker_begins[i + 1], &worker_events[i]);
+
+    end_temp_arena(ship_grid_memory);
+
+    struct EventBuffer events;
+    push_event_buffer(&events, game_state->projectile_count, game_state->ship_count, scratch);
+    resolve_events(game_state, worker_events, &events, scratch);
+
+    struct TickStats *stats = &game_state->stats;
+    stats->projectile_tests = events.projectile_test_count;
+    stats->projectile_hits = events.hit_count;
+    stats->building_queries = events.building_query_count;
+    stats->building_grid_hits = events.building_grid_hit_count;
+
+    end_temp_arena(event_memory);
+
+    // Ship-building collision. Sleeping ships have not moved.
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+    {
+        struct Ship *a = &game_state->ships[i];
+        if (a->tier == TIER_SLEEPING)
+            continue;
+
+        struct AABB a_aabb = aabb_from_transform(a->position, a->size);
+        vec2 a_center = vec2_div(vec2_add(a_aabb.min, a_aabb.max), 2.0f);
+        vec2 a_half_extents = vec2_div(vec2_sub(a_aabb.max, a_aabb.min), 2.0f);
+
+        // Room for every building, so no overlap is dropped.
+        uint32 building_indices[MAX_BUILDINGS];
+        uint32 building_index_count = bvh_overlap_aabb(&game_state->building_bvh, a_aabb, building_indices, ARRAY_SIZE(building_indices));
+
+        for (uint32 j = 0; j < building_index_count; ++j)
+        {
+            struct Building *building = &game_state->buildings[building_indices[j]];
+            struct AABB b_aabb = aabb_from_transform(building->position, building->size);
+
+            vec2 b_center = vec2_div(vec2_add(b_aabb.min, b_aabb.max), 2.0f);
+            vec2 b_half_extents = vec2_div(vec2_sub(b_aabb.max, b_aabb.min), 2.0f);
+
+            vec2 intersection = vec2_sub(vec2_abs(vec2_sub(b_center, a_center)), vec2_add(a_half_extents, b_half_extents));
+            if (intersection.x > intersection.y)
+            {
+                a->move_velocity.x = 0.0f;
+
+                if (a->position.x < building->position.x)
+                    a->position.x += intersection.x/2.0f;
+                else
+                    a->position.x -= intersection.x/2.0f;
+            }
+            else
+            {
+                a->move_velocity.y = 0.0f;
+
+                if (a->position.y < building->position.y)
+                    a->position.y += intersection.y/2.0f;
+                else
+                    a->position.y -= intersection.y/2.0f;
+            }
+        }
+    }
+
+    // Ship-ship broadphase.
+    struct Broadphase *broadphase = &game_state->ship_broadphase;
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+    {
+        struct Ship *ship = &game_state->ships[i];
+        if (ship->tier != TIER_SLEEPING)
+            move_broadphase_proxy(broadphase, ship->broadphase_proxy, aabb_from_transform(ship->position, ship->size));
+    }
+
+    update_broadphase(broadphase);
+
+    // Pair order depends on the broadphase and its history. In lockstep mode,
+    // resolve contacts in ship array order (creation order) instead.
+    struct SortKey *pair_order = game_state->pair_sort_keys;
+    for (uint32 i = 0; i < broadphase->pair_count; ++i)
+    {
+        pair_order[i].key = i;
+        pair_order[i].index = i;
+    }
+
+    if (game_state->deterministic)
+    {
+        for (uint32 i = 0; i < broadphase->pair_count; ++i)
+        {
+            struct BroadphasePair *pair = &broadphase->pairs[i];
+            uint32 a = find_pair(&game_state->ship_id_map, broadphase->proxies[pair->a].user_id)->value;
+            uint32 b = find_pair(&game_state->ship_id_map, broadphase->proxies[pair->b].user_id)->value;
+            pair_order[i].key = min_uint32(a, b) * MAX_SHIPS + max_uint32(a, b);
+        }
+
+        radix_sort(pair_order, game_state->pair_sort_scratch, broadphase->pair_count);
+    }
+
+    // Ship-ship collision.
+    stats->pair_tests = broadphase->pair_count;
+    for (uint32 i = 0; i < broadphase->pair_count; ++i)
+    {
+        struct BroadphasePair *pair = &broadphase->pairs[pair_order[i].index];
+        struct Ship *a = get_ship_by_id(game_state, broadphase->proxies[pair->a].user_id);
+        struct Ship *b = get_ship_by_id(game_state, broadphase->proxies[pair->b].user_id);
+        ASSERT_NOT_NULL(a);
+        ASSERT_NOT_NULL(b);
+
+        // Earlier pairs may have pushed these ships apart.
+        struct AABB a_aabb = aabb_from_transform(a->position, a->size);
+        struct AABB b_aabb = aabb_from_transform(b->position, b->size);
+        if (!aabb_aabb_intersection(a_aabb, b_aabb))
+            continue;
+
+        ++stats->pairs_resolved;
+        wake_ship(a);
+        wake_ship(b);
+
+        vec2 a_center = vec2_div(vec2_add(a_aabb.min, a_aabb.max), 2.0f);
+        vec2 a_half_extents = vec2_div(vec2_sub(a_aabb.max, a_aabb.min), 2.0f);
+        vec2 b_center = vec2_div(vec2_add(b_aabb.min, b_aabb.max), 2.0f);
+        vec2 b_half_extents = vec2_div(vec2_sub(b_aabb.max, b_aabb.min), 2.0f);
+
+        vec2 intersection = vec2_sub(vec2_abs(vec2_sub(b_center, a_center)), vec2_add(a_half_extents, b_half_extents));
+        if (intersection.x > intersection.y)
+        {
+            if (abs_float(a->move_velocity.x) > abs_float(b->move_velocity.x))
+                a->move_velocity.x = 0.0f;
+            else
+                b->move_velocity.x = 0.0f;
+
+            if (a->position.x < b->position.x)
+            {
+                a->position.x += intersection.x/2.0f;
+                b->position.x -= intersection.x/2.0f;
+            }
+            else
+            {
+                a->position.x -= intersection.x/2.0f;
+                b->position.x += intersection.x/2.0f;
+            }
+        }
+        else
+        {
+            if (abs_float(a->move_velocity.y) > abs_float(b->move_velocity.y))
+                a->move_velocity.y = 0.0f;
+            else
+                b->move_velocity.y = 0.0f;
+
+            if (a->position.y < b->position.y)
+            {
+                a->position.y += intersection.y/2.0f;
+                b->position.y -= intersection.y/2.0f;
+            }
+            else
+            {
+                a->position.y -= intersection.y/2.0f;
+                b->position.y += intersection.y/2.0f;
+            }
+        }
+    }
+}
+
+static struct AABB calc_entity_bounds(struct GameState *game_state)
+{
+    struct AABB bounds;
+    bounds.min = vec2_scalar(FLOAT_MAX);
+    bounds.max = vec2_scalar(-FLOAT_MAX);
+
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+    {
+        bounds.min = min_vec2(bounds.min, game_state->ships[i].position);
+        bounds.max = max_vec2(bounds.max, game_state->ships[i].position);
+    }
+
+    for (uint32 i = 0; i < game_state->projectile_count; ++i)
+    {
+        bounds.min = min_vec2(bounds.min, game_state->projectiles[i].position);
+        bounds.max = max_vec2(bounds.max, game_state->projectiles[i].position);
+    }
+
+    return bounds;
+}
+
+static void sort_ships_spatially(struct GameState *game_state, struct AABB bounds)
+{
+    ASSERT(game_state->ship_count <= ARRAY_SIZE(game_state->sort_keys));
+
+    struct SortKey *keys = game_state->sort_keys;
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+    {
+        keys[i].key = morton_key(game_state->ships[i].position, bounds);
+        keys[i].index = i;
+    }
+
+    radix_sort(keys, game_state->sort_scratch, game_state->ship_count);
+
+    struct Ship temp;
+    apply_sort_order(game_state->ships, sizeof(struct Ship), keys, game_state->ship_count, &temp);
+
+    // Ship IDs stay valid; only their array indices moved.
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+    {
+        struct UIntHashPair *pair = find_pair(&game_state->ship_id_map, game_state->ships[i].id);
+        ASSERT_NOT_NULL(pair);
+        pair->value = i;
+    }
+}
+
+static void sort_projectiles_spatially(struct GameState *game_state, struct AABB bounds)
+{
+    ASSERT(game_state->projectile_count <= ARRAY_SIZE(game_state->sort_keys));
+
+    struct SortKey *keys = game_state->sort_keys;
+    for (uint32 i = 0; i < game_state->projectile_count; ++i)
+    {
+        keys[i].key = morton_key(game_state->projectiles[i].position, bounds);
+        keys[i].index = i;
+    }
+
+    radix_sort(keys, game_state->sort_scratch, game_state->projectile_count);
+
+    struct Projectile temp;
+    apply_sort_order(game_state->projectiles, sizeof(struct Projectile), keys, game_state->projectile_count, &temp);
+}
+
+// Restores spatial locality of the entity arrays after swap-removes and movement.
+static void tick_spatial_sort(struct GameState *game_state)
+{
+    uint32 entity_count = game_state->ship_count + game_state->projectile_count;
+    bool interval_elapsed = (game_state->tick_count % SPATIAL_SORT_INTERVAL) == 0;
+    bool fragmented = game_state->removals_since_spatial_sort * SPATIAL_SORT_REMOVAL_FRACTION > entity_count;
+
+    // Lockstep mode keeps creation order instead.
+    if (game_state->deterministic)
+        return;
+
+    if ((entity_count == 0) || (!interval_elapsed && !fragmented))
+        return;
+
+    struct AABB bounds = calc_entity_bounds(game_state);
+    sort_ships_spatially(game_state, bounds);
+    sort_projectiles_spatially(game_state, bounds);
+
+    game_state->removals_since_spatial_sort = 0;
+}
+
+static void hash_ship(struct Hash *hash, struct GameState *game_state, struct Ship *ship)
+{
+    update_hash(hash, &ship->id, sizeof(ship->id));
+    update_hash(hash, &ship->team, sizeof(ship->team));
+    update_hash(hash, &ship->flags, sizeof(ship->flags));
+    update_hash(hash, &ship->position, sizeof(ship->position));
+    update_hash(hash, &ship->rotation, sizeof(ship->rotation));
+    update_hash(hash, &ship->size, sizeof(ship->size));
+    update_hash(hash, &ship->move_velocity, sizeof(ship->move_velocity));
+    update_hash(hash, &ship->rotation_velocity, sizeof(ship->rotation_velocity));
+    update_hash(hash, &ship->health, sizeof(ship->health));
+    update_hash(hash, &ship->fire_cooldown, sizeof(ship->fire_cooldown));
+    update_hash(hash, &ship->fire_cooldown_timer, sizeof(ship->fire_cooldown_timer));
+    update_hash(hash, &ship->tier, sizeof(ship->tier));
+    update_hash(hash, &ship->idle_ticks, sizeof(ship->idle_ticks));
+    update_hash(hash, &ship->pending_dt, sizeof(ship->pending_dt));
+
+    struct Path *path = &ship->path;
+    update_hash(hash, &path->node_count, sizeof(path->node_count));
+    update_hash(hash, &path->current_node_index, sizeof(path->current_node_index));
+    update_hash(hash, &path->start, sizeof(path->start));
+    update_hash(hash, &path->end, sizeof(path->end));
+    update_hash(hash, path->node_indices, path->node_count * sizeof(path->node_indices[0]));
+}
+
+static void hash_projectile(struct Hash *hash, struct Projectile *projectile)
+{
+    update_hash(hash, &projectile->owner, sizeof(projectile->owner));
+    update_hash(hash, &projectile->team, sizeof(projectile->team));
+    update_hash(hash, &projectile->damage, sizeof(projectile->damage));
+    update_hash(hash, &projectile->position, sizeof(projectile->position));
+    update_hash(hash, &projectile->size, sizeof(projectile->size));
+    update_hash(hash, &projectile->velocity, sizeof(projectile->velocity));
+    update_hash(hash, &projectile->lifetime, sizeof(projectile->lifetime));
+}
+
+// Hashes everything the simulation reads on the next tick. Fields are hashed
+// one by one so struct padding never leaks into the result.
+static uint64 hash_game_state(struct GameState *game_state)
+{
+    struct Hash hash = begin_hash(0);
+
+    update_hash(&hash, &game_state->tick_count, sizeof(game_state->tick_count));
+    update_hash(&hash, &game_state->random, sizeof(game_state->random));
+    update_hash(&hash, &game_state->camera.position, sizeof(game_state->camera.position));
+    update_hash(&hash, &game_state->camera.zoom, sizeof(game_state->camera.zoom));
+    // The view picks simulation tiers, and the velocities move it next tick.
+    update_hash(&hash, &game_state->camera.move_velocity, sizeof(game_state->camera.move_velocity));
+    update_hash(&hash, &game_state->camera.zoom_velocity, sizeof(game_state->camera.zoom_velocity));
+
+    update_hash(&hash, &game_state->ship_count, sizeof(game_state->ship_count));
+    update_hash(&hash, &game_state->ship_ids, sizeof(game_state->ship_ids));
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
+        hash_ship(&hash, game_state, &game_state->ships[i]);
+
+    update_hash(&hash, &game_state->selected_ship_count, sizeof(game_state->selected_ship_count));
+    update_hash(&hash, game_state->selected_ships, game_state->selected_ship_count * sizeof(game_state->selected_ships[0]));
+
+    update_hash(&hash, &game_state->projectile_count, sizeof(game_state->projectile_count));
+    for (uint32 i = 0; i < game_state->projectile_count; ++i)
+        hash_projectile(&hash, &game_state->projectiles[i]);
+
+    return end_hash(&hash);
+}
+
 static struct AABB calc_mouse_selection_box(struct Input *input, uint32 mouse_button)
 {
     vec2 origin = input->mouse_down_positions[mouse_button];
@@ -974,29 +1657,13 @@ static struct AABB calc_mouse_selection_box(struct Input *input, uint32 mouse_bu
 
 void tick_game(struct GameMemory *memory, struct Input *input, uint32 screen_width, uint32 screen_height, float dt)
 {
-    struct GameState *game_state = (struct GameState *)memory->game_memory;
-    struct RenderBuffer *render_buffer = (struct RenderBuffer *)memory->render_memory;
-
-    clear_render_buffer(render_buffer);
+    BEGIN_PROFILE_ZONE(PROFILE_TICK_GAME);
 
-    // Draw mouse selection box.
-    if (mouse_down(MOUSE_LEFT, input))
-    {
-        struct AABB box = calc_mouse_selection_box(input, MOUSE_LEFT);
-
-        vec2 size = vec2_sub(box.max, box.min);
-        vec2 bottom_left  = vec2_new(box.min.x, box.max.y);
-        vec2 bottom_right = vec2_new(box.max.x, box.max.y);
-        vec2 top_left     = vec2_new(box.min.x, box.min.y);
-        vec2 top_right    = vec2_new(box.max.x, box.min.y);
-
-        const uint32 outline_thickness = 1;
+    struct GameState *game_state = (struct GameState *)memory->game_memory;
+    reset_arena(&memory->transient_arena);
 
-        draw_screen_quad_buffered(render_buffer, top_left, vec2_new(size.x, outline_thickness), vec4_zero(), vec3_new(1, 1, 0));
-        draw_screen_quad_buffered(render_buffer, bottom_left, vec2_new(size.x, outline_thickness), vec4_zero(), vec3_new(1, 1, 0));
-        draw_screen_quad_buffered(render_buffer, top_left, vec2_new(outline_thickness, size.y), vec4_zero(), vec3_new(1, 1, 0));
-        draw_screen_quad_buffered(render_buffer, top_right, vec2_new(outline_thickness, size.y), vec4_zero(), vec3_new(1, 1, 0));
-    }
+    store_previous_transforms(game_state);
+    memset(&game_state->stats, 0, sizeof(game_state->stats));
 
     // Select entities.
     if (mouse_released(MOUSE_LEFT, input))
@@ -1025,8 +1692,14 @@ void tick_game(struct GameMemory *memory, struct Input *input, uint32 screen_wid
 
             vec2 center = vec2_div(vec2_add(ship_aabb.min, ship_aabb.max), 2.0f);
 
-            if (aabb_aabb_intersection(world_selection_box, ship_aabb))
-                game_state->selected_ships[game_state->selected_ship_count++] = ship->id;
+            if (!aabb_aabb_intersection(world_selection_box, ship_aabb))
+                continue;
+
+            // Large scenarios have more ships on screen than a selection holds.
+            if (game_state->selected_ship_count == ARRAY_SIZE(game_state->selected_ships))
+                break;
+
+            game_state->selected_ships[game_state->selected_ship_count++] = ship->id;
         }
 
         if (game_state->selected_ship_count > 0)
@@ -1042,18 +1715,30 @@ void tick_game(struct GameMemory *memory, struct Input *input, uint32 screen_wid
         {
             uint32 id = game_state->selected_ships[i];
             struct Ship *ship = get_ship_by_id(game_state, id);
+            if (!ship)
+                continue;
 
             vec2 start = ship->position;
 
-            ship->path = find_path(&game_state->visibility_graph, start, end);
+            BEGIN_PROFILE_ZONE(PROFILE_FIND_PATH);
+            ship->path = find_path(&game_state->visibility_graph, start, end, &memory->transient_arena, &game_state->stats.path_nodes_expanded);
+            END_PROFILE_ZONE(PROFILE_FIND_PATH);
+            ++game_state->path_request_count;
+            ++game_state->stats.path_requests;
             ship->flags |= UNIT_MOVE_ORDER;
         }
     }
 
-    // Handle move orders.
+    update_simulation_tiers(game_state, screen_width, screen_height, dt);
+
+    // Handle move orders. Ships not stepping this tick keep their velocity.
+    BEGIN_PROFILE_ZONE(PROFILE_MOVE_ORDERS);
     for (uint32 i = 0; i < game_state->ship_count; ++i)
     {
         struct Ship *ship = &game_state->ships[i];
+        if (ship->step_dt <= 0.0f)
+            continue;
+
         if (ship->flags & UNIT_MOVE_ORDER)
         {
             // Ship has reached the final node and is pathing to the exact target coordinates.
@@ -1075,8 +1760,7 @@ void tick_game(struct GameMemory *memory, struct Input *input, uint32 screen_wid
             }
 
             // Move toward the current node in the stored path.
-            struct VisibilityNode *target_node = ship->path.nodes[ship->path.current_node_index];
-            ASSERT_NOT_NULL(target_node);
+            struct VisibilityNode *target_node = &game_state->visibility_graph.nodes[ship->path.node_indices[ship->path.current_node_index]];
             vec2 target_node_position = game_state->visibility_graph.vertices[target_node->vertex_index];
 
             // Current node has been reached, so move to the next node.
@@ -1089,7 +1773,7 @@ void tick_game(struct GameMemory *memory, struct Input *input, uint32 screen_wid
                     continue;
 
                 // Update the target.
-                target_node = ship->path.nodes[ship->path.current_node_index];
+                target_node = &game_state->visibility_graph.nodes[ship->path.node_indices[ship->path.current_node_index]];
                 target_node_position = game_state->visibility_graph.vertices[target_node->vertex_index];
             }
 
@@ -1097,98 +1781,169 @@ void tick_game(struct GameMemory *memory, struct Input *input, uint32 screen_wid
             ship->move_velocity = vec2_mul(direction, 2.0f);
         }
     }
+    END_PROFILE_ZONE(PROFILE_MOVE_ORDERS);
 
+    BEGIN_PROFILE_ZONE(PROFILE_TICK_CAMERA);
     tick_camera(input, &game_state->camera, dt);
+    END_PROFILE_ZONE(PROFILE_TICK_CAMERA);
 
-    tick_combat(game_state, dt);
-    tick_physics(game_state, dt);
+    BEGIN_PROFILE_ZONE(PROFILE_TICK_COMBAT);
+    struct TempArena ship_grid_memory = begin_temp_arena(&memory->transient_arena);
+    struct ShipGrid ship_grid;
+    build_ship_grid(game_state, &ship_grid, &memory->transient_arena);
+    tick_combat(game_state, &ship_grid, dt);
+    END_PROFILE_ZONE(PROFILE_TICK_COMBAT);
+    end_temp_arena(ship_grid_memory);
 
-#if 0
-    // Draw visibility graph vertices.
-    for (uint32 i = 0; i < game_state->visibility_graph.vertex_count; ++i)
+    BEGIN_PROFILE_ZONE(PROFILE_TICK_PHYSICS);
+    tick_physics(game_state, dt, &memory->transient_arena);
+    END_PROFILE_ZONE(PROFILE_TICK_PHYSICS);
+
+    tick_spatial_sort(game_state);
+    ++game_state->tick_count;
+
+    game_state->state_hash = hash_game_state(game_state);
+
+    END_PROFILE_ZONE(PROFILE_TICK_GAME);
+}
+
+static void copy_render_entity(struct RenderEntity *entity, vec2 position, vec2 previous_position, vec2 size)
+{
+    entity->position = position;
+    entity->previous_position = previous_position;
+    entity->size = size;
+}
+
+static void copy_render_path(struct GameState *game_state, struct Path *path, struct RenderPath *render_path)
+{
+    render_path->start = path->start;
+    render_path->end = path->end;
+    render_path->node_count = path->node_count;
+    render_path->current_node_index = path->current_node_index;
+
+    for (uint32 i = 0; i < path->node_count; ++i)
+        render_path->nodes[i] = path_node_position(&game_state->visibility_graph, path, i);
+}
+
+void copy_render_state(struct GameMemory *memory, struct RenderState *render_state)
+{
+    struct GameState *game_state = (struct GameState *)memory->game_memory;
+
+    render_state->tick_count = game_state->tick_count;
+    render_state->camera = game_state->camera;
+
+    // Buildings never move, but they are few and a snapshot load can replace them.
+    render_state->building_count = game_state->building_count;
+    memcpy(render_state->buildings, game_state->buildings, game_state->building_count * sizeof(struct Building));
+
+    render_state->ship_count = game_state->ship_count;
+    for (uint32 i = 0; i < game_state->ship_count; ++i)
     {
-        vec2 vertex = game_state->visibility_graph.vertices[i];
-        draw_world_quad_buffered(render_buffer, vertex, vec2_scalar(0.1f), vec4_zero(), vec3_new(0, 1, 1));
+        struct Ship *ship = &game_state->ships[i];
+        copy_render_entity(&render_state->ships[i], ship->position, ship->previous_position, ship->size);
     }
-#endif
 
-#if 0
-    static uint32 index = 0;
-    if (key_down_new(KEY_F, input))
-        ++index;
-#endif
-#if 0
-    // Draw visibility graph edges.
-    for (uint32 i = 0; i < game_state->visibility_graph.node_count; ++i)
+    render_state->projectile_count = game_state->projectile_count;
+    for (uint32 i = 0; i < game_state->projectile_count; ++i)
     {
-        struct VisibilityNode *node = &game_state->visibility_graph.nodes[i];
-        for (uint32 j = 0; j < node->neighbor_index_count; ++j)
-        {
-            vec2 p0 = game_state->visibility_graph.vertices[node->vertex_index];
-            vec2 p1 = game_state->visibility_graph.vertices[node->neighbor_indices[j]];
-
-            draw_world_line_buffered(render_buffer, p0, p1, vec3_new(1, 1, 0));
-        }
+        struct Projectile *projectile = &game_state->projectiles[i];
+        copy_render_entity(&render_state->projectiles[i], projectile->position, projectile->previous_position, projectile->size);
     }
-#endif
 
-    // Outline selected ships.
+    render_state->selected_ship_count = 0;
     for (uint32 i = 0; i < game_state->selected_ship_count; ++i)
     {
-        uint32 id = game_state->selected_ships[i];
-        struct Ship *ship = get_ship_by_id(game_state, id);
+        struct Ship *ship = get_ship_by_id(game_state, game_state->selected_ships[i]);
+        ASSERT_NOT_NULL(ship);
 
-        draw_world_quad_buffered(render_buffer, ship->position, vec2_mul(ship->size, 1.1f), vec4_zero(), vec3_new(0, 1, 0));
+        struct RenderSelectedShip *selected = &render_state->selected_ships[render_state->selected_ship_count++];
+        copy_render_entity(&selected->entity, ship->position, ship->previous_position, ship->size);
 
-        // Draw path.
-        if (ship->flags & UNIT_MOVE_ORDER)
-        {
-            draw_world_quad_buffered(render_buffer, ship->path.start, vec2_scalar(0.5f), vec4_zero(), vec3_new(0, 0, 1));
-            draw_world_quad_buffered(render_buffer, ship->path.end, vec2_scalar(0.5f), vec4_zero(), vec3_new(0, 1, 1));
+        selected->has_path = (ship->flags & UNIT_MOVE_ORDER) != 0;
+        if (selected->has_path)
+            copy_render_path(game_state, &ship->path, &selected->path);
+    }
 
-            for (uint32 j = 0; j < ship->path.node_count; ++j)
-            {
-                vec2 node_position = game_state->visibility_graph.vertices[ship->path.nodes[j]->vertex_index];
-                vec3 color = (j == ship->path.current_node_index) ? vec3_new(0, 1, 0) : vec3_new(1, 0, 0);
-                draw_world_quad_buffered(render_buffer, node_position, vec2_scalar(0.5f), vec4_zero(), color);
-            }
+    render_state->collision_pair_count = game_state->ship_broadphase.pair_count;
+    render_state->path_request_count = game_state->path_request_count;
+}
 
-            if (ship->path.node_count == 0)
-            {
-                draw_world_line_buffered(render_buffer, ship->path.start, ship->path.end, vec3_new(1, 1, 0));
-            }
-            else
-            {
-                vec2 first_node_position = game_state->visibility_graph.vertices[ship->path.nodes[0]->vertex_index];
-                draw_world_line_buffered(render_buffer, ship->path.start, first_node_position, vec3_new(1, 1, 0));
+static void extract_path(struct RenderPath *path, struct RenderBuffer *render_buffer)
+{
+    draw_world_quad_buffered(render_buffer, path->start, vec2_scalar(0.5f), vec4_zero(), vec3_new(0, 0, 1));
+    draw_world_quad_buffered(render_buffer, path->end, vec2_scalar(0.5f), vec4_zero(), vec3_new(0, 1, 1));
 
-                if (ship->path.node_count == 1)
-                {
-                    vec2 last_node_position = game_state->visibility_graph.vertices[ship->path.nodes[0]->vertex_index];
-                    draw_world_line_buffered(render_buffer, last_node_position, ship->path.end, vec3_new(1, 1, 0));
-                }
-                else
-                {
-                    for (uint32 j = 0; j < ship->path.node_count - 1; ++j)
-                    {
-                        vec2 p0 = game_state->visibility_graph.vertices[ship->path.nodes[j]->vertex_index];
-                        vec2 p1 = game_state->visibility_graph.vertices[ship->path.nodes[j + 1]->vertex_index];
-                        draw_world_line_buffered(render_buffer, p0, p1, vec3_new(1, 1, 0));
-                    }
-                }
-            }
-        }
+    for (uint32 i = 0; i < path->node_count; ++i)
+    {
+        vec3 color = (i == path->current_node_index) ? vec3_new(0, 1, 0) : vec3_new(1, 0, 0);
+        draw_world_quad_buffered(render_buffer, path->nodes[i], vec2_scalar(0.5f), vec4_zero(), color);
+    }
+
+    if (path->node_count == 0)
+    {
+        draw_world_line_buffered(render_buffer, path->start, path->end, vec3_new(1, 1, 0));
+        return;
+    }
+
+    draw_world_line_buffered(render_buffer, path->start, path->nodes[0], vec3_new(1, 1, 0));
+
+    if (path->node_count == 1)
+    {
+        draw_world_line_buffered(render_buffer, path->nodes[0], path->end, vec3_new(1, 1, 0));
+    }
+    else
+    {
+        for (uint32 i = 0; i < path->node_count - 1; ++i)
+            draw_world_line_buffered(render_buffer, path->nodes[i], path->nodes[i + 1], vec3_new(1, 1, 0));
     }
 }
 
-static void draw_buildings(struct GameState *game_state, struct Renderer *renderer)
+void extract_render_buffer(struct RenderState *render_state, struct Input *input, struct RenderBuffer *render_buffer, float alpha)
+{
+    clear_render_buffer(render_buffer);
+
+    alpha = clamp_float(alpha, 0.0f, 1.0f);
+
+    // Draw mouse selection box.
+    if (mouse_down(MOUSE_LEFT, input))
+    {
+        struct AABB box = calc_mouse_selection_box(input, MOUSE_LEFT);
+
+        vec2 size = vec2_sub(box.max, box.min);
+        vec2 bottom_left  = vec2_new(box.min.x, box.max.y);
+        vec2 bottom_right = vec2_new(box.max.x, box.max.y);
+        vec2 top_left     = vec2_new(box.min.x, box.min.y);
+        vec2 top_right    = vec2_new(box.max.x, box.min.y);
+
+        const uint32 outline_thickness = 1;
+
+        draw_screen_quad_buffered(render_buffer, top_left, vec2_new(size.x, outline_thickness), vec4_zero(), vec3_new(1, 1, 0));
+        draw_screen_quad_buffered(render_buffer, bottom_left, vec2_new(size.x, outline_thickness), vec4_zero(), vec3_new(1, 1, 0));
+        draw_screen_quad_buffered(render_buffer, top_left, vec2_new(outline_thickness, size.y), vec4_zero(), vec3_new(1, 1, 0));
+        draw_screen_quad_buffered(render_buffer, top_right, vec2_new(outline_thickness, size.y), vec4_zero(), vec3_new(1, 1, 0));
+    }
+
+    // Outline selected ships where draw_ships puts them this frame.
+    for (uint32 i = 0; i < render_state->selected_ship_count; ++i)
+    {
+        struct RenderSelectedShip *selected = &render_state->selected_ships[i];
+        vec2 position = vec2_lerp(selected->entity.previous_position, selected->entity.position, alpha);
+
+        draw_world_quad_buffered(render_buffer, position, vec2_mul(selected->entity.size, 1.1f), vec4_zero(), vec3_new(0, 1, 0));
+
+        if (selected->has_path)
+            extract_path(&selected->path, render_buffer);
+    }
+}
+
+static void draw_buildings(struct RenderState *render_state, struct Renderer *renderer)
 {
     bind_program(renderer->quad_program);
     begin_sprite_batch(&renderer->sprite_batch);
 
-    for (uint32 i = 0; i < game_state->building_count; ++i)
+    for (uint32 i = 0; i < render_state->building_count; ++i)
     {
-        struct Building *building = &game_state->buildings[i];
+        struct Building *building = &render_state->buildings[i];
         draw_quad(&renderer->sprite_batch, building->position, building->size, vec3_new(0.3f, 0.3f, 0.3f));
     }
 
@@ -1196,30 +1951,32 @@ static void draw_buildings(struct GameState *game_state, struct Renderer *render
     bind_program(0);
 }
 
-static void draw_ships(struct GameState *game_state, struct Renderer *renderer)
+static void draw_ships(struct RenderState *render_state, struct Renderer *renderer, float alpha)
 {
     bind_program(renderer->quad_program);
     begin_sprite_batch(&renderer->sprite_batch);
 
-    for (uint32 i = 0; i < game_state->ship_count; ++i)
+    for (uint32 i = 0; i < render_state->ship_count; ++i)
     {
-        struct Ship *ship = &game_state->ships[i];
-        draw_quad(&renderer->sprite_batch, ship->position, ship->size, vec3_new(0.5f, 0.5f, 0.5f));
+        struct RenderEntity *ship = &render_state->ships[i];
+        vec2 position = vec2_lerp(ship->previous_position, ship->position, alpha);
+        draw_quad(&renderer->sprite_batch, position, ship->size, vec3_new(0.5f, 0.5f, 0.5f));
     }
 
     end_sprite_batch(&renderer->sprite_batch);
     bind_program(0);
 }
 
-static void draw_projectiles(struct GameState *game_state, struct Renderer *renderer)
+static void draw_projectiles(struct RenderState *render_state, struct Renderer *renderer, float alpha)
 {
     bind_program(renderer->quad_program);
     begin_sprite_batch(&renderer->sprite_batch);
 
-    for (uint32 i = 0; i < game_state->projectile_count; ++i)
+    for (uint32 i = 0; i < render_state->projectile_count; ++i)
     {
-        struct Projectile *projectile = &game_state->projectiles[i];
-        draw_quad(&renderer->sprite_batch, projectile->position, projectile->size, vec3_new(0.0f, 1.0f, 0.0f));
+        struct RenderEntity *projectile = &render_state->projectiles[i];
+        vec2 position = vec2_lerp(projectile->previous_position, projectile->position, alpha);
+        draw_quad(&renderer->sprite_batch, position, projectile->size, vec3_new(0.0f, 1.0f, 0.0f));
     }
 
     end_sprite_batch(&renderer->sprite_batch);
@@ -1240,38 +1997,61 @@ static void draw_frame_text_buffer(struct Renderer *renderer, struct RenderBuffe
     bind_program(0);
 }
 
-void render_game(struct GameMemory *memory, struct Renderer *renderer, uint32 screen_width, uint32 screen_height)
+void render_game(struct RenderState *render_state, struct RenderBuffer *render_buffer, struct Renderer *renderer, uint32 screen_width, uint32 screen_height, float alpha)
 {
-    struct GameState *game_state = (struct GameState *)memory->game_memory;
-    struct RenderBuffer *render_buffer = (struct RenderBuffer *)memory->render_memory;
+    BEGIN_PROFILE_ZONE(PROFILE_RENDER_GAME);
+
+    alpha = clamp_float(alpha, 0.0f, 1.0f);
+
+    struct Camera *camera = &render_state->camera;
+    vec2 camera_position = vec2_lerp(camera->previous_position, camera->position, alpha);
+    float camera_zoom = lerp_float(camera->previous_zoom, camera->zoom, alpha);
 
     float aspect_ratio = (float)screen_width / (float)screen_height;
-    mat4 projection_matrix = mat4_orthographic(-game_state->camera.zoom/2.0f, game_state->camera.zoom/2.0f,
-                                               -game_state->camera.zoom/2.0f / aspect_ratio, game_state->camera.zoom/2.0f / aspect_ratio,
+    mat4 projection_matrix = mat4_orthographic(-camera_zoom/2.0f, camera_zoom/2.0f,
+                                               -camera_zoom/2.0f / aspect_ratio, camera_zoom/2.0f / aspect_ratio,
                                                0.0f, 1.0f);
-    mat4 view_matrix = mat4_look_at(vec3_new(game_state->camera.position.x, game_state->camera.position.y, 0.0f), vec3_new(game_state->camera.position.x, game_state->camera.position.y, -1.0f), vec3_new(0, 1, 0));
+    mat4 view_matrix = mat4_look_at(vec3_new(camera_position.x, camera_position.y, 0.0f), vec3_new(camera_position.x, camera_position.y, -1.0f), vec3_new(0, 1, 0));
     mat4 view_projection_matrix = mat4_mul(projection_matrix, view_matrix);
 
     update_ubo(renderer->camera_ubo, sizeof(mat4), &view_projection_matrix);
 
+    BEGIN_PROFILE_ZONE(PROFILE_DRAW_WORLD_LINES);
     bind_program(renderer->line_program);
     draw_world_line_buffer(renderer, render_buffer, renderer->line_program);
     bind_program(0);
+    END_PROFILE_ZONE(PROFILE_DRAW_WORLD_LINES);
 
+    BEGIN_PROFILE_ZONE(PROFILE_DRAW_WORLD_QUADS);
     bind_program(renderer->quad_program);
     draw_world_quad_buffer(&renderer->sprite_batch, render_buffer);
     bind_program(0);
+    END_PROFILE_ZONE(PROFILE_DRAW_WORLD_QUADS);
+
+    BEGIN_PROFILE_ZONE(PROFILE_DRAW_BUILDINGS);
+    draw_buildings(render_state, renderer);
+    END_PROFILE_ZONE(PROFILE_DRAW_BUILDINGS);
 
-    draw_buildings(game_state, renderer);
-    draw_ships(game_state, renderer);
-    draw_projectiles(game_state, renderer);
+    BEGIN_PROFILE_ZONE(PROFILE_DRAW_SHIPS);
+    draw_ships(render_state, renderer, alpha);
+    END_PROFILE_ZONE(PROFILE_DRAW_SHIPS);
+
+    BEGIN_PROFILE_ZONE(PROFILE_DRAW_PROJECTILES);
+    draw_projectiles(render_state, renderer, alpha);
+    END_PROFILE_ZONE(PROFILE_DRAW_PROJECTILES);
 
     view_projection_matrix = mat4_orthographic(0, screen_width, screen_height, 0, 0, 1);
     update_ubo(renderer->camera_ubo, sizeof(mat4), &view_projection_matrix);
 
+    BEGIN_PROFILE_ZONE(PROFILE_DRAW_SCREEN_QUADS);
     bind_program(renderer->quad_program);
     draw_screen_quad_buffer(&renderer->sprite_batch, render_buffer);
     bind_program(0);
+    END_PROFILE_ZONE(PROFILE_DRAW_SCREEN_QUADS);
 
+    BEGIN_PROFILE_ZONE(PROFILE_DRAW_TEXT);
     draw_frame_text_buffer(renderer, render_buffer);
+    END_PROFILE_ZONE(PROFILE_DRAW_TEXT);
+
+    END_PROFILE_ZONE(PROFILE_RENDER_GAME);
 }
@@ -1,10 +1,40 @@
 #pragma once
 
 #include "gx_define.h"
+#include "gx_arena.h"
 #include "gx_math.h"
+#include "gx_broadphase.h"
+#include "gx_bvh.h"
+#include "gx_occupancy.h"
+#include "gx_morton.h"
+#include "gx_hash.h"
+#include "gx_renderer.h"
+
+// make STRESS=1 sizes GameState for the large scenarios, 10k ships a side.
+// Snapshots and rewind copy the whole block, so normal builds stay small.
+// gx_broadphase.h and gx_bvh.h size their arrays to match.
+#ifdef GX_STRESS
+#define MAX_SHIPS          20480
+#define MAX_PROJECTILES    65536
+#define UINT_HASH_MAP_SIZE 65536
+#define MAX_BUILDINGS      256
+#else
+#define MAX_SHIPS          64
+#define MAX_PROJECTILES    256
+#define UINT_HASH_MAP_SIZE 4096
+#define MAX_BUILDINGS      64
+#endif
+
+#define MAX_PATH_NODES     32
+#define MAX_SELECTED_SHIPS 256
+
+// The map border's vertices plus four corners per building.
+#define MAX_VISIBILITY_VERTICES (16 + 4 * MAX_BUILDINGS)
+
+// Upper bound on collision workers; each owns an event buffer.
+#define MAX_SIMULATION_WORKERS 8
 
 struct Input;
-struct Renderer;
 
 struct UIntHashPair
 {
@@ -14,7 +44,7 @@ struct UIntHashPair
 
 struct UIntHashMap
 {
-    struct UIntHashPair buckets[4096];
+    struct UIntHashPair buckets[UINT_HASH_MAP_SIZE];
 };
 
 struct GameMemory
@@ -24,6 +54,22 @@ struct GameMemory
 
     void *render_memory;
     size_t render_memory_size;
+
+    // Page size game memory got, larger than the system's with huge pages.
+    size_t page_size;
+
+    // Carved out of game_memory. The permanent arena starts with GameState;
+    // snapshots and rewind only cover GameState, so anything pushed after it
+    // must be rebuilt from it. The transient arena holds scratch for a single
+    // tick and is empty between ticks.
+    struct MemoryArena permanent_arena;
+    struct MemoryArena transient_arena;
+
+    // Carved out of render_memory and owned by the main thread. The render
+    // arena starts with the RenderBuffer; the frame arena is scratch that is
+    // reset at the start of every frame.
+    struct MemoryArena render_arena;
+    struct MemoryArena frame_arena;
 };
 
 struct Camera
@@ -34,12 +80,18 @@ struct Camera
 
     vec2 move_velocity;
     float zoom_velocity;
+
+    // Transform at the start of the last tick, for render interpolation.
+    vec2 previous_position;
+    float previous_zoom;
 };
 
 enum ShipTeam
 {
     TEAM_ALLY,
     TEAM_ENEMY,
+
+    TEAM_COUNT,
 };
 
 enum UnitFlags
@@ -47,10 +99,99 @@ enum UnitFlags
     UNIT_MOVE_ORDER = 0x01,
 };
 
+// Simulation level of detail, reassigned every tick. Weapons reach any
+// distance, so every ship is active while the other team has ships; the
+// lower tiers only take ships with no enemy left. Distant ones (off screen)
+// move every DISTANT_TICK_INTERVAL ticks with the skipped time added on, but
+// reload every tick. Sleeping ones (idle a while: no order, not moving,
+// reloaded, no contact) skip movement, combat and the broadphase until an
+// order or contact wakes them.
+enum SimulationTier
+{
+    TIER_ACTIVE,
+    TIER_DISTANT,
+    TIER_SLEEPING,
+
+    SIMULATION_TIER_COUNT,
+};
+
+//
+// scenario
+//
+
+// What init_game builds. Everything random is drawn from the config's seed,
+// so a scenario and a seed always give the same game. Named presets are in
+// gx_scenario.h; a zeroed scenario is an empty map.
+
+enum BuildingLayout
+{
+    // Anywhere on the map, overlaps allowed.
+    BUILDING_LAYOUT_RANDOM,
+    // City blocks in rows and columns with streets between them.
+    BUILDING_LAYOUT_GRID,
+    // Scattered around a few random centers.
+    BUILDING_LAYOUT_CLUSTERED,
+
+    BUILDING_LAYOUT_COUNT,
+};
+
+enum InitialOrders
+{
+    ORDERS_HOLD,
+    // Straight at the enemy's starting position, pushing past buildings.
+    ORDERS_ADVANCE,
+    // To the same place along a find_path route.
+    ORDERS_ROUTE,
+
+    INITIAL_ORDERS_COUNT,
+};
+
+struct Scenario
+{
+    // Each team starts in rows facing the other across y = 0.
+    uint32 ship_counts[TEAM_COUNT];
+
+    // Share of ships armed with repeaters rather than cannons, 0 to 1.
+    // Repeaters fire several times as often, so projectile counts follow it.
+    float repeater_share;
+
+    uint8 orders;
+
+    uint32 building_count;
+    float building_size;
+    uint8 building_layout;
+
+    // Clustered layout only.
+    uint32 cluster_count;
+
+    // enum BroadphaseType for ship-ship collision. Sweep and prune suits
+    // sparse or loosely moving ships; dense formations moving along one axis
+    // swap endpoints every tick and are cheaper on the grid.
+    uint8 broadphase;
+};
+
+struct GameConfig
+{
+    uint32 seed;
+
+    // Number of collision workers, 1 to MAX_SIMULATION_WORKERS.
+    uint32 worker_count;
+
+    // Lockstep mode. Entity arrays keep creation order, and contacts are
+    // resolved in ship array order, so a tick depends only on the previous state and input.
+    bool deterministic;
+
+    struct Scenario scenario;
+};
+
+// GameState holds no pointers, so the block can be copied, hashed or mapped
+// from disk as is. Cross references are indices.
+
 struct Path
 {
+    // Indices into VisibilityGraph::nodes.
     // TODO: optimize space?
-    struct VisibilityNode *nodes[32];
+    uint32 node_indices[MAX_PATH_NODES];
     uint32 node_count;
     uint32 current_node_index;
 
@@ -69,6 +210,9 @@ struct Ship
     float rotation;
     vec2 size;
 
+    // Position at the start of the last tick, for render interpolation.
+    vec2 previous_position;
+
     vec2 move_velocity;
     float rotation_velocity;
 
@@ -79,12 +223,17 @@ struct Ship
     float fire_cooldown_timer;
 
     struct Path path;
-};
 
-struct AABB
-{
-    vec2 min;
-    vec2 max;
+    uint32 broadphase_proxy;
+
+    uint8 tier;
+
+    // Ticks in a row the ship has been idle; reset by orders, contacts and hits.
+    uint16 idle_ticks;
+
+    // Time not yet simulated while distant, and the time this tick steps.
+    float pending_dt;
+    float step_dt;
 };
 
 struct Projectile
@@ -96,12 +245,115 @@ struct Projectile
     vec2 position;
     vec2 size;
     vec2 velocity;
+
+    // Position at the start of the last tick, for render interpolation.
+    vec2 previous_position;
+
+    // Seconds until the projectile expires.
+    float lifetime;
+};
+
+//
+// Events are produced by the collision phase and applied by the resolve
+// phase of tick_physics. The buffers live in the transient arena for the
+// tick only; what outlives it is copied into TickStats.
+//
+
+enum ProjectileExpireReason
+{
+    PROJECTILE_EXPIRE_LIFETIME,
+    PROJECTILE_EXPIRE_BUILDING,
+};
+
+struct ProjectileHitEvent
+{
+    uint32 projectile_index;
+    uint32 ship_id;
+    uint32 owner_id;
+    vec2 position;
+};
+
+struct ShipDamageEvent
+{
+    uint32 ship_id;
+    uint32 source_id;
+    int32 damage;
+};
+
+struct ShipDeathEvent
+{
+    uint32 ship_id;
+    uint32 killer_id;
+    uint8 team;
+    vec2 position;
+};
+
+struct ProjectileExpiredEvent
+{
+    uint32 projectile_index;
+    uint8 reason;
+    vec2 position;
+};
+
+// Each projectile yields at most one hit, damage and expiration, and each
+// ship at most one death, so the arrays are sized from the counts the
+// buffer covers.
+struct EventBuffer
+{
+    uint32 projectile_capacity;
+    uint32 ship_capacity;
+
+    struct ProjectileHitEvent *hits;
+    uint32 hit_count;
+
+    struct ShipDamageEvent *damages;
+    uint32 damage_count;
+
+    struct ShipDeathEvent *deaths;
+    uint32 death_count;
+
+    struct ProjectileExpiredEvent *expirations;
+    uint32 expiration_count;
+
+    // Work done producing these events, for TickStats.
+    uint32 projectile_test_count;
+    uint32 building_query_count;
+    uint32 building_grid_hit_count;
+};
+
+// Transient arena tick_game needs: a megabyte for paths and the ship grid,
+// plus the worker and merged event buffers and the spent-projectile flags.
+#define GAME_TRANSIENT_SIZE (MEGABYTES(1) + \
+    2 * MAX_PROJECTILES * (sizeof(struct ProjectileHitEvent) + sizeof(struct ShipDamageEvent) + sizeof(struct ProjectileExpiredEvent)) + \
+    MAX_PROJECTILES * sizeof(bool) + MAX_SHIPS * sizeof(struct ShipDeathEvent))
+
+// What the last tick did, for telemetry. Not part of the state hash.
+struct TickStats
+{
+    // Broadphase pairs checked exactly, and those pushed apart.
+    uint32 pair_tests;
+    uint32 pairs_resolved;
+
+    // Projectile-ship AABB tests, and hits.
+    uint32 projectile_tests;
+    uint32 projectile_hits;
+
+    uint32 path_requests;
+    uint32 path_nodes_expanded;
+
+    // Projectile-building queries, and those the occupancy grid answered
+    // without reaching the BVH.
+    uint32 building_queries;
+    uint32 building_grid_hits;
 };
 
 struct WorkingPathNode
 {
-    struct VisibilityNode *node;
-    struct WorkingPathNode *parent;
+    // Index into VisibilityGraph::nodes.
+    uint32 node_index;
+
+    // Index into the closed list, UINT32_MAX for the starting node.
+    uint32 parent_index;
 
     float f_cost;
     float g_cost;
@@ -113,16 +365,16 @@ struct VisibilityNode
     uint32 vertex_index;
 
     // TODO: linked list if memory becomes an issue?
-    uint32 neighbor_indices[64];
+    uint32 neighbor_indices[MAX_VISIBILITY_VERTICES];
     uint32 neighbor_index_count;
 };
 
 struct VisibilityGraph
 {
-    vec2 vertices[4096];
+    vec2 vertices[MAX_VISIBILITY_VERTICES];
     uint32 vertex_count;
 
-    struct VisibilityNode nodes[4096];
+    struct VisibilityNode nodes[MAX_VISIBILITY_VERTICES];
     uint32 node_count;
 };
 
@@ -136,39 +388,172 @@ struct GameState
 {
     struct Camera camera;
 
+    uint32 tick_count;
+
+    bool deterministic;
+    struct Random random;
+
+    // Hash of the simulation state after the last tick.
+    uint64 state_hash;
+
 
     //
     // map
     //
 
+    // Everything from here up to 'ships' is built by init_game and read-only
+    // afterwards (see get_static_state_range()).
     struct VisibilityGraph visibility_graph;
 
-    struct Building buildings[64];
+    struct Building buildings[MAX_BUILDINGS];
     uint32 building_count;
 
+    // Built once the map is loaded; buildings never move.
+    struct BVH building_bvh;
+    struct OccupancyGrid building_occupancy;
+
 
     //
     // ship
     //
 
-    struct Ship ships[64];
+    struct Ship ships[MAX_SHIPS];
     uint32 ship_count;
 
     uint32 ship_ids;
     struct UIntHashMap ship_id_map;
 
-    uint32 selected_ships[256];
+    uint32 selected_ships[MAX_SELECTED_SHIPS];
     uint32 selected_ship_count;
 
+    // find_path calls since the game started.
+    uint32 path_request_count;
+
+    // Ships per SimulationTier in the last tick.
+    uint32 tier_counts[SIMULATION_TIER_COUNT];
+
+    struct Broadphase ship_broadphase;
+    struct SortKey pair_sort_keys[MAX_BROADPHASE_PAIRS];
+    struct SortKey pair_sort_scratch[MAX_BROADPHASE_PAIRS];
+
 
     //
     // projectile
     //
 
-    struct Projectile projectiles[256];
+    struct Projectile projectiles[MAX_PROJECTILES];
+    uint32 projectile_count;
+
+
+    //
+    // spatial sort
+    //
+
+    // Swap-removes since ships and projectiles were last sorted by Morton key.
+    uint32 removals_since_spatial_sort;
+
+    struct SortKey sort_keys[MAX_PROJECTILES];
+    struct SortKey sort_scratch[MAX_PROJECTILES];
+
+
+    //
+    // events
+    //
+
+    // Collision work is split into this many contiguous ranges. Each worker
+    // appends only to its own buffer, so no locking is needed.
+    uint32 worker_count;
+
+    struct TickStats stats;
+};
+
+//
+// render state
+//
+
+// Everything render_game draws, copied out of GameState after each tick so
+// the renderer never reads memory the simulation is writing.
+
+struct RenderEntity
+{
+    vec2 position;
+    vec2 previous_position;
+    vec2 size;
+};
+
+struct RenderPath
+{
+    vec2 start;
+    vec2 end;
+
+    // World positions of the path's visibility graph nodes.
+    vec2 nodes[MAX_PATH_NODES];
+    uint32 node_count;
+    uint32 current_node_index;
+};
+
+struct RenderSelectedShip
+{
+    struct RenderEntity entity;
+
+    bool has_path;
+    struct RenderPath path;
+};
+
+struct RenderState
+{
+    uint32 tick_count;
+
+    struct Camera camera;
+
+    struct Building buildings[MAX_BUILDINGS];
+    uint32 building_count;
+
+    struct RenderEntity ships[MAX_SHIPS];
+    uint32 ship_count;
+
+    struct RenderEntity projectiles[MAX_PROJECTILES];
     uint32 projectile_count;
+
+    struct RenderSelectedShip selected_ships[MAX_SELECTED_SHIPS];
+    uint32 selected_ship_count;
+
+    // For the performance overlay.
+    uint32 collision_pair_count;
+    uint32 path_request_count;
 };
 
-void init_game(struct GameMemory *memory);
+void init_game(struct GameMemory *memory, struct GameConfig *config);
+
+// Byte range of GameState that init_game fills and nothing writes afterwards.
+void get_static_state_range(size_t *offset, size_t *size);
+
+// sizeof(struct GameState) as compiled into the game library. A reload whose
+// layout differs from the running one cannot reuse the memory block.
+size_t get_game_state_size(void);
+
 void tick_game(struct GameMemory *memory, struct Input *input, uint32 screen_width, uint32 screen_height, float dt);
-void render_game(struct GameMemory *memory, struct Renderer *renderer, uint32 screen_width, uint32 screen_height);
+
+// 'alpha' is how far the frame lies between the previous tick and the
+// latest one, 0 to 1. Ships, projectiles and the camera are drawn blended
+// between the two, so motion stays smooth when ticks are rarer than frames.
+void render_game(struct RenderState *render_state, struct RenderBuffer *render_buffer, struct Renderer *renderer, uint32 screen_width, uint32 screen_height, float alpha);
+
+// Fills 'render_state' from the state after the last tick.
+void copy_render_state(struct GameMemory *memory, struct RenderState *render_state);
+
+// Queues the selection box, selected ship outlines and their paths into
+// 'render_buffer' for render_game. Runs once per rendered frame, reading
+// only the published state and the latest input, so it costs the same no
+// matter how many ticks ran and can overlap the next tick.
+void extract_render_buffer(struct RenderState *render_state, struct Input *input, struct RenderBuffer *render_buffer, float alpha);
+
+// The entry points above as the platform layer sees them once the game is
+// loaded from a shared library.
+typedef void init_game_function(struct GameMemory *memory, struct GameConfig *config);
+typedef void get_static_state_range_function(size_t *offset, size_t *size);
+typedef size_t get_game_state_size_function(void);
+typedef void tick_game_function(struct GameMemory *memory, struct Input *input, uint32 screen_width, uint32 screen_height, float dt);
+typedef void render_game_function(struct RenderState *render_state, struct RenderBuffer *render_buffer, struct Renderer *renderer, uint32 screen_width, uint32 screen_height, float alpha);
+typedef void copy_render_state_function(struct GameMemory *memory, struct RenderState *render_state);
+typedef void extract_render_buffer_function(struct RenderState *render_state, struct Input *input, struct RenderBuffer *render_buffer, float alpha);
@@ -0,0 +1,128 @@
+#include "gx_alloc_check.h"
+
+#ifdef GX_ALLOC_CHECK
+
+#include <execinfo.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// glibc's own entry points, so the replacements below can forward without
+// looking anything up (dlsym itself allocates).
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void __libc_free(void *pointer);
+
+#define MAX_OFFENDER_FRAMES 32
+
+struct AllocationOffender
+{
+    const char *function;
+    size_t size;
+    enum AllocationPhase phase;
+
+    void *frames[MAX_OFFENDER_FRAMES];
+    int frame_count;
+};
+
+static const char *phase_names[ALLOCATION_PHASE_COUNT] = { "none", "input", "tick", "render" };
+
+static _Thread_local enum AllocationPhase current_phase;
+
+// Set while capturing a stack; backtrace() allocates the first time it runs.
+static _Thread_local bool in_check;
+
+static _Atomic bool armed;
+static _Atomic uint64 call_counts[ALLOCATION_PHASE_COUNT];
+static _Atomic uint64 armed_call_counts[ALLOCATION_PHASE_COUNT];
+
+static _Atomic bool has_offender;
+static struct AllocationOffender first_offender;
+
+static void check_allocation(const char *function, size_t size)
+{
+    enum AllocationPhase phase = current_phase;
+    if ((phase == ALLOCATION_PHASE_NONE) || in_check)
+        return;
+
+    atomic_fetch_add_explicit(&call_counts[phase], 1, memory_order_relaxed);
+    if (!atomic_load_explicit(&armed, memory_order_relaxed))
+        return;
+
+    atomic_fetch_add_explicit(&armed_call_counts[phase], 1, memory_order_relaxed);
+
+    bool expected = false;
+    if (atomic_compare_exchange_strong(&has_offender, &expected, true))
+    {
+        in_check = true;
+        first_offender.function = function;
+        first_offender.size = size;
+        first_offender.phase = phase;
+        first_offender.frame_count = backtrace(first_offender.frames, MAX_OFFENDER_FRAMES);
+        in_check = false;
+    }
+}
+
+void *malloc(size_t size)
+{
+    check_allocation("malloc", size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    check_allocation("calloc", count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    check_allocation("realloc", size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer)
+{
+    if (pointer)
+        check_allocation("free", 0);
+    __libc_free(pointer);
+}
+
+void set_allocation_phase(enum AllocationPhase phase)
+{
+    current_phase = phase;
+}
+
+void arm_allocation_check(void)
+{
+    // Let backtrace() load what it needs now rather than inside the first offender.
+    void *frames[1];
+    in_check = true;
+    backtrace(frames, 1);
+    in_check = false;
+
+    atomic_store(&armed, true);
+}
+
+bool report_allocation_check(void)
+{
+    fprintf(stderr, "Heap calls per phase (after warm-up):");
+    for (uint32 i = ALLOCATION_PHASE_INPUT; i < ALLOCATION_PHASE_COUNT; ++i)
+    {
+        fprintf(stderr, " %s %llu (%llu)", phase_names[i],
+                (unsigned long long)atomic_load(&call_counts[i]), (unsigned long long)atomic_load(&armed_call_counts[i]));
+    }
+    fprintf(stderr, ".\n");
+
+    if (!atomic_load(&has_offender))
+        return true;
+
+    // backtrace_symbols_fd() writes straight to the descriptor without allocating.
+    fprintf(stderr, "[ERROR] %s(%zu) during the %s phase after warm-up:\n",
+            first_offender.function, first_offender.size, phase_names[first_offender.phase]);
+    backtrace_symbols_fd(first_offender.frames, first_offender.frame_count, STDERR_FILENO);
+    return false;
+}
+
+#endif
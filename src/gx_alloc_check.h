@@ -0,0 +1,46 @@
+#pragma once
+
+#include "gx_define.h"
+
+//
+// Heap allocation checking, built with make ALLOC_CHECK=1. malloc, calloc,
+// realloc and free are replaced for the whole process and each call is
+// counted against the phase the calling thread is in. Once armed, the first
+// call in any phase is kept with its stack, since the tick and render phases
+// should only use the arenas in steady state. Without ALLOC_CHECK all of this
+// compiles to nothing.
+//
+
+// Ticks or frames to run before arming; caches and lazily grown buffers in
+// libc and the driver settle in this time.
+#define ALLOCATION_WARMUP_TICKS 60
+
+enum AllocationPhase
+{
+    // Not counted: startup, shutdown and anything between phases.
+    ALLOCATION_PHASE_NONE,
+
+    ALLOCATION_PHASE_INPUT,
+    ALLOCATION_PHASE_TICK,
+    ALLOCATION_PHASE_RENDER,
+
+    ALLOCATION_PHASE_COUNT,
+};
+
+#ifdef GX_ALLOC_CHECK
+
+// Per thread, so the simulation thread and the main thread count separately.
+void set_allocation_phase(enum AllocationPhase phase);
+void arm_allocation_check(void);
+
+// Prints the counts per phase and the stack of the first call after arming.
+// Returns false if there was one.
+bool report_allocation_check(void);
+
+#else
+
+static inline void set_allocation_phase(enum AllocationPhase phase) {}
+static inline void arm_allocation_check(void) {}
+static inline bool report_allocation_check(void) { return true; }
+
+#endif
@@ -0,0 +1,67 @@
+#include "gx_arena.h"
+
+#include <string.h>
+
+void init_arena(struct MemoryArena *arena, const char *name, void *base, size_t size)
+{
+    memset(arena, 0, sizeof(*arena));
+    arena->name = name;
+    arena->base = (uint8 *)base;
+    arena->size = size;
+}
+
+void reset_arena(struct MemoryArena *arena)
+{
+    ASSERT(arena->temp_count == 0);
+    arena->used = 0;
+}
+
+void *push_size(struct MemoryArena *arena, size_t size, size_t alignment)
+{
+    ASSERT((alignment > 0) && ((alignment & (alignment - 1)) == 0));
+
+    uintptr_t address = (uintptr_t)arena->base + arena->used;
+    size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+    if (arena->size - arena->used < padding + size)
+    {
+        fprintf(stderr, "[ERROR] Arena '%s' is out of memory: %zu bytes requested, %zu of %zu KB used.\n",
+                arena->name, size, arena->used / 1024, arena->size / 1024);
+        ASSERT(false);
+    }
+
+    uint8 *memory = arena->base + arena->used + padding;
+    arena->used += padding + size;
+    if (arena->used > arena->peak)
+        arena->peak = arena->used;
+
+    // Scratch memory is reused every tick and frame, so it is never zero on its own.
+    memset(memory, 0, size);
+    return memory;
+}
+
+struct TempArena begin_temp_arena(struct MemoryArena *arena)
+{
+    struct TempArena temp;
+    temp.arena = arena;
+    temp.used = arena->used;
+    ++arena->temp_count;
+    return temp;
+}
+
+void end_temp_arena(struct TempArena temp)
+{
+    struct MemoryArena *arena = temp.arena;
+    ASSERT(arena->temp_count > 0);
+    ASSERT(arena->used >= temp.used);
+
+    arena->used = temp.used;
+    --arena->temp_count;
+}
+
+void print_arena_usage(struct MemoryArena *arena)
+{
+    fprintf(stderr, "Arena '%s': peak %.1f of %.1f KB (%.1f%%).\n",
+            arena->name, (double)arena->peak / 1024.0, (double)arena->size / 1024.0,
+            (arena->size > 0) ? 100.0 * (double)arena->peak / (double)arena->size : 0.0);
+}
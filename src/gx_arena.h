@@ -0,0 +1,47 @@
+#pragma once
+
+#include "gx_define.h"
+
+//
+// Linear allocators over a fixed block. Pushes bump a pointer, nothing is
+// freed individually; a temporary scope rolls the arena back to where it
+// began, and a reset empties it.
+//
+
+struct MemoryArena
+{
+    const char *name;
+
+    uint8 *base;
+    size_t size;
+    size_t used;
+
+    // Highest 'used' seen, for sizing the blocks.
+    size_t peak;
+
+    // Open temporary scopes; a reset with scopes open is a bug.
+    uint32 temp_count;
+};
+
+struct TempArena
+{
+    struct MemoryArena *arena;
+    size_t used;
+};
+
+void init_arena(struct MemoryArena *arena, const char *name, void *base, size_t size);
+void reset_arena(struct MemoryArena *arena);
+
+// Zeroed memory aligned to 'alignment', a power of two. Running out is fatal:
+// arenas are sized up front from the peak usage report.
+void *push_size(struct MemoryArena *arena, size_t size, size_t alignment);
+
+#define push_struct(arena, type)       ((type *)push_size((arena), sizeof(type), _Alignof(type)))
+#define push_array(arena, type, count) ((type *)push_size((arena), (count) * sizeof(type), _Alignof(type)))
+
+// Everything pushed between begin and end is released by end. Scopes nest
+// and must end in reverse order.
+struct TempArena begin_temp_arena(struct MemoryArena *arena);
+void end_temp_arena(struct TempArena temp);
+
+void print_arena_usage(struct MemoryArena *arena);
@@ -0,0 +1,483 @@
+#include "gx_broadphase.h"
+
+#include <math.h>
+#include <string.h>
+
+#define EMPTY_PAIR_KEY UINT64_MAX
+
+static uint64 make_pair_key(uint32 a, uint32 b)
+{
+    if (a > b)
+    {
+        uint32 temp = a;
+        a = b;
+        b = temp;
+    }
+
+    return ((uint64)a << 32) | (uint64)b;
+}
+
+static void add_pair(struct Broadphase *broadphase, uint32 a, uint32 b)
+{
+    ASSERT(broadphase->pair_count < ARRAY_SIZE(broadphase->pairs));
+
+    struct BroadphasePair *pair = &broadphase->pairs[broadphase->pair_count++];
+    pair->a = min_uint32(a, b);
+    pair->b = max_uint32(a, b);
+}
+
+
+//
+// sweep and prune pair set
+//
+
+static uint32 hash_pair_key(uint64 key)
+{
+    // 64-bit finalizer from MurmurHash3.
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (uint32)key;
+}
+
+static struct SweepPairSlot *find_pair_slot(struct SweepAndPrune *sap, uint64 key)
+{
+    const uint32 mask = ARRAY_SIZE(sap->pair_slots) - 1;
+
+    uint32 slot = hash_pair_key(key) & mask;
+    while (sap->pair_slots[slot].key != EMPTY_PAIR_KEY)
+    {
+        if (sap->pair_slots[slot].key == key)
+            return &sap->pair_slots[slot];
+
+        slot = (slot + 1) & mask;
+    }
+
+    return NULL;
+}
+
+static void add_sweep_pair(struct Broadphase *broadphase, uint32 a, uint32 b)
+{
+    struct SweepAndPrune *sap = &broadphase->sap;
+    const uint32 mask = ARRAY_SIZE(sap->pair_slots) - 1;
+
+    uint64 key = make_pair_key(a, b);
+
+    uint32 slot = hash_pair_key(key) & mask;
+    while (sap->pair_slots[slot].key != EMPTY_PAIR_KEY)
+    {
+        // Pair already exists.
+        if (sap->pair_slots[slot].key == key)
+            return;
+
+        slot = (slot + 1) & mask;
+    }
+
+    sap->pair_slots[slot].key = key;
+    sap->pair_slots[slot].pair_index = broadphase->pair_count;
+
+    add_pair(broadphase, a, b);
+}
+
+static void remove_sweep_pair(struct Broadphase *broadphase, uint32 a, uint32 b)
+{
+    struct SweepAndPrune *sap = &broadphase->sap;
+    const uint32 mask = ARRAY_SIZE(sap->pair_slots) - 1;
+
+    struct SweepPairSlot *removed = find_pair_slot(sap, make_pair_key(a, b));
+    if (removed == NULL)
+        return;
+
+    uint32 pair_index = removed->pair_index;
+
+    // Shift following slots in the probe sequence back into the hole.
+    uint32 hole = (uint32)(removed - sap->pair_slots);
+    uint32 slot = (hole + 1) & mask;
+    while (sap->pair_slots[slot].key != EMPTY_PAIR_KEY)
+    {
+        uint32 ideal = hash_pair_key(sap->pair_slots[slot].key) & mask;
+        if (((slot - ideal) & mask) >= ((slot - hole) & mask))
+        {
+            sap->pair_slots[hole] = sap->pair_slots[slot];
+            hole = slot;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    sap->pair_slots[hole].key = EMPTY_PAIR_KEY;
+
+    // Swap the removed pair with the last pair in the array.
+    uint32 last_index = broadphase->pair_count - 1;
+    if (pair_index != last_index)
+    {
+        struct BroadphasePair last = broadphase->pairs[last_index];
+        broadphase->pairs[pair_index] = last;
+
+        struct SweepPairSlot *last_slot = find_pair_slot(sap, make_pair_key(last.a, last.b));
+        ASSERT_NOT_NULL(last_slot);
+        last_slot->pair_index = pair_index;
+    }
+
+    --broadphase->pair_count;
+}
+
+
+//
+// sweep and prune
+//
+
+static float endpoint_value(struct Broadphase *broadphase, uint32 axis, uint32 endpoint_proxy)
+{
+    struct AABB *aabb = &broadphase->proxies[endpoint_proxy & ~SWEEP_ENDPOINT_MAX].aabb;
+    if (endpoint_proxy & SWEEP_ENDPOINT_MAX)
+        return aabb->max.v[axis];
+    else
+        return aabb->min.v[axis];
+}
+
+static bool endpoint_less(struct SweepEndpoint a, struct SweepEndpoint b)
+{
+    if (a.value != b.value)
+        return a.value < b.value;
+
+    // Touching boxes do not overlap, so max endpoints sort before min endpoints.
+    return (a.proxy & SWEEP_ENDPOINT_MAX) && !(b.proxy & SWEEP_ENDPOINT_MAX);
+}
+
+static void insert_sweep_proxy(struct Broadphase *broadphase, uint32 proxy)
+{
+    struct SweepAndPrune *sap = &broadphase->sap;
+    ASSERT(sap->endpoint_count + 2 <= ARRAY_SIZE(sap->endpoints[0]));
+
+    // New endpoints start at the end of each axis, i.e. past every other proxy.
+    // The next update sorts them into place and reports their overlaps.
+    for (uint32 axis = 0; axis < 2; ++axis)
+    {
+        struct SweepEndpoint *endpoints = sap->endpoints[axis];
+        endpoints[sap->endpoint_count + 0].value = FLOAT_MAX;
+        endpoints[sap->endpoint_count + 0].proxy = proxy;
+        endpoints[sap->endpoint_count + 1].value = FLOAT_MAX;
+        endpoints[sap->endpoint_count + 1].proxy = proxy | SWEEP_ENDPOINT_MAX;
+    }
+
+    sap->endpoint_count += 2;
+}
+
+static void remove_sweep_proxy(struct Broadphase *broadphase, uint32 proxy)
+{
+    struct SweepAndPrune *sap = &broadphase->sap;
+
+    for (uint32 axis = 0; axis < 2; ++axis)
+    {
+        struct SweepEndpoint *endpoints = sap->endpoints[axis];
+
+        uint32 kept = 0;
+        for (uint32 i = 0; i < sap->endpoint_count; ++i)
+        {
+            if ((endpoints[i].proxy & ~SWEEP_ENDPOINT_MAX) != proxy)
+                endpoints[kept++] = endpoints[i];
+        }
+
+        ASSERT(kept == sap->endpoint_count - 2);
+    }
+
+    sap->endpoint_count -= 2;
+
+    for (uint32 i = 0; i < broadphase->pair_count;)
+    {
+        struct BroadphasePair pair = broadphase->pairs[i];
+        if ((pair.a == proxy) || (pair.b == proxy))
+            remove_sweep_pair(broadphase, pair.a, pair.b);
+        else
+            ++i;
+    }
+}
+
+static void sort_sweep_axis(struct Broadphase *broadphase, uint32 axis)
+{
+    struct SweepAndPrune *sap = &broadphase->sap;
+    struct SweepEndpoint *endpoints = sap->endpoints[axis];
+
+    for (uint32 i = 0; i < sap->endpoint_count; ++i)
+        endpoints[i].value = endpoint_value(broadphase, axis, endpoints[i].proxy);
+
+    for (uint32 i = 1; i < sap->endpoint_count; ++i)
+    {
+        struct SweepEndpoint moving = endpoints[i];
+        uint32 moving_proxy = moving.proxy & ~SWEEP_ENDPOINT_MAX;
+        bool moving_is_max = moving.proxy & SWEEP_ENDPOINT_MAX;
+
+        uint32 j = i;
+        while ((j > 0) && endpoint_less(moving, endpoints[j - 1]))
+        {
+            struct SweepEndpoint passed = endpoints[j - 1];
+            uint32 passed_proxy = passed.proxy & ~SWEEP_ENDPOINT_MAX;
+            bool passed_is_max = passed.proxy & SWEEP_ENDPOINT_MAX;
+
+            ++broadphase->tested_pair_count;
+
+            if (moving_proxy == passed_proxy)
+            {
+                // Degenerate box; nothing to report.
+            }
+            else if (!moving_is_max && passed_is_max)
+            {
+                // A min moved below another max, so the intervals start overlapping on
+                // this axis. Proxy AABBs are already up to date, so test every axis.
+                struct AABB a = broadphase->proxies[moving_proxy].aabb;
+                struct AABB b = broadphase->proxies[passed_proxy].aabb;
+                if (aabb_aabb_intersection(a, b))
+                    add_sweep_pair(broadphase, moving_proxy, passed_proxy);
+            }
+            else if (moving_is_max && !passed_is_max)
+            {
+                // A max moved below another min, so the intervals stopped overlapping.
+                // The x pass has already dropped every pair whose x intervals
+                // separated, so on y only boxes still overlapping on x can have
+                // one. Crowds passing each other swap most y endpoints of boxes
+                // that are nowhere near on x, and this skips the lookup for those.
+                struct AABB a = broadphase->proxies[moving_proxy].aabb;
+                struct AABB b = broadphase->proxies[passed_proxy].aabb;
+                if ((axis == 0) || ((a.max.x > b.min.x) && (a.min.x < b.max.x)))
+                    remove_sweep_pair(broadphase, moving_proxy, passed_proxy);
+            }
+
+            endpoints[j] = passed;
+            --j;
+        }
+
+        endpoints[j] = moving;
+    }
+}
+
+static void update_sweep_and_prune(struct Broadphase *broadphase)
+{
+    sort_sweep_axis(broadphase, 0);
+    sort_sweep_axis(broadphase, 1);
+}
+
+
+//
+// brute force
+//
+
+static void update_brute_force(struct Broadphase *broadphase)
+{
+    broadphase->pair_count = 0;
+
+    for (uint32 i = 0; i < broadphase->proxy_count; ++i)
+    {
+        struct BroadphaseProxy *a = &broadphase->proxies[i];
+        if (!a->active)
+            continue;
+
+        for (uint32 j = i + 1; j < broadphase->proxy_count; ++j)
+        {
+            struct BroadphaseProxy *b = &broadphase->proxies[j];
+            if (!b->active)
+                continue;
+
+            ++broadphase->tested_pair_count;
+
+            if (aabb_aabb_intersection(a->aabb, b->aabb))
+                add_pair(broadphase, i, j);
+        }
+    }
+}
+
+
+//
+// grid
+//
+
+static int32 grid_cell(struct BroadphaseGrid *grid, float value)
+{
+    return (int32)floorf(value / grid->cell_size);
+}
+
+static uint32 grid_bucket(int32 cell_x, int32 cell_y)
+{
+    uint32 hash = ((uint32)cell_x * 73856093u) ^ ((uint32)cell_y * 19349663u);
+    return hash % BROADPHASE_GRID_BUCKET_COUNT;
+}
+
+static void update_grid(struct Broadphase *broadphase)
+{
+    struct BroadphaseGrid *grid = &broadphase->grid;
+
+    broadphase->pair_count = 0;
+    grid->entry_count = 0;
+
+    // Insert every proxy into each cell it touches.
+    for (uint32 i = 0; i < broadphase->proxy_count; ++i)
+    {
+        struct BroadphaseProxy *proxy = &broadphase->proxies[i];
+        if (!proxy->active)
+            continue;
+
+        int32 min_x = grid_cell(grid, proxy->aabb.min.x);
+        int32 min_y = grid_cell(grid, proxy->aabb.min.y);
+        int32 max_x = grid_cell(grid, proxy->aabb.max.x);
+        int32 max_y = grid_cell(grid, proxy->aabb.max.y);
+
+        for (int32 y = min_y; y <= max_y; ++y)
+        {
+            for (int32 x = min_x; x <= max_x; ++x)
+            {
+                ASSERT(grid->entry_count < ARRAY_SIZE(grid->entries));
+                struct GridEntry *entry = &grid->entries[grid->entry_count++];
+                entry->proxy = i;
+                entry->cell_x = x;
+                entry->cell_y = y;
+            }
+        }
+    }
+
+    // Counting sort the entries by bucket.
+    memset(grid->bucket_offsets, 0, sizeof(grid->bucket_offsets));
+    for (uint32 i = 0; i < grid->entry_count; ++i)
+        ++grid->bucket_offsets[grid_bucket(grid->entries[i].cell_x, grid->entries[i].cell_y) + 1];
+    for (uint32 i = 1; i <= BROADPHASE_GRID_BUCKET_COUNT; ++i)
+        grid->bucket_offsets[i] += grid->bucket_offsets[i - 1];
+
+    uint32 bucket_cursors[BROADPHASE_GRID_BUCKET_COUNT];
+    memcpy(bucket_cursors, grid->bucket_offsets, sizeof(bucket_cursors));
+    for (uint32 i = 0; i < grid->entry_count; ++i)
+    {
+        uint32 bucket = grid_bucket(grid->entries[i].cell_x, grid->entries[i].cell_y);
+        grid->sorted_entries[bucket_cursors[bucket]++] = grid->entries[i];
+    }
+
+    // Test proxies that share a cell.
+    for (uint32 bucket = 0; bucket < BROADPHASE_GRID_BUCKET_COUNT; ++bucket)
+    {
+        uint32 begin = grid->bucket_offsets[bucket];
+        uint32 end = grid->bucket_offsets[bucket + 1];
+
+        for (uint32 i = begin; i < end; ++i)
+        {
+            struct GridEntry *ea = &grid->sorted_entries[i];
+            struct AABB a = broadphase->proxies[ea->proxy].aabb;
+
+            for (uint32 j = i + 1; j < end; ++j)
+            {
+                struct GridEntry *eb = &grid->sorted_entries[j];
+
+                // Different cells hashed into the same bucket.
+                if ((ea->cell_x != eb->cell_x) || (ea->cell_y != eb->cell_y))
+                    continue;
+                if (ea->proxy == eb->proxy)
+                    continue;
+
+                struct AABB b = broadphase->proxies[eb->proxy].aabb;
+
+                ++broadphase->tested_pair_count;
+
+                if (!aabb_aabb_intersection(a, b))
+                    continue;
+
+                // Only report the pair from the cell containing the min corner of the
+                // overlap region so pairs sharing several cells are reported once.
+                int32 owner_x = grid_cell(grid, max_float(a.min.x, b.min.x));
+                int32 owner_y = grid_cell(grid, max_float(a.min.y, b.min.y));
+                if ((owner_x == ea->cell_x) && (owner_y == ea->cell_y))
+                    add_pair(broadphase, ea->proxy, eb->proxy);
+            }
+        }
+    }
+}
+
+
+//
+// interface
+//
+
+void init_broadphase(struct Broadphase *broadphase, enum BroadphaseType type, float grid_cell_size)
+{
+    memset(broadphase, 0, sizeof(*broadphase));
+
+    broadphase->type = type;
+    broadphase->first_free_proxy = NULL_BROADPHASE_PROXY;
+
+    for (uint32 i = 0; i < ARRAY_SIZE(broadphase->sap.pair_slots); ++i)
+        broadphase->sap.pair_slots[i].key = EMPTY_PAIR_KEY;
+
+    ASSERT(grid_cell_size > 0.0f);
+    broadphase->grid.cell_size = grid_cell_size;
+}
+
+uint32 create_broadphase_proxy(struct Broadphase *broadphase, struct AABB aabb, uint32 user_id)
+{
+    uint32 index;
+    if (broadphase->first_free_proxy != NULL_BROADPHASE_PROXY)
+    {
+        index = broadphase->first_free_proxy;
+        broadphase->first_free_proxy = broadphase->proxies[index].next_free;
+    }
+    else
+    {
+        ASSERT(broadphase->proxy_count < ARRAY_SIZE(broadphase->proxies));
+        index = broadphase->proxy_count++;
+    }
+
+    struct BroadphaseProxy *proxy = &broadphase->proxies[index];
+    proxy->aabb = aabb;
+    proxy->user_id = user_id;
+    proxy->active = true;
+    proxy->next_free = NULL_BROADPHASE_PROXY;
+
+    if (broadphase->type == BROADPHASE_SWEEP_AND_PRUNE)
+        insert_sweep_proxy(broadphase, index);
+
+    return index;
+}
+
+void destroy_broadphase_proxy(struct Broadphase *broadphase, uint32 proxy)
+{
+    ASSERT(proxy < broadphase->proxy_count);
+    ASSERT(broadphase->proxies[proxy].active);
+
+    if (broadphase->type == BROADPHASE_SWEEP_AND_PRUNE)
+        remove_sweep_proxy(broadphase, proxy);
+
+    broadphase->proxies[proxy].active = false;
+    broadphase->proxies[proxy].next_free = broadphase->first_free_proxy;
+    broadphase->first_free_proxy = proxy;
+}
+
+void move_broadphase_proxy(struct Broadphase *broadphase, uint32 proxy, struct AABB aabb)
+{
+    ASSERT(proxy < broadphase->proxy_count);
+    ASSERT(broadphase->proxies[proxy].active);
+
+    broadphase->proxies[proxy].aabb = aabb;
+}
+
+void update_broadphase(struct Broadphase *broadphase)
+{
+    broadphase->tested_pair_count = 0;
+
+    switch (broadphase->type)
+    {
+        case BROADPHASE_BRUTE_FORCE:
+            update_brute_force(broadphase);
+            break;
+        case BROADPHASE_SWEEP_AND_PRUNE:
+            update_sweep_and_prune(broadphase);
+            break;
+        case BROADPHASE_GRID:
+            update_grid(broadphase);
+            break;
+        default:
+            ASSERT(false);
+    }
+}
+
+const char *broadphase_type_name(enum BroadphaseType type)
+{
+    if ((uint32)type >= BROADPHASE_TYPE_COUNT)
+        return "unknown";
+
+    return broadphase_type_names[type];
+}
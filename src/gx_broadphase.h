@@ -0,0 +1,136 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_math.h"
+
+// Stress builds hold a proxy per ship at MAX_SHIPS (see gx.h). The pair
+// count must stay a power of two.
+#ifdef GX_STRESS
+#define MAX_BROADPHASE_PROXIES 32768
+#define MAX_BROADPHASE_PAIRS   131072
+#else
+#define MAX_BROADPHASE_PROXIES 4096
+#define MAX_BROADPHASE_PAIRS   16384
+#endif
+
+#define NULL_BROADPHASE_PROXY UINT32_MAX
+
+enum BroadphaseType
+{
+    BROADPHASE_BRUTE_FORCE,
+    BROADPHASE_SWEEP_AND_PRUNE,
+    BROADPHASE_GRID,
+
+    BROADPHASE_TYPE_COUNT,
+};
+
+// In enum order. Defined here rather than in gx_broadphase.c so tools that
+// parse scenarios can use it without linking the game library.
+static const char *const broadphase_type_names[BROADPHASE_TYPE_COUNT] = { "brute_force", "sweep_and_prune", "grid" };
+
+struct BroadphaseProxy
+{
+    struct AABB aabb;
+
+    // Caller-defined identifier, e.g. a ship ID.
+    uint32 user_id;
+
+    bool active;
+    uint32 next_free;
+};
+
+// Proxy indices of an overlapping pair, a < b.
+struct BroadphasePair
+{
+    uint32 a;
+    uint32 b;
+};
+
+
+//
+// sweep and prune
+//
+
+// The high bit of 'proxy' marks a max endpoint.
+#define SWEEP_ENDPOINT_MAX 0x80000000u
+
+struct SweepEndpoint
+{
+    float value;
+    uint32 proxy;
+};
+
+struct SweepPairSlot
+{
+    // Packed (a << 32 | b), or UINT64_MAX if the slot is empty.
+    uint64 key;
+    uint32 pair_index;
+};
+
+struct SweepAndPrune
+{
+    // Endpoints stay sorted between updates, so each update is an
+    // insertion sort over nearly-sorted data. Swaps during the sort
+    // add and remove pairs from the persistent pair set.
+    struct SweepEndpoint endpoints[2][MAX_BROADPHASE_PROXIES * 2];
+    uint32 endpoint_count;
+
+    // Open addressing with backward shift deletion.
+    struct SweepPairSlot pair_slots[MAX_BROADPHASE_PAIRS * 2];
+};
+
+
+//
+// grid
+//
+
+#define BROADPHASE_GRID_BUCKET_COUNT 4096
+#define BROADPHASE_GRID_MAX_ENTRIES  (MAX_BROADPHASE_PROXIES * 4)
+
+struct GridEntry
+{
+    uint32 proxy;
+    int32 cell_x;
+    int32 cell_y;
+};
+
+struct BroadphaseGrid
+{
+    float cell_size;
+
+    struct GridEntry entries[BROADPHASE_GRID_MAX_ENTRIES];
+    struct GridEntry sorted_entries[BROADPHASE_GRID_MAX_ENTRIES];
+    uint32 entry_count;
+
+    uint32 bucket_offsets[BROADPHASE_GRID_BUCKET_COUNT + 1];
+};
+
+
+struct Broadphase
+{
+    enum BroadphaseType type;
+
+    struct BroadphaseProxy proxies[MAX_BROADPHASE_PROXIES];
+    uint32 proxy_count;
+    uint32 first_free_proxy;
+
+    struct BroadphasePair pairs[MAX_BROADPHASE_PAIRS];
+    uint32 pair_count;
+
+    // Number of AABB tests performed by the last update.
+    uint32 tested_pair_count;
+
+    struct SweepAndPrune sap;
+    struct BroadphaseGrid grid;
+};
+
+void init_broadphase(struct Broadphase *broadphase, enum BroadphaseType type, float grid_cell_size);
+
+uint32 create_broadphase_proxy(struct Broadphase *broadphase, struct AABB aabb, uint32 user_id);
+void destroy_broadphase_proxy(struct Broadphase *broadphase, uint32 proxy);
+void move_broadphase_proxy(struct Broadphase *broadphase, uint32 proxy, struct AABB aabb);
+
+// Recomputes broadphase->pairs from the current proxy AABBs.
+void update_broadphase(struct Broadphase *broadphase);
+
+const char *broadphase_type_name(enum BroadphaseType type);
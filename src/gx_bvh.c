@@ -0,0 +1,344 @@
+#include "gx_bvh.h"
+
+#define BVH_STACK_SIZE 64
+
+struct BVHBin
+{
+    struct AABB aabb;
+    uint32 count;
+};
+
+static float aabb_perimeter(struct AABB aabb)
+{
+    vec2 size = vec2_sub(aabb.max, aabb.min);
+    return 2.0f * (size.x + size.y);
+}
+
+static vec2 aabb_center(struct AABB aabb)
+{
+    return vec2_div(vec2_add(aabb.min, aabb.max), 2.0f);
+}
+
+static struct AABB empty_aabb(void)
+{
+    struct AABB aabb;
+    aabb.min = vec2_scalar(FLOAT_MAX);
+    aabb.max = vec2_scalar(-FLOAT_MAX);
+    return aabb;
+}
+
+static void swap_primitives(struct BVH *bvh, uint32 a, uint32 b)
+{
+    struct AABB temp_aabb = bvh->primitive_aabbs[a];
+    bvh->primitive_aabbs[a] = bvh->primitive_aabbs[b];
+    bvh->primitive_aabbs[b] = temp_aabb;
+
+    uint32 temp_index = bvh->primitive_indices[a];
+    bvh->primitive_indices[a] = bvh->primitive_indices[b];
+    bvh->primitive_indices[b] = temp_index;
+}
+
+static uint32 calc_bin(float centroid, float min, float inv_extent)
+{
+    uint32 bin = (uint32)((centroid - min) * inv_extent * BVH_BIN_COUNT);
+    return min_uint32(bin, BVH_BIN_COUNT - 1);
+}
+
+static void subdivide_bvh_node(struct BVH *bvh, uint32 node_index)
+{
+    struct BVHNode *node = &bvh->nodes[node_index];
+    if (node->count <= MAX_BVH_LEAF_SIZE)
+        return;
+
+    uint32 first = node->first;
+    uint32 count = node->count;
+
+    struct AABB centroid_bounds = empty_aabb();
+    for (uint32 i = first; i < first + count; ++i)
+    {
+        vec2 center = aabb_center(bvh->primitive_aabbs[i]);
+        centroid_bounds.min = min_vec2(centroid_bounds.min, center);
+        centroid_bounds.max = max_vec2(centroid_bounds.max, center);
+    }
+
+    // Find the cheapest bin boundary on either axis.
+    float best_cost = aabb_perimeter(node->aabb) * (float)count;
+    uint32 best_axis = UINT32_MAX;
+    uint32 best_split = 0;
+
+    for (uint32 axis = 0; axis < 2; ++axis)
+    {
+        float extent = centroid_bounds.max.v[axis] - centroid_bounds.min.v[axis];
+        if (extent <= 0.0f)
+            continue;
+
+        float inv_extent = 1.0f / extent;
+
+        struct BVHBin bins[BVH_BIN_COUNT];
+        for (uint32 i = 0; i < BVH_BIN_COUNT; ++i)
+        {
+            bins[i].aabb = empty_aabb();
+            bins[i].count = 0;
+        }
+
+        for (uint32 i = first; i < first + count; ++i)
+        {
+            struct AABB aabb = bvh->primitive_aabbs[i];
+            uint32 bin = calc_bin(aabb_center(aabb).v[axis], centroid_bounds.min.v[axis], inv_extent);
+            bins[bin].aabb = aabb_union(bins[bin].aabb, aabb);
+            ++bins[bin].count;
+        }
+
+        // Sweep from the right to get the cost of everything past each boundary.
+        float right_costs[BVH_BIN_COUNT];
+        struct AABB right_aabb = empty_aabb();
+        uint32 right_count = 0;
+        for (uint32 i = BVH_BIN_COUNT - 1; i > 0; --i)
+        {
+            right_aabb = aabb_union(right_aabb, bins[i].aabb);
+            right_count += bins[i].count;
+            right_costs[i] = (right_count > 0) ? aabb_perimeter(right_aabb) * (float)right_count : 0.0f;
+        }
+
+        struct AABB left_aabb = empty_aabb();
+        uint32 left_count = 0;
+        for (uint32 i = 0; i < BVH_BIN_COUNT - 1; ++i)
+        {
+            left_aabb = aabb_union(left_aabb, bins[i].aabb);
+            left_count += bins[i].count;
+
+            if ((left_count == 0) || (left_count == count))
+                continue;
+
+            float cost = aabb_perimeter(left_aabb) * (float)left_count + right_costs[i + 1];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = i + 1;
+            }
+        }
+    }
+
+    // Partition primitives around the chosen boundary.
+    uint32 left_count = 0;
+    if (best_axis != UINT32_MAX)
+    {
+        float min = centroid_bounds.min.v[best_axis];
+        float inv_extent = 1.0f / (centroid_bounds.max.v[best_axis] - min);
+
+        uint32 i = first;
+        uint32 j = first + count;
+        while (i < j)
+        {
+            if (calc_bin(aabb_center(bvh->primitive_aabbs[i]).v[best_axis], min, inv_extent) < best_split)
+                ++i;
+            else
+                swap_primitives(bvh, i, --j);
+        }
+
+        left_count = i - first;
+    }
+    else
+    {
+        // Splitting does not pay off or all centroids coincide. Keep small
+        // nodes as leaves, otherwise split down the middle.
+        if (count <= MAX_BVH_LEAF_SIZE * 2)
+            return;
+
+        left_count = count / 2;
+    }
+
+    ASSERT((left_count > 0) && (left_count < count));
+    ASSERT(bvh->node_count + 2 <= ARRAY_SIZE(bvh->nodes));
+
+    uint32 left_index = bvh->node_count;
+    bvh->node_count += 2;
+
+    struct BVHNode *left = &bvh->nodes[left_index];
+    struct BVHNode *right = &bvh->nodes[left_index + 1];
+
+    left->first = first;
+    left->count = left_count;
+    right->first = first + left_count;
+    right->count = count - left_count;
+
+    left->aabb = empty_aabb();
+    for (uint32 i = left->first; i < left->first + left->count; ++i)
+        left->aabb = aabb_union(left->aabb, bvh->primitive_aabbs[i]);
+
+    right->aabb = empty_aabb();
+    for (uint32 i = right->first; i < right->first + right->count; ++i)
+        right->aabb = aabb_union(right->aabb, bvh->primitive_aabbs[i]);
+
+    node->first = left_index;
+    node->count = 0;
+
+    subdivide_bvh_node(bvh, left_index);
+    subdivide_bvh_node(bvh, left_index + 1);
+}
+
+void build_bvh(struct BVH *bvh, struct AABB *aabbs, uint32 count)
+{
+    ASSERT(count <= ARRAY_SIZE(bvh->primitive_aabbs));
+
+    bvh->primitive_count = count;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        bvh->primitive_aabbs[i] = aabbs[i];
+        bvh->primitive_indices[i] = i;
+    }
+
+    struct BVHNode *root = &bvh->nodes[0];
+    bvh->node_count = 1;
+
+    root->first = 0;
+    root->count = count;
+    root->aabb = empty_aabb();
+    for (uint32 i = 0; i < count; ++i)
+        root->aabb = aabb_union(root->aabb, aabbs[i]);
+
+    subdivide_bvh_node(bvh, 0);
+}
+
+static struct AABB pad_aabb(struct AABB aabb, float padding)
+{
+    vec2 half_padding = vec2_scalar(padding / 2.0f);
+    aabb.min = vec2_sub(aabb.min, half_padding);
+    aabb.max = vec2_add(aabb.max, half_padding);
+    return aabb;
+}
+
+bool bvh_raycast(struct BVH *bvh, vec2 origin, vec2 direction, float max_t, struct RaycastHit *hit)
+{
+    if (bvh->primitive_count == 0)
+        return false;
+
+    float closest_t = max_t;
+    bool found = false;
+
+    uint32 stack[BVH_STACK_SIZE];
+    uint32 stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        struct BVHNode *node = &bvh->nodes[stack[--stack_size]];
+
+        float node_t;
+        if (!ray_aabb_intersection(node->aabb, origin, direction, closest_t, &node_t))
+            continue;
+
+        if (node->count > 0)
+        {
+            for (uint32 i = node->first; i < node->first + node->count; ++i)
+            {
+                float t;
+                if (ray_aabb_intersection(bvh->primitive_aabbs[i], origin, direction, closest_t, &t))
+                {
+                    closest_t = t;
+                    hit->index = bvh->primitive_indices[i];
+                    hit->t = t;
+                    found = true;
+                }
+            }
+
+            continue;
+        }
+
+        // Visit the child whose center is closer along the ray first.
+        struct BVHNode *left = &bvh->nodes[node->first];
+        struct BVHNode *right = &bvh->nodes[node->first + 1];
+        float left_distance = vec2_dot(vec2_sub(aabb_center(left->aabb), origin), direction);
+        float right_distance = vec2_dot(vec2_sub(aabb_center(right->aabb), origin), direction);
+
+        ASSERT(stack_size + 2 <= BVH_STACK_SIZE);
+        if (left_distance < right_distance)
+        {
+            stack[stack_size++] = node->first + 1;
+            stack[stack_size++] = node->first;
+        }
+        else
+        {
+            stack[stack_size++] = node->first;
+            stack[stack_size++] = node->first + 1;
+        }
+    }
+
+    return found;
+}
+
+bool bvh_segment_blocked(struct BVH *bvh, vec2 start, vec2 end, float padding)
+{
+    if (bvh->primitive_count == 0)
+        return false;
+
+    vec2 direction = vec2_sub(end, start);
+
+    uint32 stack[BVH_STACK_SIZE];
+    uint32 stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        struct BVHNode *node = &bvh->nodes[stack[--stack_size]];
+
+        float t;
+        if (!ray_aabb_intersection(pad_aabb(node->aabb, padding), start, direction, 1.0f, &t))
+            continue;
+
+        if (node->count > 0)
+        {
+            for (uint32 i = node->first; i < node->first + node->count; ++i)
+            {
+                if (ray_aabb_intersection(pad_aabb(bvh->primitive_aabbs[i], padding), start, direction, 1.0f, &t))
+                    return true;
+            }
+
+            continue;
+        }
+
+        ASSERT(stack_size + 2 <= BVH_STACK_SIZE);
+        stack[stack_size++] = node->first;
+        stack[stack_size++] = node->first + 1;
+    }
+
+    return false;
+}
+
+uint32 bvh_overlap_aabb(struct BVH *bvh, struct AABB aabb, uint32 *results, uint32 max_results)
+{
+    if (bvh->primitive_count == 0)
+        return 0;
+
+    uint32 result_count = 0;
+
+    uint32 stack[BVH_STACK_SIZE];
+    uint32 stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while ((stack_size > 0) && (result_count < max_results))
+    {
+        struct BVHNode *node = &bvh->nodes[stack[--stack_size]];
+        if (!aabb_aabb_intersection(node->aabb, aabb))
+            continue;
+
+        if (node->count > 0)
+        {
+            for (uint32 i = node->first; (i < node->first + node->count) && (result_count < max_results); ++i)
+            {
+                if (aabb_aabb_intersection(bvh->primitive_aabbs[i], aabb))
+                    results[result_count++] = bvh->primitive_indices[i];
+            }
+
+            continue;
+        }
+
+        // Push the right child first so the left subtree is visited first.
+        ASSERT(stack_size + 2 <= BVH_STACK_SIZE);
+        stack[stack_size++] = node->first + 1;
+        stack[stack_size++] = node->first;
+    }
+
+    return result_count;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_math.h"
+
+// The BVH holds one primitive per building, MAX_BUILDINGS (see gx.h).
+#ifdef GX_STRESS
+#define MAX_BVH_PRIMITIVES 256
+#else
+#define MAX_BVH_PRIMITIVES 64
+#endif
+
+#define MAX_BVH_LEAF_SIZE  2
+#define BVH_BIN_COUNT      16
+
+struct BVHNode
+{
+    struct AABB aabb;
+
+    // Interior nodes (count == 0) store their left child index in 'first';
+    // the right child is always first + 1. Leaves store the index of their
+    // first primitive.
+    uint32 first;
+    uint32 count;
+};
+
+// Static bounding volume hierarchy built with binned SAH.
+struct BVH
+{
+    // Every leaf holds at least one primitive, so a binary tree over N has at most 2N - 1 nodes.
+    struct BVHNode nodes[2 * MAX_BVH_PRIMITIVES - 1];
+    uint32 node_count;
+
+    // Primitive AABBs and caller indices, reordered so each leaf's primitives are contiguous.
+    struct AABB primitive_aabbs[MAX_BVH_PRIMITIVES];
+    uint32 primitive_indices[MAX_BVH_PRIMITIVES];
+    uint32 primitive_count;
+};
+
+struct RaycastHit
+{
+    // Caller index of the primitive that was hit.
+    uint32 index;
+
+    // Hit distance in units of the ray direction.
+    float t;
+};
+
+void build_bvh(struct BVH *bvh, struct AABB *aabbs, uint32 count);
+
+// Closest primitive hit by origin + direction * t, 0 <= t <= max_t.
+bool bvh_raycast(struct BVH *bvh, vec2 origin, vec2 direction, float max_t, struct RaycastHit *hit);
+
+// Whether the segment touches any primitive grown by 'padding' (total, not per side).
+bool bvh_segment_blocked(struct BVH *bvh, vec2 start, vec2 end, float padding);
+
+// Writes up to 'max_results' caller indices of primitives overlapping 'aabb'.
+uint32 bvh_overlap_aabb(struct BVH *bvh, struct AABB aabb, uint32 *results, uint32 max_results);
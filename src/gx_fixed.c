@@ -0,0 +1,213 @@
+#include "gx_fixed.h"
+
+// atan(z) on [0, 1], minimax polynomial in z^2 (max error ~1e-5 rad).
+#define ATAN_C1  65527
+#define ATAN_C3 -21647
+#define ATAN_C5  11806
+#define ATAN_C7  -5579
+#define ATAN_C9   1365
+
+fixed fixed_from_float(float value)
+{
+    // Multiplying by a power of two is exact; the rounding add is the only
+    // inexact step and it is IEEE round-to-nearest like everything else.
+    float scaled = value * (float)FIXED_ONE;
+    if (!(scaled == scaled))
+        return 0;
+    if (scaled >= 2147483520.0f)
+        return FIXED_MAX;
+    if (scaled <= -2147483648.0f)
+        return FIXED_MIN;
+
+    scaled += (scaled >= 0.0f) ? 0.5f : -0.5f;
+    return (fixed)scaled;
+}
+
+float fixed_to_float(fixed value)
+{
+    return (float)value * (1.0f / (float)FIXED_ONE);
+}
+
+fixed fixed_from_int(int32 value)
+{
+    return (fixed)((int64)value * FIXED_ONE);
+}
+
+float wide_to_float(int64 value)
+{
+    return (float)value * (1.0f / 4294967296.0f);
+}
+
+fixed fixed_mul(fixed a, fixed b)
+{
+    int64 product = (int64)a * (int64)b;
+    return (fixed)((product + (1 << (FIXED_SHIFT - 1))) >> FIXED_SHIFT);
+}
+
+fixed fixed_div(fixed a, fixed b)
+{
+    ASSERT(b != 0);
+    return (fixed)(((int64)a * FIXED_ONE) / b);
+}
+
+fixed fixed_abs(fixed value)
+{
+    return (value < 0) ? -value : value;
+}
+
+fixed fixed_sqrt_wide(uint64 value)
+{
+    // Bit-by-bit integer square root. sqrt(v * 2^32) = sqrt(v) * 2^16, so a
+    // Q32.32 input comes out as Q16.16.
+    if (value == 0)
+        return 0;
+
+    // Start at the highest even bit position at or below the top set bit.
+    uint64 result = 0;
+    uint64 bit = 1ull << ((63 - __builtin_clzll(value)) & ~1);
+
+    // Branchless; the branchy version mispredicts on roughly every other bit.
+    while (bit != 0)
+    {
+        uint64 trial = result + bit;
+        uint64 mask = (uint64)0 - (uint64)(value >= trial);
+        value -= trial & mask;
+        result = (result >> 1) + (bit & mask);
+        bit >>= 2;
+    }
+
+    return (result > (uint64)FIXED_MAX) ? FIXED_MAX : (fixed)result;
+}
+
+fixed fixed_sqrt(fixed value)
+{
+    ASSERT(value >= 0);
+    return fixed_sqrt_wide((uint64)value << FIXED_SHIFT);
+}
+
+fixed fixed_sin(fixed radians)
+{
+    // Reduce to [-pi, pi], then fold into [-pi/2, pi/2] where the series converges fast.
+    fixed x = radians % FIXED_TWO_PI;
+    if (x > FIXED_PI)
+        x -= FIXED_TWO_PI;
+    else if (x < -FIXED_PI)
+        x += FIXED_TWO_PI;
+
+    if (x > FIXED_PI_OVER_TWO)
+        x = FIXED_PI - x;
+    else if (x < -FIXED_PI_OVER_TWO)
+        x = -FIXED_PI - x;
+
+    // Taylor series through x^9, error below one Q16.16 step at pi/2.
+    fixed x2 = fixed_mul(x, x);
+    fixed t = FIXED_ONE - x2 / 72;
+    t = FIXED_ONE - fixed_mul(x2, t) / 42;
+    t = FIXED_ONE - fixed_mul(x2, t) / 20;
+    t = FIXED_ONE - fixed_mul(x2, t) / 6;
+    return fixed_mul(x, t);
+}
+
+fixed fixed_cos(fixed radians)
+{
+    return fixed_sin((fixed)(((int64)radians + FIXED_PI_OVER_TWO) % FIXED_TWO_PI));
+}
+
+fixed fixed_atan2(fixed y, fixed x)
+{
+    if ((x == 0) && (y == 0))
+        return 0;
+
+    fixed ax = fixed_abs(x);
+    fixed ay = fixed_abs(y);
+    bool steep = ay > ax;
+    fixed z = steep ? fixed_div(ax, ay) : fixed_div(ay, ax);
+
+    fixed z2 = fixed_mul(z, z);
+    fixed p = ATAN_C7 + fixed_mul(z2, ATAN_C9);
+    p = ATAN_C5 + fixed_mul(z2, p);
+    p = ATAN_C3 + fixed_mul(z2, p);
+    p = ATAN_C1 + fixed_mul(z2, p);
+    fixed angle = fixed_mul(z, p);
+
+    if (steep)
+        angle = FIXED_PI_OVER_TWO - angle;
+    if (x < 0)
+        angle = FIXED_PI - angle;
+    if (y < 0)
+        angle = -angle;
+
+    return angle;
+}
+
+fixed2 fixed2_new(fixed x, fixed y)
+{
+    fixed2 result;
+    result.x = x;
+    result.y = y;
+    return result;
+}
+
+fixed2 fixed2_from_floats(float x, float y)
+{
+    return fixed2_new(fixed_from_float(x), fixed_from_float(y));
+}
+
+fixed2 fixed2_add(fixed2 a, fixed2 b)
+{
+    return fixed2_new(a.x + b.x, a.y + b.y);
+}
+
+fixed2 fixed2_sub(fixed2 a, fixed2 b)
+{
+    return fixed2_new(a.x - b.x, a.y - b.y);
+}
+
+fixed2 fixed2_mul(fixed2 v, fixed s)
+{
+    return fixed2_new(fixed_mul(v.x, s), fixed_mul(v.y, s));
+}
+
+fixed2 fixed2_div(fixed2 v, fixed s)
+{
+    return fixed2_new(fixed_div(v.x, s), fixed_div(v.y, s));
+}
+
+int64 fixed2_dot(fixed2 a, fixed2 b)
+{
+    return (int64)a.x * b.x + (int64)a.y * b.y;
+}
+
+int64 fixed2_length2(fixed2 v)
+{
+    return fixed2_dot(v, v);
+}
+
+fixed fixed2_length(fixed2 v)
+{
+    return fixed_sqrt_wide((uint64)fixed2_length2(v));
+}
+
+fixed2 fixed2_normalize(fixed2 v)
+{
+    // Unlike the float path, a zero vector stays zero instead of turning into NaNs.
+    fixed length = fixed2_length(v);
+    if (length == 0)
+        return fixed2_new(0, 0);
+
+    // One divide instead of two. |component| <= length, so the products stay
+    // within 2^48.
+    int64 inv_length = ((int64)1 << 48) / length;
+    return fixed2_new((fixed)(((int64)v.x * inv_length) >> 32), (fixed)(((int64)v.y * inv_length) >> 32));
+}
+
+fixed fixed2_distance(fixed2 a, fixed2 b)
+{
+    return fixed2_length(fixed2_sub(a, b));
+}
+
+fixed2 fixed2_direction(fixed rotation)
+{
+    fixed angle = (fixed)(((int64)rotation + FIXED_PI_OVER_TWO) % FIXED_TWO_PI);
+    return fixed2_normalize(fixed2_new(fixed_cos(angle), fixed_sin(angle)));
+}
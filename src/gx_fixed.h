@@ -0,0 +1,62 @@
+#pragma once
+
+#include "gx_define.h"
+
+//
+// Q16.16 fixed point. Integer-only, so results are bit-identical on every
+// compiler and CPU. Building with GX_FIXED_POINT routes the vec2 functions
+// in gx_math through these.
+//
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE   (1 << FIXED_SHIFT)
+#define FIXED_MAX   INT32_MAX
+#define FIXED_MIN   INT32_MIN
+
+#define FIXED_PI          205887
+#define FIXED_PI_OVER_TWO 102944
+#define FIXED_TWO_PI      411775
+
+typedef int32 fixed;
+
+typedef struct
+{
+    fixed x, y;
+} fixed2;
+
+fixed fixed_from_float(float value);
+float fixed_to_float(fixed value);
+fixed fixed_from_int(int32 value);
+
+fixed fixed_mul(fixed a, fixed b);
+fixed fixed_div(fixed a, fixed b);
+fixed fixed_abs(fixed value);
+
+// Square root of a Q32.32 value, as Q16.16. Lets squared lengths skip the
+// Q16.16 range, which overflows past ~181 units.
+fixed fixed_sqrt_wide(uint64 value);
+fixed fixed_sqrt(fixed value);
+
+fixed fixed_sin(fixed radians);
+fixed fixed_cos(fixed radians);
+fixed fixed_atan2(fixed y, fixed x);
+
+fixed2 fixed2_new(fixed x, fixed y);
+fixed2 fixed2_from_floats(float x, float y);
+
+fixed2 fixed2_add(fixed2 a, fixed2 b);
+fixed2 fixed2_sub(fixed2 a, fixed2 b);
+fixed2 fixed2_mul(fixed2 v, fixed s);
+fixed2 fixed2_div(fixed2 v, fixed s);
+
+// Dot products and squared lengths are returned as Q32.32.
+int64 fixed2_dot(fixed2 a, fixed2 b);
+int64 fixed2_length2(fixed2 v);
+
+fixed  fixed2_length(fixed2 v);
+fixed2 fixed2_normalize(fixed2 v);
+fixed  fixed2_distance(fixed2 a, fixed2 b);
+
+fixed2 fixed2_direction(fixed rotation);
+
+float wide_to_float(int64 value);
@@ -0,0 +1,154 @@
+#include "gx_hash.h"
+
+#include <string.h>
+
+#define PRIME64_1 11400714785074694791ull
+#define PRIME64_2 14029467366897019727ull
+#define PRIME64_3 1609587929392839161ull
+#define PRIME64_4 9650029242287828579ull
+#define PRIME64_5 2870177450012600261ull
+
+static uint64 rotate_left(uint64 x, uint32 r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64 read_uint64(const uint8 *p)
+{
+    uint64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32 read_uint32(const uint8 *p)
+{
+    uint32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64 hash_round(uint64 accumulator, uint64 input)
+{
+    accumulator += input * PRIME64_2;
+    accumulator = rotate_left(accumulator, 31);
+    accumulator *= PRIME64_1;
+    return accumulator;
+}
+
+static uint64 merge_round(uint64 accumulator, uint64 value)
+{
+    value = hash_round(0, value);
+    accumulator ^= value;
+    accumulator = accumulator * PRIME64_1 + PRIME64_4;
+    return accumulator;
+}
+
+struct Hash begin_hash(uint64 seed)
+{
+    struct Hash hash = {0};
+    hash.seed = seed;
+    hash.v[0] = seed + PRIME64_1 + PRIME64_2;
+    hash.v[1] = seed + PRIME64_2;
+    hash.v[2] = seed;
+    hash.v[3] = seed - PRIME64_1;
+    return hash;
+}
+
+void update_hash(struct Hash *hash, const void *data, size_t size)
+{
+    const uint8 *p = (const uint8 *)data;
+    const uint8 *end = p + size;
+
+    hash->total_length += size;
+
+    // Not enough for a full stripe yet.
+    if (hash->buffer_size + size < 32)
+    {
+        memcpy(hash->buffer + hash->buffer_size, p, size);
+        hash->buffer_size += (uint32)size;
+        return;
+    }
+
+    // Complete the buffered stripe.
+    if (hash->buffer_size > 0)
+    {
+        uint32 fill = 32 - hash->buffer_size;
+        memcpy(hash->buffer + hash->buffer_size, p, fill);
+        for (uint32 i = 0; i < 4; ++i)
+            hash->v[i] = hash_round(hash->v[i], read_uint64(hash->buffer + i * 8));
+
+        p += fill;
+        hash->buffer_size = 0;
+    }
+
+    while (p + 32 <= end)
+    {
+        for (uint32 i = 0; i < 4; ++i)
+            hash->v[i] = hash_round(hash->v[i], read_uint64(p + i * 8));
+
+        p += 32;
+    }
+
+    if (p < end)
+    {
+        memcpy(hash->buffer, p, end - p);
+        hash->buffer_size = (uint32)(end - p);
+    }
+}
+
+uint64 end_hash(struct Hash *hash)
+{
+    uint64 h;
+    if (hash->total_length >= 32)
+    {
+        h = rotate_left(hash->v[0], 1) + rotate_left(hash->v[1], 7) + rotate_left(hash->v[2], 12) + rotate_left(hash->v[3], 18);
+        for (uint32 i = 0; i < 4; ++i)
+            h = merge_round(h, hash->v[i]);
+    }
+    else
+    {
+        h = hash->seed + PRIME64_5;
+    }
+
+    h += hash->total_length;
+
+    const uint8 *p = hash->buffer;
+    const uint8 *end = p + hash->buffer_size;
+
+    while (p + 8 <= end)
+    {
+        h ^= hash_round(0, read_uint64(p));
+        h = rotate_left(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+
+    if (p + 4 <= end)
+    {
+        h ^= (uint64)read_uint32(p) * PRIME64_1;
+        h = rotate_left(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+
+    while (p < end)
+    {
+        h ^= (*p) * PRIME64_5;
+        h = rotate_left(h, 11) * PRIME64_1;
+        ++p;
+    }
+
+    // Avalanche.
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+uint64 hash_bytes(const void *data, size_t size, uint64 seed)
+{
+    struct Hash hash = begin_hash(seed);
+    update_hash(&hash, data, size);
+    return end_hash(&hash);
+}
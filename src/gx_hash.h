@@ -0,0 +1,20 @@
+#pragma once
+
+#include "gx_define.h"
+
+// Streaming XXH64.
+struct Hash
+{
+    uint64 total_length;
+    uint64 seed;
+    uint64 v[4];
+
+    uint8 buffer[32];
+    uint32 buffer_size;
+};
+
+struct Hash begin_hash(uint64 seed);
+void update_hash(struct Hash *hash, const void *data, size_t size);
+uint64 end_hash(struct Hash *hash);
+
+uint64 hash_bytes(const void *data, size_t size, uint64 seed);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gx_define.h"
+#include "gx_arena.h"
 #include "gx_math.h"
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
@@ -13,8 +14,8 @@ struct File
     size_t size;
 };
 
-struct File load_file(const char *path);
-void free_file(struct File *file);
+// The contents are pushed onto 'arena', NUL terminated, and live as long as it does.
+struct File load_file(const char *path, struct MemoryArena *arena);
 
 struct Input
 {
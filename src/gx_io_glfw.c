@@ -0,0 +1,48 @@
+// GLFW-facing half of the input layer. Kept separate from gx_io.c so the
+// simulation and headless tools link without a window system.
+
+#include "gx_io.h"
+
+void scroll_wheel_callback(GLFWwindow *window, double dx, double dy)
+{
+    // TODO: larger user pointer struct?
+    struct Input *input = (struct Input *)glfwGetWindowUserPointer(window);
+
+    float previous_scroll_wheel = input->scroll_wheel;
+    input->scroll_wheel += (float)dy;
+    input->scroll_delta = input->scroll_wheel - previous_scroll_wheel;
+}
+
+void wrap_cursor(GLFWwindow *window, struct Input *input, uint32 width, uint32 height)
+{
+    input->mouse_position.x = ((int32)input->mouse_position.x + width) % width;
+    input->mouse_position.y = ((int32)input->mouse_position.y + height) % height;
+    glfwSetCursorPos(window, input->mouse_position.x, input->mouse_position.y);
+}
+
+void process_input(GLFWwindow *window, struct Input *input)
+{
+    for (uint32 i = 0; i < ARRAY_SIZE(input->keys); ++i)
+    {
+        input->keys[i] <<= 1;
+
+        if (glfwGetKey(window, i) == GLFW_PRESS)
+            input->keys[i] |= 0x01;
+    }
+
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    input->mouse_delta = vec2_sub(input->mouse_position, vec2_new(x, y));
+    input->mouse_position = vec2_new(x, y);
+
+    for (uint32 i = 0; i < ARRAY_SIZE(input->mouse_buttons); ++i)
+    {
+        input->mouse_buttons[i] <<= 1;
+
+        if (glfwGetMouseButton(window, i) == GLFW_PRESS)
+            input->mouse_buttons[i] |= 0x01;
+
+        if (mouse_down_new(i, input))
+            input->mouse_down_positions[i] = input->mouse_position;
+    }
+}
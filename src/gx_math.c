@@ -1,4 +1,5 @@
 #include "gx_math.h"
+#include "gx_fixed.h"
 
 #include <math.h>
 #include <x86intrin.h> // rdtsc()
@@ -8,10 +9,6 @@
 
 // TODO: OPTIMIZE ALL OF THIS!
 
-struct Random
-{
-    uint32 x, y, z, w;
-};
 static struct Random global_random;
 
 float degrees_to_radians(float degrees)
@@ -99,11 +96,25 @@ float clamp_float(float value, float min, float max)
     return min_float(max_float(value, min), max);
 }
 
+float lerp_float(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
+
 float abs_float(float value)
 {
     return (value < 0) ? -value : value;
 }
 
+float sqrt_float(float value)
+{
+#ifdef GX_FIXED_POINT
+    return fixed_to_float(fixed_sqrt(fixed_from_float(value)));
+#else
+    return sqrtf(value);
+#endif
+}
+
 vec3 calc_normal(vec3 v0, vec3 v1, vec3 v2)
 {
     const vec3 d0 = vec3_sub(v1, v0);
@@ -112,30 +123,24 @@ vec3 calc_normal(vec3 v0, vec3 v1, vec3 v2)
     return vec3_normalize(normal);
 }
 
-static struct Random create_random(void)
+struct Random create_random(uint32 seed)
 {
     struct Random random = {0};
 
     random.x = 123456789;
     random.y = 362436069;
     random.z = 521288629;
-    random.w = 88675123;
+    random.w = seed;
 
     return random;
 }
 
-static void random_seed(struct Random *random, uint32 seed)
-{
-    random->w = seed;
-}
-
 void init_random(uint32 seed)
 {
-    global_random = create_random();
-    random_seed(&global_random, seed);
+    global_random = create_random(seed);
 }
 
-static uint32 random_xorshift(struct Random *random)
+uint32 random_uint32_r(struct Random *random)
 {
     uint32 t = random->x ^ (random->x << 15);
     random->x = random->y;
@@ -145,6 +150,24 @@ static uint32 random_xorshift(struct Random *random)
     return random->w;
 }
 
+float random_r(struct Random *random)
+{
+    uint32 ri = random_uint32_r(random);
+    return (float)ri / (float)UINT32_MAX;
+}
+
+int32 random_int_r(struct Random *random, int32 min, int32 max)
+{
+    ASSERT(max > min);
+    return min + (int32)(random_r(random) * (max - min));
+}
+
+float random_float_r(struct Random *random, float min, float max)
+{
+    ASSERT(max > min);
+    return min + (float)(random_r(random) * (max - min));
+}
+
 uint64 rdtsc(void)
 {
     return __rdtsc();
@@ -152,20 +175,17 @@ uint64 rdtsc(void)
 
 float random(void)
 {
-    uint32 ri = random_xorshift(&global_random);
-    return (float)ri / (float)UINT32_MAX;
+    return random_r(&global_random);
 }
 
 int32 random_int(int32 min, int32 max)
 {
-    ASSERT(max > min);
-    return min + (int32)(random() * (max - min));
+    return random_int_r(&global_random, min, max);
 }
 
 float random_float(float min, float max)
 {
-    ASSERT(max > min);
-    return min + (float)(random() * (max - min));
+    return random_float_r(&global_random, min, max);
 }
 
 float noise(float x, float y, float z)
@@ -249,6 +269,77 @@ vec2 vec2_from_vec3(vec3 v)
     return vec2_new(v.x, v.y);
 }
 
+#ifdef GX_FIXED_POINT
+
+// Every result is computed in Q16.16 and converted back, so it lands on the
+// fixed-point grid no matter how the float inputs were produced.
+static fixed2 to_fixed2(vec2 v)
+{
+    return fixed2_from_floats(v.x, v.y);
+}
+
+static vec2 from_fixed2(fixed2 v)
+{
+    return vec2_new(fixed_to_float(v.x), fixed_to_float(v.y));
+}
+
+vec2 vec2_add(vec2 a, vec2 b)
+{
+    return from_fixed2(fixed2_add(to_fixed2(a), to_fixed2(b)));
+}
+
+vec2 vec2_sub(vec2 a, vec2 b)
+{
+    return from_fixed2(fixed2_sub(to_fixed2(a), to_fixed2(b)));
+}
+
+vec2 vec2_mul(vec2 v, float s)
+{
+    return from_fixed2(fixed2_mul(to_fixed2(v), fixed_from_float(s)));
+}
+
+vec2 vec2_div(vec2 v, float s)
+{
+    return from_fixed2(fixed2_div(to_fixed2(v), fixed_from_float(s)));
+}
+
+float vec2_dot(vec2 a, vec2 b)
+{
+    return wide_to_float(fixed2_dot(to_fixed2(a), to_fixed2(b)));
+}
+
+float vec2_length(vec2 v)
+{
+    return fixed_to_float(fixed2_length(to_fixed2(v)));
+}
+
+float vec2_length2(vec2 v)
+{
+    return wide_to_float(fixed2_length2(to_fixed2(v)));
+}
+
+vec2 vec2_normalize(vec2 v)
+{
+    return from_fixed2(fixed2_normalize(to_fixed2(v)));
+}
+
+float vec2_distance(vec2 a, vec2 b)
+{
+    return fixed_to_float(fixed2_distance(to_fixed2(a), to_fixed2(b)));
+}
+
+float vec2_distance2(vec2 a, vec2 b)
+{
+    return wide_to_float(fixed2_length2(fixed2_sub(to_fixed2(a), to_fixed2(b))));
+}
+
+vec2 vec2_direction(float rotation)
+{
+    return from_fixed2(fixed2_direction(fixed_from_float(rotation)));
+}
+
+#else
+
 vec2 vec2_add(vec2 a, vec2 b)
 {
     vec2 result;
@@ -278,22 +369,6 @@ vec2 vec2_div(vec2 v, float s)
     return vec2_mul(v, 1.0f / s);
 }
 
-vec2 vec2_negate(vec2 v)
-{
-    vec2 result;
-    result.x = -v.x;
-    result.y = -v.y;
-    return result;
-}
-
-vec2 vec2_abs(vec2 v)
-{
-    vec2 result;
-    result.x = abs_float(v.x);
-    result.y = abs_float(v.y);
-    return result;
-}
-
 float vec2_dot(vec2 a, vec2 b)
 {
     return (a.x * b.x) + (a.y * b.y);
@@ -337,6 +412,32 @@ vec2 vec2_direction(float rotation)
     return vec2_normalize(vec2_new(x, y));
 }
 
+#endif
+
+vec2 vec2_lerp(vec2 a, vec2 b, float t)
+{
+    vec2 result;
+    result.x = lerp_float(a.x, b.x, t);
+    result.y = lerp_float(a.y, b.y, t);
+    return result;
+}
+
+vec2 vec2_negate(vec2 v)
+{
+    vec2 result;
+    result.x = -v.x;
+    result.y = -v.y;
+    return result;
+}
+
+vec2 vec2_abs(vec2 v)
+{
+    vec2 result;
+    result.x = abs_float(v.x);
+    result.y = abs_float(v.y);
+    return result;
+}
+
 bool vec2_equal(vec2 a, vec2 b)
 {
     return (a.x == b.x) && (a.y == b.y);
@@ -766,3 +867,66 @@ mat4 mat4_look_at(vec3 eye_position, vec3 target_position, vec3 world_up)
 
     return r;
 }
+
+struct AABB aabb_from_transform(vec2 center, vec2 size)
+{
+    vec2 half_size = vec2_div(size, 2.0f);
+
+    struct AABB aabb;
+    aabb.min = vec2_sub(center, half_size);
+    aabb.max = vec2_add(center, half_size);
+    return aabb;
+}
+
+struct AABB aabb_union(struct AABB a, struct AABB b)
+{
+    struct AABB aabb;
+    aabb.min = min_vec2(a.min, b.min);
+    aabb.max = max_vec2(a.max, b.max);
+    return aabb;
+}
+
+bool aabb_aabb_intersection(struct AABB a, struct AABB b)
+{
+    if ((a.max.x > b.min.x) && (a.min.x < b.max.x))
+    {
+        if ((a.max.y > b.min.y) && (a.min.y < b.max.y))
+            return true;
+    }
+
+    return false;
+}
+
+bool ray_aabb_intersection(struct AABB aabb, vec2 origin, vec2 direction, float max_t, float *t)
+{
+    float t_min = 0.0f;
+    float t_max = max_t;
+
+    for (uint32 axis = 0; axis < 2; ++axis)
+    {
+        float o = origin.v[axis];
+        float d = direction.v[axis];
+
+        // Parallel to this slab, so the origin has to be inside it.
+        if (abs_float(d) < FLOAT_EPSILON)
+        {
+            if ((o < aabb.min.v[axis]) || (o > aabb.max.v[axis]))
+                return false;
+
+            continue;
+        }
+
+        float inv_d = 1.0f / d;
+        float t0 = (aabb.min.v[axis] - o) * inv_d;
+        float t1 = (aabb.max.v[axis] - o) * inv_d;
+
+        t_min = max_float(t_min, min_float(t0, t1));
+        t_max = min_float(t_max, max_float(t0, t1));
+
+        if (t_min > t_max)
+            return false;
+    }
+
+    *t = t_min;
+    return true;
+}
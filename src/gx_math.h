@@ -42,6 +42,12 @@ typedef struct
     float m[16];
 } mat4;
 
+struct AABB
+{
+    vec2 min;
+    vec2 max;
+};
+
 
 //
 // trig
@@ -73,8 +79,10 @@ vec3   min_vec3(vec3 a, vec3 b);
 vec3   max_vec3(vec3 a, vec3 b);
 
 float clamp_float(float value, float min, float max);
+float lerp_float(float a, float b, float t);
 
 float abs_float(float value);
+float sqrt_float(float value);
 
 vec3  calc_normal(vec3 v0, vec3 v1, vec3 v2);
 
@@ -83,6 +91,19 @@ vec3  calc_normal(vec3 v0, vec3 v1, vec3 v2);
 // random
 //
 
+// xorshift128 state. Simulation code passes its own state around so results
+// do not depend on anything else drawing from the global generator.
+struct Random
+{
+    uint32 x, y, z, w;
+};
+
+struct Random create_random(uint32 seed);
+uint32 random_uint32_r(struct Random *random);
+float random_r(struct Random *random);
+int32 random_int_r(struct Random *random, int32 min, int32 max);
+float random_float_r(struct Random *random, float min, float max);
+
 void init_random(uint32 seed);
 uint64 rdtsc(void);
 
@@ -98,6 +119,10 @@ float fractal_noise(float x, float y, float z, uint32 octaves, float frequency,
 // vec2
 //
 
+// Building with GX_FIXED_POINT computes the arithmetic below in Q16.16 (see
+// gx_fixed.h) so the simulation is deterministic across compilers and CPUs.
+// Storage stays float either way.
+
 vec2  vec2_zero(void);
 vec2  vec2_new(float x, float y);
 vec2  vec2_scalar(float s);
@@ -120,6 +145,9 @@ float vec2_distance2(vec2 a, vec2 b);
 
 vec2  vec2_direction(float rotation);
 
+// Always float; only used for presentation, never by the simulation.
+vec2  vec2_lerp(vec2 a, vec2 b, float t);
+
 bool  vec2_equal(vec2 a, vec2 b);
 
 
@@ -186,3 +214,15 @@ mat4 mat4_perspective(float fov_degrees, float aspect_ratio, float near, float f
 mat4 mat4_orthographic(float left, float right, float bottom, float top, float near, float far);
 
 mat4 mat4_look_at(vec3 eye_position, vec3 target_position, vec3 world_up);
+
+
+//
+// aabb
+//
+
+struct AABB aabb_from_transform(vec2 center, vec2 size);
+struct AABB aabb_union(struct AABB a, struct AABB b);
+bool aabb_aabb_intersection(struct AABB a, struct AABB b);
+
+// Slab test against origin + direction * t, 0 <= t <= max_t. Writes the entry distance to 't'.
+bool ray_aabb_intersection(struct AABB aabb, vec2 origin, vec2 direction, float max_t, float *t);
@@ -0,0 +1,164 @@
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS, MAP_HUGETLB, MADV_HUGEPAGE
+
+#include "gx_memory.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Older headers lack it; kernels before 4.17 treat the address as a hint,
+// which map_block() catches.
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+static size_t round_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// Maps at exactly 'address' unless it is NULL; never replaces an existing mapping.
+static void *map_block(void *address, size_t size, int flags)
+{
+    if (address)
+        flags |= MAP_FIXED_NOREPLACE;
+
+    void *pages = mmap(address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    if (pages == MAP_FAILED)
+        return NULL;
+
+    if (address && (pages != address))
+    {
+        munmap(pages, size);
+        return NULL;
+    }
+
+    return pages;
+}
+
+// Transparent huge pages only back 2 MB aligned ranges, so over-map and
+// trim when the kernel picks the address.
+static void *map_aligned_block(size_t size, size_t alignment)
+{
+    uint8 *pages = (uint8 *)map_block(NULL, size + alignment, 0);
+    if (!pages)
+        return NULL;
+
+    uint8 *aligned = (uint8 *)round_up((uintptr_t)pages, alignment);
+    if (aligned > pages)
+        munmap(pages, aligned - pages);
+    if (aligned + size < pages + size + alignment)
+        munmap(aligned + size, (pages + size + alignment) - (aligned + size));
+
+    return aligned;
+}
+
+// 'size' is a multiple of HUGE_PAGE_SIZE when huge pages are asked for.
+static void *map_memory_block(void *address, size_t size, struct MemoryConfig *config, size_t *page_size, bool *transparent)
+{
+    *page_size = get_page_size();
+    *transparent = false;
+
+    if (config->huge_pages)
+    {
+        // Only succeeds if pages were reserved, e.g. via /proc/sys/vm/nr_hugepages.
+        void *pages = map_block(address, size, MAP_HUGETLB | (config->prefault ? MAP_POPULATE : 0));
+        if (pages)
+        {
+            *page_size = HUGE_PAGE_SIZE;
+            return pages;
+        }
+    }
+
+    uint8 *pages = (address || !config->huge_pages) ? (uint8 *)map_block(address, size, 0) : (uint8 *)map_aligned_block(size, HUGE_PAGE_SIZE);
+    if (!pages)
+        return NULL;
+
+    // Advised before prefaulting, so the first faults already get huge pages.
+    if (config->huge_pages)
+        *transparent = (madvise(pages, size, MADV_HUGEPAGE) == 0);
+
+    if (config->prefault)
+    {
+        for (size_t offset = 0; offset < size; offset += *page_size)
+            ((volatile uint8 *)pages)[offset] = 0;
+    }
+
+    return pages;
+}
+
+size_t get_page_size(void)
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+size_t round_up_to_page(size_t size)
+{
+    return round_up(size, get_page_size());
+}
+
+bool allocate_game_memory(struct GameMemory *memory, struct MemoryConfig *config)
+{
+    // The transient arena starts on its own page, so loading a snapshot over
+    // the GameState pages never reaches it.
+    size_t permanent_size = round_up_to_page(config->permanent_size);
+    size_t transient_size = round_up_to_page(config->transient_size);
+    size_t render_size = round_up_to_page(config->render_size);
+    size_t frame_size = round_up_to_page(config->frame_size);
+
+    // Huge pages cannot be split; the slack goes to the scratch arenas.
+    size_t block_alignment = config->huge_pages ? HUGE_PAGE_SIZE : get_page_size();
+    memory->game_memory_size = round_up(permanent_size + transient_size, block_alignment);
+    memory->render_memory_size = round_up(render_size + frame_size, block_alignment);
+    transient_size = memory->game_memory_size - permanent_size;
+    frame_size = memory->render_memory_size - render_size;
+
+    if (config->base_address % block_alignment != 0)
+    {
+        fprintf(stderr, "[ERROR] Game memory base address 0x%llx is not aligned to %zu KB.\n",
+                (unsigned long long)config->base_address, block_alignment / 1024);
+        return false;
+    }
+
+    uint8 *game_address = (uint8 *)config->base_address;
+    uint8 *render_address = game_address ? game_address + memory->game_memory_size : NULL;
+
+    bool transparent = false;
+    bool render_transparent = false;
+    size_t render_page_size = 0;
+    memory->game_memory = map_memory_block(game_address, memory->game_memory_size, config, &memory->page_size, &transparent);
+    memory->render_memory = map_memory_block(render_address, memory->render_memory_size, config, &render_page_size, &render_transparent);
+
+    if (!memory->game_memory || !memory->render_memory)
+    {
+        fprintf(stderr, "[ERROR] Failed to map %zu KB of game memory", (memory->game_memory_size + memory->render_memory_size) / 1024);
+        if (game_address)
+            fprintf(stderr, " at 0x%llx", (unsigned long long)config->base_address);
+        fprintf(stderr, ".\n");
+
+        free_game_memory(memory);
+        return false;
+    }
+
+    fprintf(stderr, "Mapped %zu KB of game memory at %p with %zu KB pages%s%s.\n",
+            memory->game_memory_size / 1024, memory->game_memory, memory->page_size / 1024,
+            transparent ? ", transparent huge pages advised" : "", config->prefault ? ", prefaulted" : "");
+
+    uint8 *game_memory = (uint8 *)memory->game_memory;
+    uint8 *render_memory = (uint8 *)memory->render_memory;
+    init_arena(&memory->permanent_arena, "permanent", game_memory, permanent_size);
+    init_arena(&memory->transient_arena, "transient", game_memory + permanent_size, transient_size);
+    init_arena(&memory->render_arena, "render", render_memory, render_size);
+    init_arena(&memory->frame_arena, "frame", render_memory + render_size, frame_size);
+    return true;
+}
+
+void free_game_memory(struct GameMemory *memory)
+{
+    if (memory->game_memory)
+        munmap(memory->game_memory, memory->game_memory_size);
+    if (memory->render_memory)
+        munmap(memory->render_memory, memory->render_memory_size);
+
+    memory->game_memory = NULL;
+    memory->render_memory = NULL;
+}
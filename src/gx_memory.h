@@ -0,0 +1,39 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx.h"
+
+// x86-64 huge page; MAP_HUGETLB without a size flag maps the default one.
+#define HUGE_PAGE_SIZE MEGABYTES(2)
+
+struct MemoryConfig
+{
+    // Arena sizes, see struct GameMemory. Rounded up to whole pages.
+    size_t permanent_size;
+    size_t transient_size;
+    size_t render_size;
+    size_t frame_size;
+
+    // Where game memory is mapped, with render memory right after it. Zero
+    // lets the kernel choose. A fixed base keeps every address the same from
+    // run to run, so snapshots and replays are pointer-stable; the mapping
+    // fails rather than landing anywhere else.
+    uintptr_t base_address;
+
+    // Tries reserved huge pages (MAP_HUGETLB) first and falls back to normal
+    // pages with transparent huge pages advised.
+    bool huge_pages;
+
+    // Faults every page in up front instead of on the first tick that touches it.
+    bool prefault;
+};
+
+// Game and render memory come straight from mmap: zeroed, page aligned, and
+// replaceable page by page, which snapshot loading relies on. Each block is
+// split into a long-lived arena and a scratch arena after it, see struct
+// GameMemory. Logs the page size it got.
+bool allocate_game_memory(struct GameMemory *memory, struct MemoryConfig *config);
+void free_game_memory(struct GameMemory *memory);
+
+size_t get_page_size(void);
+size_t round_up_to_page(size_t size);
@@ -0,0 +1,87 @@
+#include "gx_morton.h"
+
+#include <string.h>
+
+static uint32 spread_bits(uint32 x)
+{
+    x &= 0x0000ffff;
+    x = (x | (x << 8)) & 0x00ff00ff;
+    x = (x | (x << 4)) & 0x0f0f0f0f;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+static uint32 quantize(float value, float min, float max)
+{
+    float extent = max - min;
+    if (extent <= 0.0f)
+        return 0;
+
+    float normalized = clamp_float((value - min) / extent, 0.0f, 1.0f);
+    return (uint32)(normalized * 65535.0f);
+}
+
+uint32 morton_key(vec2 position, struct AABB bounds)
+{
+    uint32 x = quantize(position.x, bounds.min.x, bounds.max.x);
+    uint32 y = quantize(position.y, bounds.min.y, bounds.max.y);
+    return spread_bits(x) | (spread_bits(y) << 1);
+}
+
+void radix_sort(struct SortKey *keys, struct SortKey *scratch, uint32 count)
+{
+    struct SortKey *source = keys;
+    struct SortKey *destination = scratch;
+
+    for (uint32 shift = 0; shift < 32; shift += 8)
+    {
+        uint32 offsets[256] = {0};
+        for (uint32 i = 0; i < count; ++i)
+            ++offsets[(source[i].key >> shift) & 0xff];
+
+        uint32 total = 0;
+        for (uint32 i = 0; i < 256; ++i)
+        {
+            uint32 digit_count = offsets[i];
+            offsets[i] = total;
+            total += digit_count;
+        }
+
+        for (uint32 i = 0; i < count; ++i)
+            destination[offsets[(source[i].key >> shift) & 0xff]++] = source[i];
+
+        struct SortKey *temp = source;
+        source = destination;
+        destination = temp;
+    }
+
+    // Four passes, so the result is back in 'keys'.
+    ASSERT(source == keys);
+}
+
+void apply_sort_order(void *items, size_t item_size, struct SortKey *keys, uint32 count, void *temp)
+{
+    uint8 *bytes = (uint8 *)items;
+
+    // Follow each permutation cycle, marking visited slots by pointing them at themselves.
+    for (uint32 i = 0; i < count; ++i)
+    {
+        if (keys[i].index == i)
+            continue;
+
+        memcpy(temp, bytes + i * item_size, item_size);
+
+        uint32 j = i;
+        while (keys[j].index != i)
+        {
+            uint32 k = keys[j].index;
+            memcpy(bytes + j * item_size, bytes + k * item_size, item_size);
+            keys[j].index = j;
+            j = k;
+        }
+
+        memcpy(bytes + j * item_size, temp, item_size);
+        keys[j].index = j;
+    }
+}
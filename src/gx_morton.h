@@ -0,0 +1,20 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_math.h"
+
+struct SortKey
+{
+    uint32 key;
+    uint32 index;
+};
+
+// Z-order key of 'position' quantized to 16 bits per axis within 'bounds'.
+uint32 morton_key(vec2 position, struct AABB bounds);
+
+// Stable LSD radix sort on SortKey::key, 8 bits per pass. 'scratch' must hold 'count' keys.
+void radix_sort(struct SortKey *keys, struct SortKey *scratch, uint32 count);
+
+// Reorders 'items' in place so the item previously at keys[i].index ends up at i.
+// 'temp' must hold one item. Consumes the index field of 'keys'.
+void apply_sort_order(void *items, size_t item_size, struct SortKey *keys, uint32 count, void *temp);
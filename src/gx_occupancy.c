@@ -0,0 +1,200 @@
+#include "gx_occupancy.h"
+
+#include <math.h>
+#include <string.h>
+
+// Grow obstacles slightly before rasterizing so contacts exactly on a cell
+// boundary mark the cells on both sides.
+#define OCCUPANCY_RASTER_EPSILON 0.001f
+
+static uint64 span_mask(uint32 first_bit, uint32 last_bit)
+{
+    uint64 high = (last_bit == 63) ? UINT64_MAX : ((1ull << (last_bit + 1)) - 1);
+    uint64 low = (1ull << first_bit) - 1;
+    return high & ~low;
+}
+
+static void set_row_span(struct OccupancyGrid *grid, uint32 row, uint32 x0, uint32 x1)
+{
+    uint32 first_word = x0 >> 6;
+    uint32 last_word = x1 >> 6;
+
+    for (uint32 word = first_word; word <= last_word; ++word)
+    {
+        uint32 first_bit = (word == first_word) ? (x0 & 63) : 0;
+        uint32 last_bit = (word == last_word) ? (x1 & 63) : 63;
+        grid->rows[row][word] |= span_mask(first_bit, last_bit);
+    }
+}
+
+static bool row_span_occupied(uint64 *words, uint32 x0, uint32 x1)
+{
+    uint32 first_word = x0 >> 6;
+    uint32 last_word = x1 >> 6;
+
+    if (first_word == last_word)
+        return (words[first_word] & span_mask(x0 & 63, x1 & 63)) != 0;
+
+    if (words[first_word] & span_mask(x0 & 63, 63))
+        return true;
+
+    // Whole words in the middle reject 64 cells per test.
+    for (uint32 word = first_word + 1; word < last_word; ++word)
+    {
+        if (words[word])
+            return true;
+    }
+
+    return (words[last_word] & span_mask(0, x1 & 63)) != 0;
+}
+
+static vec2 to_grid_coords(struct OccupancyGrid *grid, vec2 point)
+{
+    return vec2_div(vec2_sub(point, grid->origin), grid->cell_size);
+}
+
+static bool in_grid(vec2 grid_coords)
+{
+    return (grid_coords.x >= 0.0f) && (grid_coords.x < (float)OCCUPANCY_GRID_SIZE) &&
+           (grid_coords.y >= 0.0f) && (grid_coords.y < (float)OCCUPANCY_GRID_SIZE);
+}
+
+void build_occupancy_grid(struct OccupancyGrid *grid, struct AABB *aabbs, uint32 count, vec2 origin, float cell_size)
+{
+    ASSERT(cell_size > 0.0f);
+
+    memset(grid->rows, 0, sizeof(grid->rows));
+    grid->origin = origin;
+    grid->cell_size = cell_size;
+
+    const int32 last_cell = OCCUPANCY_GRID_SIZE - 1;
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        vec2 min = to_grid_coords(grid, vec2_sub(aabbs[i].min, vec2_scalar(OCCUPANCY_RASTER_EPSILON)));
+        vec2 max = to_grid_coords(grid, vec2_add(aabbs[i].max, vec2_scalar(OCCUPANCY_RASTER_EPSILON)));
+
+        int32 x0 = max_int32((int32)floorf(min.x), 0);
+        int32 y0 = max_int32((int32)floorf(min.y), 0);
+        int32 x1 = min_int32((int32)floorf(max.x), last_cell);
+        int32 y1 = min_int32((int32)floorf(max.y), last_cell);
+
+        if ((x0 > x1) || (y0 > y1))
+            continue;
+
+        for (int32 y = y0; y <= y1; ++y)
+            set_row_span(grid, y, x0, x1);
+    }
+
+    grid->occupied_cell_count = 0;
+    for (uint32 y = 0; y < OCCUPANCY_GRID_SIZE; ++y)
+    {
+        for (uint32 word = 0; word < OCCUPANCY_GRID_WORDS; ++word)
+            grid->occupied_cell_count += __builtin_popcountll(grid->rows[y][word]);
+    }
+
+    memset(grid->coarse_rows, 0, sizeof(grid->coarse_rows));
+    for (uint32 y = 0; y < OCCUPANCY_GRID_SIZE; ++y)
+    {
+        for (uint32 x = 0; x < OCCUPANCY_COARSE_SIZE; ++x)
+        {
+            if (row_span_occupied(grid->rows[y], x << OCCUPANCY_COARSE_SHIFT, ((x + 1) << OCCUPANCY_COARSE_SHIFT) - 1))
+                grid->coarse_rows[y >> OCCUPANCY_COARSE_SHIFT] |= 1ull << x;
+        }
+    }
+
+    fprintf(stderr, "Generated occupancy grid containing %u/%u occupied cells, %zu KB.\n",
+            grid->occupied_cell_count, OCCUPANCY_GRID_SIZE * OCCUPANCY_GRID_SIZE, (sizeof(grid->rows) + sizeof(grid->coarse_rows)) / 1024);
+}
+
+bool occupancy_cell_blocked(struct OccupancyGrid *grid, int32 x, int32 y)
+{
+    if ((x < 0) || (y < 0) || (x >= OCCUPANCY_GRID_SIZE) || (y >= OCCUPANCY_GRID_SIZE))
+        return true;
+
+    return (grid->rows[y][x >> 6] >> (x & 63)) & 1;
+}
+
+bool occupancy_point_blocked(struct OccupancyGrid *grid, vec2 point)
+{
+    vec2 p = to_grid_coords(grid, point);
+    return occupancy_cell_blocked(grid, (int32)floorf(p.x), (int32)floorf(p.y));
+}
+
+bool occupancy_aabb_clear(struct OccupancyGrid *grid, struct AABB aabb)
+{
+    vec2 min = to_grid_coords(grid, aabb.min);
+    vec2 max = to_grid_coords(grid, aabb.max);
+    if (!in_grid(min) || !in_grid(max))
+        return false;
+
+    uint32 x0 = (uint32)min.x;
+    uint32 x1 = (uint32)max.x;
+    for (uint32 y = (uint32)min.y; y <= (uint32)max.y; ++y)
+    {
+        if (row_span_occupied(grid->rows[y], x0, x1))
+            return false;
+    }
+
+    return true;
+}
+
+// Walks the rows a segment (in cell coordinates) crosses. In each row the
+// segment covers one contiguous run of cells, which is tested a word at a time.
+static bool segment_rows_occupied(uint64 *rows, uint32 words_per_row, uint32 size, vec2 p0, vec2 p1)
+{
+    if (p0.y > p1.y)
+    {
+        vec2 temp = p0;
+        p0 = p1;
+        p1 = temp;
+    }
+
+    uint32 first_row = (uint32)p0.y;
+    uint32 last_row = (uint32)p1.y;
+
+    if (first_row == last_row)
+    {
+        uint32 x0 = (uint32)min_float(p0.x, p1.x);
+        uint32 x1 = (uint32)max_float(p0.x, p1.x);
+        return row_span_occupied(&rows[first_row * words_per_row], x0, x1);
+    }
+
+    float dx_dy = (p1.x - p0.x) / (p1.y - p0.y);
+    float max_x = (float)size - 1.0f;
+
+    // Plain arithmetic instead of the gx_math helpers; this loop runs once per row.
+    float x_low = p0.x;
+    for (uint32 row = first_row; row <= last_row; ++row)
+    {
+        float y_high = (row == last_row) ? p1.y : (float)(row + 1);
+        float x_high = p0.x + (y_high - p0.y) * dx_dy;
+
+        float span_min = (x_low < x_high) ? x_low : x_high;
+        float span_max = (x_low < x_high) ? x_high : x_low;
+        span_min = (span_min < 0.0f) ? 0.0f : ((span_min > max_x) ? max_x : span_min);
+        span_max = (span_max < 0.0f) ? 0.0f : ((span_max > max_x) ? max_x : span_max);
+
+        if (row_span_occupied(&rows[row * words_per_row], (uint32)span_min, (uint32)span_max))
+            return true;
+
+        x_low = x_high;
+    }
+
+    return false;
+}
+
+bool occupancy_segment_clear(struct OccupancyGrid *grid, vec2 start, vec2 end)
+{
+    vec2 p0 = to_grid_coords(grid, start);
+    vec2 p1 = to_grid_coords(grid, end);
+    if (!in_grid(p0) || !in_grid(p1))
+        return false;
+
+    // Reject against the coarse level first; on sparse maps most segments stop here.
+    const float coarse_scale = 1.0f / (float)(1 << OCCUPANCY_COARSE_SHIFT);
+    if (!segment_rows_occupied(grid->coarse_rows, 1, OCCUPANCY_COARSE_SIZE, vec2_mul(p0, coarse_scale), vec2_mul(p1, coarse_scale)))
+        return true;
+
+    return !segment_rows_occupied(&grid->rows[0][0], OCCUPANCY_GRID_WORDS, OCCUPANCY_GRID_SIZE, p0, p1);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_math.h"
+
+#define OCCUPANCY_GRID_SIZE  512
+#define OCCUPANCY_GRID_WORDS (OCCUPANCY_GRID_SIZE / 64)
+
+// Each coarse cell summarizes an 8x8 block of cells, so a coarse row is one word.
+#define OCCUPANCY_COARSE_SHIFT 3
+#define OCCUPANCY_COARSE_SIZE  (OCCUPANCY_GRID_SIZE >> OCCUPANCY_COARSE_SHIFT)
+
+// Bit-packed grid of cells touched by static obstacles. Rasterization is
+// conservative, so an empty cell is guaranteed to be free, while an occupied
+// cell only means an obstacle might be there.
+struct OccupancyGrid
+{
+    vec2 origin;
+    float cell_size;
+
+    // Row-major, one bit per cell, bit (x & 63) of word (x >> 6).
+    uint64 rows[OCCUPANCY_GRID_SIZE][OCCUPANCY_GRID_WORDS];
+    uint64 coarse_rows[OCCUPANCY_COARSE_SIZE];
+
+    uint32 occupied_cell_count;
+};
+
+void build_occupancy_grid(struct OccupancyGrid *grid, struct AABB *aabbs, uint32 count, vec2 origin, float cell_size);
+
+bool occupancy_cell_blocked(struct OccupancyGrid *grid, int32 x, int32 y);
+bool occupancy_point_blocked(struct OccupancyGrid *grid, vec2 point);
+
+// These return false whenever the query leaves the grid, since nothing is known there.
+bool occupancy_aabb_clear(struct OccupancyGrid *grid, struct AABB aabb);
+bool occupancy_segment_clear(struct OccupancyGrid *grid, vec2 start, vec2 end);
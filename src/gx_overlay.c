@@ -0,0 +1,222 @@
+#include "gx_overlay.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#define OVERLAY_LINE_HEIGHT 13.0f
+#define OVERLAY_WIDTH       340.0f
+
+// Frame time graph: one bar per frame, this many pixels per millisecond.
+#define OVERLAY_GRAPH_BAR_WIDTH 2.0f
+#define OVERLAY_GRAPH_SCALE     3.0f
+
+// Mean, max and 99th percentile of 'count' samples, in milliseconds. The
+// percentile is among the top 1%, so only that many samples are kept sorted
+// instead of sorting them all.
+static void calc_overlay_stats(float *samples, uint32 count, float *mean, float *max, float *p99)
+{
+    *mean = *max = *p99 = 0.0f;
+    if (count == 0)
+        return;
+
+    float largest[OVERLAY_HISTORY_FRAMES / 100 + 2] = {0};
+    uint32 rank = count - ((count * 99 + 99) / 100 - 1);
+    ASSERT(rank <= ARRAY_SIZE(largest));
+
+    float total = 0.0f;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        float sample = samples[i];
+        total += sample;
+
+        // Insert into the descending top 'rank'.
+        for (uint32 j = 0; j < rank; ++j)
+        {
+            if (sample > largest[j])
+            {
+                float displaced = largest[j];
+                largest[j] = sample;
+                sample = displaced;
+            }
+        }
+    }
+
+    *mean = total / (float)count * 1000.0f;
+    *max = largest[0] * 1000.0f;
+    *p99 = largest[rank - 1] * 1000.0f;
+}
+
+static void add_overlay_line(struct PerformanceOverlay *overlay, vec3 color, const char *format, ...)
+{
+    ASSERT(overlay->line_count < MAX_OVERLAY_LINES);
+    struct Text *line = &overlay->lines[overlay->line_count];
+    line->position = vec2_new(0.0f, (float)overlay->line_count * OVERLAY_LINE_HEIGHT);
+    line->color = color;
+    ++overlay->line_count;
+
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(line->string, sizeof(line->string), format, arguments);
+    va_end(arguments);
+}
+
+// Sums the zones each thread finished since the last frame into 'zone_times'.
+static void read_profile_zones(struct PerformanceOverlay *overlay, float *zone_times)
+{
+    double seconds_per_tick = 1.0 / get_profile_ticks_per_second();
+
+    for (uint32 i = 0; i < get_profile_thread_count(); ++i)
+    {
+        struct ProfileThread *thread = get_profile_thread(i);
+        struct OverlayThread *reader = &overlay->threads[i];
+
+        uint64 end = atomic_load_explicit(&thread->event_count, memory_order_acquire);
+        if (end - reader->event_cursor > PROFILE_EVENT_CAPACITY)
+        {
+            // Lapped; whatever was open is gone.
+            reader->event_cursor = end - PROFILE_EVENT_CAPACITY;
+            reader->open_zone_count = 0;
+        }
+
+        for (; reader->event_cursor < end; ++reader->event_cursor)
+        {
+            struct ProfileEvent *event = &thread->events[reader->event_cursor & (PROFILE_EVENT_CAPACITY - 1)];
+            struct PerfCounterValues *counters = thread->counters ? &thread->counters[reader->event_cursor & (PROFILE_EVENT_CAPACITY - 1)] : NULL;
+            if (event->type == PROFILE_EVENT_BEGIN)
+            {
+                if (reader->open_zone_count < MAX_OVERLAY_ZONE_DEPTH)
+                {
+                    if (counters)
+                        reader->open_counters[reader->open_zone_count] = *counters;
+                    reader->open_zones[reader->open_zone_count++] = *event;
+                }
+            }
+            else if (reader->open_zone_count > 0)
+            {
+                uint32 open_index = --reader->open_zone_count;
+                struct ProfileEvent *begin = &reader->open_zones[open_index];
+                if (begin->zone != event->zone)
+                    continue;
+
+                zone_times[event->zone] += (float)((double)(event->timestamp - begin->timestamp) * seconds_per_tick);
+                if (counters)
+                {
+                    for (uint32 j = 0; j < PERF_COUNTER_COUNT; ++j)
+                        overlay->zone_counters[event->zone][j] += counters->values[j] - reader->open_counters[open_index].values[j];
+                }
+            }
+        }
+    }
+}
+
+static void layout_overlay_text(struct PerformanceOverlay *overlay, double time, struct RenderState *render_state, uint32 draw_call_count)
+{
+    overlay->line_count = 0;
+
+    uint32 count = overlay->frame_count;
+    float mean, max, p99;
+    calc_overlay_stats(overlay->frame_times, count, &mean, &max, &p99);
+    add_overlay_line(overlay, vec3_new(1, 1, 1), "frame    %6.2f avg %6.2f max %6.2f p99 ms", mean, max, p99);
+    add_overlay_line(overlay, vec3_new(0.6f, 0.6f, 0.6f), "%-17s %7s %7s %7s", "zone (ms)", "avg", "max", "p99");
+
+    for (uint32 i = 0; i < PROFILE_ZONE_COUNT; ++i)
+    {
+        float samples[OVERLAY_HISTORY_FRAMES];
+        for (uint32 j = 0; j < count; ++j)
+            samples[j] = overlay->zone_times[j][i];
+
+        calc_overlay_stats(samples, count, &mean, &max, &p99);
+        add_overlay_line(overlay, vec3_new(1, 1, 1), "%-17s %7.3f %7.3f %7.3f", get_profile_zone_name((enum ProfileZone)i), mean, max, p99);
+    }
+
+    // Misses per entity per frame; entities are what the simulation updates.
+    if (get_profile_counter_mask())
+    {
+        double entity_frames = (double)max_uint32(render_state->ship_count + render_state->projectile_count, 1) * (double)max_uint32(overlay->counter_frame_count, 1);
+
+        add_overlay_line(overlay, vec3_new(0.6f, 0.6f, 0.6f), "%-17s %5s %7s %7s %7s", "per entity", "ipc", "l1d", "llc", "branch");
+        for (uint32 i = 0; i < PROFILE_ZONE_COUNT; ++i)
+        {
+            uint64 *counters = overlay->zone_counters[i];
+            if (counters[PERF_COUNTER_CYCLES] == 0)
+                continue;
+
+            add_overlay_line(overlay, vec3_new(1, 1, 1), "%-17s %5.2f %7.1f %7.1f %7.1f", get_profile_zone_name((enum ProfileZone)i),
+                             (double)counters[PERF_COUNTER_INSTRUCTIONS] / (double)counters[PERF_COUNTER_CYCLES],
+                             (double)counters[PERF_COUNTER_L1D_MISSES] / entity_frames, (double)counters[PERF_COUNTER_LLC_MISSES] / entity_frames,
+                             (double)counters[PERF_COUNTER_BRANCH_MISSES] / entity_frames);
+        }
+    }
+
+    memset(overlay->zone_counters, 0, sizeof(overlay->zone_counters));
+    overlay->counter_frame_count = 0;
+
+    double elapsed = time - overlay->last_refresh_time;
+    uint32 path_requests = render_state->path_request_count - overlay->last_path_request_count;
+
+    add_overlay_line(overlay, vec3_new(1, 1, 0), "ships %u  projectiles %u  pairs %u",
+                     render_state->ship_count, render_state->projectile_count, render_state->collision_pair_count);
+    add_overlay_line(overlay, vec3_new(1, 1, 0), "paths %.1f/s  draw calls %u",
+                     (elapsed > 0.0) ? (double)path_requests / elapsed : 0.0, draw_call_count);
+
+    overlay->last_refresh_time = time;
+    overlay->last_path_request_count = render_state->path_request_count;
+}
+
+void update_overlay(struct PerformanceOverlay *overlay, double time, double frame_time, struct RenderState *render_state, uint32 draw_call_count)
+{
+    BEGIN_PROFILE_ZONE(PROFILE_OVERLAY);
+
+    float *zone_times = overlay->zone_times[overlay->frame_index];
+    memset(zone_times, 0, PROFILE_ZONE_COUNT * sizeof(float));
+    read_profile_zones(overlay, zone_times);
+
+    overlay->frame_times[overlay->frame_index] = (float)frame_time;
+    overlay->frame_index = (overlay->frame_index + 1) % OVERLAY_HISTORY_FRAMES;
+    if (overlay->frame_count < OVERLAY_HISTORY_FRAMES)
+        ++overlay->frame_count;
+    ++overlay->counter_frame_count;
+
+    if (overlay->visible && (time - overlay->last_refresh_time >= OVERLAY_REFRESH_SECONDS))
+        layout_overlay_text(overlay, time, render_state, draw_call_count);
+
+    END_PROFILE_ZONE(PROFILE_OVERLAY);
+}
+
+void draw_overlay(struct PerformanceOverlay *overlay, struct RenderBuffer *render_buffer, uint32 screen_width, uint32 screen_height)
+{
+    if (!overlay->visible)
+        return;
+
+    BEGIN_PROFILE_ZONE(PROFILE_OVERLAY);
+
+    vec2 origin = vec2_new((float)screen_width - OVERLAY_WIDTH, 2.0f);
+
+    struct TextBuffer *text = &render_buffer->text;
+    ASSERT(text->current_size + overlay->line_count <= ARRAY_SIZE(text->texts));
+    for (uint32 i = 0; i < overlay->line_count; ++i)
+    {
+        struct Text *line = &text->texts[text->current_size++];
+        *line = overlay->lines[i];
+        line->position = vec2_add(line->position, origin);
+    }
+
+    // Oldest frame on the left. Green within 60 Hz, yellow within 30 Hz.
+    float baseline = origin.y + (float)(overlay->line_count + 1) * OVERLAY_LINE_HEIGHT + 100.0f;
+    for (uint32 i = 0; i < overlay->frame_count; ++i)
+    {
+        uint32 index = (overlay->frame_index + OVERLAY_HISTORY_FRAMES - overlay->frame_count + i) % OVERLAY_HISTORY_FRAMES;
+        float milliseconds = overlay->frame_times[index] * 1000.0f;
+        float height = min_float(milliseconds * OVERLAY_GRAPH_SCALE, 100.0f);
+
+        vec3 color = (milliseconds <= 1000.0f / 60.0f) ? vec3_new(0, 1, 0) : (milliseconds <= 1000.0f / 30.0f) ? vec3_new(1, 1, 0) : vec3_new(1, 0, 0);
+        vec2 position = vec2_new(origin.x + (float)i * OVERLAY_GRAPH_BAR_WIDTH, baseline - height);
+        draw_screen_quad_buffered(render_buffer, position, vec2_new(OVERLAY_GRAPH_BAR_WIDTH - 1.0f, height), vec4_zero(), color);
+    }
+
+    // 60 Hz budget.
+    float budget_height = 1000.0f / 60.0f * OVERLAY_GRAPH_SCALE;
+    draw_screen_quad_buffered(render_buffer, vec2_new(origin.x, baseline - budget_height), vec2_new(OVERLAY_HISTORY_FRAMES * OVERLAY_GRAPH_BAR_WIDTH, 1.0f), vec4_zero(), vec3_new(0.5f, 0.5f, 0.5f));
+
+    END_PROFILE_ZONE(PROFILE_OVERLAY);
+}
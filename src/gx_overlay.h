@@ -0,0 +1,62 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_profile.h"
+#include "gx_renderer.h"
+#include "gx.h"
+
+//
+// Performance overlay, toggled with F3. Every frame it takes the zones that
+// finished since the last frame from the profiler rings and draws the frame
+// time graph. The text is only laid out again every OVERLAY_REFRESH_SECONDS;
+// in between the same lines are copied into the text buffer. With hardware
+// counters on, a second table gives each zone's IPC and misses per entity.
+//
+
+#define OVERLAY_HISTORY_FRAMES  120
+#define OVERLAY_REFRESH_SECONDS 0.25
+#define MAX_OVERLAY_LINES       (2 * PROFILE_ZONE_COUNT + 5)
+
+// Zones a thread can have open at once.
+#define MAX_OVERLAY_ZONE_DEPTH 32
+
+struct OverlayThread
+{
+    // Next event to read from the thread's ring.
+    uint64 event_cursor;
+
+    struct ProfileEvent open_zones[MAX_OVERLAY_ZONE_DEPTH];
+    struct PerfCounterValues open_counters[MAX_OVERLAY_ZONE_DEPTH];
+    uint32 open_zone_count;
+};
+
+struct PerformanceOverlay
+{
+    bool visible;
+
+    struct OverlayThread threads[MAX_PROFILE_THREADS];
+
+    // Seconds per frame in total and in each zone, summed over all threads,
+    // for the last OVERLAY_HISTORY_FRAMES frames.
+    float frame_times[OVERLAY_HISTORY_FRAMES];
+    float zone_times[OVERLAY_HISTORY_FRAMES][PROFILE_ZONE_COUNT];
+    uint32 frame_index;
+    uint32 frame_count;
+
+    // Counter totals per zone since the text was last laid out.
+    uint64 zone_counters[PROFILE_ZONE_COUNT][PERF_COUNTER_COUNT];
+    uint32 counter_frame_count;
+
+    double last_refresh_time;
+    uint32 last_path_request_count;
+
+    struct Text lines[MAX_OVERLAY_LINES];
+    uint32 line_count;
+};
+
+// Call once per frame, visible or not, so the rings never lap the overlay.
+// 'draw_call_count' is for the previous frame.
+void update_overlay(struct PerformanceOverlay *overlay, double time, double frame_time, struct RenderState *render_state, uint32 draw_call_count);
+
+// Queues the overlay into 'render_buffer' after the game's own extraction.
+void draw_overlay(struct PerformanceOverlay *overlay, struct RenderBuffer *render_buffer, uint32 screen_width, uint32 screen_height);
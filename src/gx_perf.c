@@ -0,0 +1,149 @@
+#define _DEFAULT_SOURCE // syscall()
+
+#include "gx_perf.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct PerfCounterInfo
+{
+    const char *name;
+    uint32 type;
+    uint64 config;
+};
+
+static const struct PerfCounterInfo perf_counter_infos[PERF_COUNTER_COUNT] =
+{
+    { "cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "l1d_misses",    PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { "llc_misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+// Only the first thread to fail explains why; the rest would say the same.
+static atomic_flag perf_failure_reported = ATOMIC_FLAG_INIT;
+
+static int open_perf_event(const struct PerfCounterInfo *info, int group_fd)
+{
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = info->type;
+    attributes.config = info->config;
+    attributes.read_format = PERF_FORMAT_GROUP;
+
+    // User space only, which perf_event_paranoid 2 still allows.
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    // This thread, on any CPU.
+    return (int)syscall(SYS_perf_event_open, &attributes, 0, -1, group_fd, 0);
+}
+
+static void report_perf_failure(int error)
+{
+    if (atomic_flag_test_and_set(&perf_failure_reported))
+        return;
+
+    if ((error == EACCES) || (error == EPERM))
+    {
+        int paranoid = -1;
+        FILE *file = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+        if (file)
+        {
+            if (fscanf(file, "%d", &paranoid) != 1)
+                paranoid = -1;
+            fclose(file);
+        }
+
+        fprintf(stderr, "Hardware counters are not permitted (perf_event_paranoid %d); profiling without them.\n", paranoid);
+    }
+    else if ((error == ENOENT) || (error == ENODEV) || (error == EOPNOTSUPP))
+    {
+        fprintf(stderr, "No hardware counters on this CPU or VM; profiling without them.\n");
+    }
+    else
+    {
+        fprintf(stderr, "Failed to open hardware counters (%s); profiling without them.\n", strerror(error));
+    }
+}
+
+bool open_perf_counters(struct PerfCounterGroup *group)
+{
+    memset(group, 0, sizeof(*group));
+
+    // Cycles lead the group so every counter covers the same stretch.
+    int leader = -1;
+    uint32 slot_count = 0;
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; ++i)
+    {
+        group->fds[i] = open_perf_event(&perf_counter_infos[i], leader);
+        if (group->fds[i] < 0)
+        {
+            if (leader < 0)
+            {
+                report_perf_failure(errno);
+                return false;
+            }
+
+            continue;
+        }
+
+        if (leader < 0)
+            leader = group->fds[i];
+
+        group->mask |= 1u << i;
+        group->read_slots[i] = slot_count++;
+    }
+
+    // The pages are what rdpmc reads from; without them every read is a syscall.
+    long page_size = sysconf(_SC_PAGESIZE);
+    group->use_rdpmc = true;
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; ++i)
+    {
+        if (!(group->mask & (1u << i)))
+            continue;
+
+        void *page = mmap(NULL, (size_t)page_size, PROT_READ, MAP_SHARED, group->fds[i], 0);
+        if (page == MAP_FAILED)
+        {
+            group->use_rdpmc = false;
+            continue;
+        }
+
+        group->pages[i] = (struct perf_event_mmap_page *)page;
+        if (!group->pages[i]->cap_user_rdpmc)
+            group->use_rdpmc = false;
+    }
+
+    return true;
+}
+
+const char *get_perf_counter_name(enum PerfCounter counter)
+{
+    ASSERT(counter < PERF_COUNTER_COUNT);
+    return perf_counter_infos[counter].name;
+}
+
+void read_perf_counters_syscall(struct PerfCounterGroup *group, struct PerfCounterValues *values)
+{
+    // PERF_FORMAT_GROUP: the number of counters, then their values in the
+    // order they joined the group.
+    uint64 buffer[1 + PERF_COUNTER_COUNT] = {0};
+    memset(values, 0, sizeof(*values));
+
+    int leader = group->fds[PERF_COUNTER_CYCLES];
+    if (read(leader, buffer, sizeof(buffer)) <= 0)
+        return;
+
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; ++i)
+    {
+        if ((group->mask & (1u << i)) && (group->read_slots[i] < buffer[0]))
+            values->values[i] = buffer[1 + group->read_slots[i]];
+    }
+}
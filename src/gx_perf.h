@@ -0,0 +1,92 @@
+#pragma once
+
+#include "gx_define.h"
+
+#include <linux/perf_event.h>
+#include <x86intrin.h> // __rdpmc()
+
+//
+// Hardware performance counters through perf_event_open. Each profiled thread
+// opens its own group, counting user-space work on that thread only. Where
+// the kernel allows it the counters are read with rdpmc straight from the
+// mapped event pages; otherwise each sample is one read() of the group.
+// When the kernel refuses (perf_event_paranoid, a VM without a PMU) nothing
+// is opened and the profiler carries on with timestamps alone.
+//
+
+enum PerfCounter
+{
+    PERF_COUNTER_CYCLES,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_L1D_MISSES,
+    PERF_COUNTER_LLC_MISSES,
+    PERF_COUNTER_BRANCH_MISSES,
+
+    PERF_COUNTER_COUNT,
+};
+
+struct PerfCounterValues
+{
+    uint64 values[PERF_COUNTER_COUNT];
+};
+
+struct PerfCounterGroup
+{
+    // Bit per counter this CPU could open; the others read as zero.
+    uint32 mask;
+    bool use_rdpmc;
+
+    int fds[PERF_COUNTER_COUNT];
+    struct perf_event_mmap_page *pages[PERF_COUNTER_COUNT];
+
+    // Position of each counter in a group read().
+    uint32 read_slots[PERF_COUNTER_COUNT];
+};
+
+// Opens the counters for the calling thread. Returns false if none could be
+// opened; the first failure in the process says why.
+bool open_perf_counters(struct PerfCounterGroup *group);
+
+const char *get_perf_counter_name(enum PerfCounter counter);
+
+// Slow path of read_perf_counters().
+void read_perf_counters_syscall(struct PerfCounterGroup *group, struct PerfCounterValues *values);
+
+// The page's sequence count changes while the kernel moves the counter, e.g.
+// on a context switch; retry until it holds still.
+static inline uint64 read_perf_counter_page(struct perf_event_mmap_page *page)
+{
+    uint32 sequence;
+    uint64 count;
+
+    do
+    {
+        sequence = page->lock;
+        __asm__ volatile("" ::: "memory");
+
+        count = (uint64)page->offset;
+        uint32 index = page->index;
+        if (page->cap_user_rdpmc && index)
+        {
+            // Sign-extend from the counter's width.
+            uint32 shift = 64 - page->pmc_width;
+            count += (uint64)(((int64)__rdpmc((int)index - 1) << shift) >> shift);
+        }
+
+        __asm__ volatile("" ::: "memory");
+    } while (page->lock != sequence);
+
+    return count;
+}
+
+static inline void read_perf_counters(struct PerfCounterGroup *group, struct PerfCounterValues *values)
+{
+    if (!group->use_rdpmc)
+    {
+        read_perf_counters_syscall(group, values);
+        return;
+    }
+
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; ++i)
+        values->values[i] = group->pages[i] ? read_perf_counter_page(group->pages[i]) : 0;
+}
@@ -0,0 +1,158 @@
+#include "gx_point_grid.h"
+
+#include <math.h>
+#include <string.h>
+
+static uint32 point_cell_coord(float value, float origin, float cell_size, uint32 cell_count)
+{
+    float cell = floorf((value - origin) / cell_size);
+    if (cell <= 0.0f)
+        return 0;
+
+    return min_uint32((uint32)cell, cell_count - 1);
+}
+
+void build_point_grid(struct PointGrid *grid, const vec2 *points, const uint8 *tags, uint32 count, float cell_size, struct MemoryArena *arena)
+{
+    ASSERT(cell_size > 0.0f);
+
+    memset(grid, 0, sizeof(*grid));
+    grid->points = points;
+    grid->tags = tags;
+    grid->point_count = count;
+
+    vec2 min = vec2_zero();
+    vec2 max = vec2_zero();
+    if (count > 0)
+    {
+        min = points[0];
+        max = points[0];
+        for (uint32 i = 1; i < count; ++i)
+        {
+            min = min_vec2(min, points[i]);
+            max = max_vec2(max, points[i]);
+        }
+    }
+
+    // Points spread far apart get coarser cells rather than more of them.
+    float width = 0.0f;
+    float height = 0.0f;
+    while (true)
+    {
+        width = floorf((max.x - min.x) / cell_size) + 1.0f;
+        height = floorf((max.y - min.y) / cell_size) + 1.0f;
+        if (width * height <= (float)POINT_GRID_MAX_CELLS)
+            break;
+
+        cell_size *= 2.0f;
+    }
+
+    grid->origin = min;
+    grid->cell_size = cell_size;
+    grid->width = (uint32)width;
+    grid->height = (uint32)height;
+
+    uint32 cell_count = grid->width * grid->height;
+    grid->cell_offsets = push_array(arena, uint32, cell_count + 1);
+    grid->cell_tags = push_array(arena, uint8, cell_count);
+    grid->indices = push_array(arena, uint32, count);
+    uint32 *point_cells = push_array(arena, uint32, count);
+
+    // Counting sort by cell. Points are visited in index order, so each
+    // cell's indices come out ascending.
+    for (uint32 i = 0; i < count; ++i)
+    {
+        uint32 x = point_cell_coord(points[i].x, min.x, cell_size, grid->width);
+        uint32 y = point_cell_coord(points[i].y, min.y, cell_size, grid->height);
+        uint32 cell = y * grid->width + x;
+
+        point_cells[i] = cell;
+        ++grid->cell_offsets[cell + 1];
+        grid->cell_tags[cell] |= tags[i];
+    }
+
+    for (uint32 i = 1; i <= cell_count; ++i)
+        grid->cell_offsets[i] += grid->cell_offsets[i - 1];
+
+    // Filling advances each offset to the start of the next cell; shift them back after.
+    for (uint32 i = 0; i < count; ++i)
+        grid->indices[grid->cell_offsets[point_cells[i]]++] = i;
+
+    memmove(&grid->cell_offsets[1], &grid->cell_offsets[0], cell_count * sizeof(uint32));
+    grid->cell_offsets[0] = 0;
+}
+
+bool point_grid_cell_range(struct PointGrid *grid, struct AABB aabb, uint32 *min_x, uint32 *min_y, uint32 *max_x, uint32 *max_y)
+{
+    vec2 grid_max = vec2_add(grid->origin, vec2_new((float)grid->width * grid->cell_size, (float)grid->height * grid->cell_size));
+    if ((grid->point_count == 0) ||
+        (aabb.max.x < grid->origin.x) || (aabb.max.y < grid->origin.y) ||
+        (aabb.min.x > grid_max.x) || (aabb.min.y > grid_max.y))
+        return false;
+
+    *min_x = point_cell_coord(aabb.min.x, grid->origin.x, grid->cell_size, grid->width);
+    *min_y = point_cell_coord(aabb.min.y, grid->origin.y, grid->cell_size, grid->height);
+    *max_x = point_cell_coord(aabb.max.x, grid->origin.x, grid->cell_size, grid->width);
+    *max_y = point_cell_coord(aabb.max.y, grid->origin.y, grid->cell_size, grid->height);
+    return true;
+}
+
+static void test_nearest_in_cell(struct PointGrid *grid, uint32 cell, vec2 center, uint8 tag_mask, uint32 *nearest, float *nearest_distance)
+{
+    if (!(grid->cell_tags[cell] & tag_mask))
+        return;
+
+    for (uint32 i = grid->cell_offsets[cell]; i < grid->cell_offsets[cell + 1]; ++i)
+    {
+        uint32 index = grid->indices[i];
+        if (!(grid->tags[index] & tag_mask))
+            continue;
+
+        float distance = vec2_distance2(grid->points[index], center);
+        if ((distance < *nearest_distance) || ((distance == *nearest_distance) && (index < *nearest)))
+        {
+            *nearest = index;
+            *nearest_distance = distance;
+        }
+    }
+}
+
+uint32 point_grid_nearest(struct PointGrid *grid, vec2 center, uint8 tag_mask)
+{
+    uint32 nearest = UINT32_MAX;
+    float nearest_distance = FLOAT_MAX;
+    if (grid->point_count == 0)
+        return nearest;
+
+    int32 center_x = (int32)point_cell_coord(center.x, grid->origin.x, grid->cell_size, grid->width);
+    int32 center_y = (int32)point_cell_coord(center.y, grid->origin.y, grid->cell_size, grid->height);
+    int32 ring_count = (int32)max_uint32(grid->width, grid->height);
+
+    // Search rings of cells outward. Points in ring r are at least (r - 1)
+    // cells away, so once the nearest so far is closer than that, no later
+    // ring can hold a nearer or equally near one.
+    for (int32 ring = 0; ring < ring_count; ++ring)
+    {
+        float ring_distance = (float)(ring - 1) * grid->cell_size;
+        if ((ring > 1) && (nearest_distance < ring_distance * ring_distance))
+            break;
+
+        int32 min_y = max_int32(center_y - ring, 0);
+        int32 max_y = min_int32(center_y + ring, (int32)grid->height - 1);
+        for (int32 y = min_y; y <= max_y; ++y)
+        {
+            bool full_row = (y == center_y - ring) || (y == center_y + ring);
+            int32 step = full_row ? 1 : 2 * ring;
+
+            for (int32 x = center_x - ring; x <= center_x + ring; x += max_int32(step, 1))
+            {
+                if ((x < 0) || (x >= (int32)grid->width))
+                    continue;
+
+                test_nearest_in_cell(grid, (uint32)(y * (int32)grid->width + x), center, tag_mask, &nearest, &nearest_distance);
+            }
+        }
+    }
+
+    return nearest;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_arena.h"
+#include "gx_math.h"
+
+// Cells are doubled in size until the points' bounds fit in this many.
+#define POINT_GRID_MAX_CELLS 32768
+
+// Points bucketed by the cell they fall in, for proximity queries over
+// things that move every tick. The grid is rebuilt from scratch into an
+// arena and covers only the points' bounds. Every point carries a tag, and
+// each cell keeps the OR of its points' tags, so a query for one kind of
+// point skips cells holding none.
+struct PointGrid
+{
+    const vec2 *points;
+    const uint8 *tags;
+    uint32 point_count;
+
+    // Corner of cell (0, 0).
+    vec2 origin;
+    float cell_size;
+    uint32 width;
+    uint32 height;
+
+    // Cell c = y * width + x holds indices[cell_offsets[c]] up to
+    // indices[cell_offsets[c + 1]], in ascending order.
+    uint32 *cell_offsets;
+    uint32 *indices;
+    uint8 *cell_tags;
+};
+
+// 'points' and 'tags' must outlive the grid; everything else comes from 'arena'.
+void build_point_grid(struct PointGrid *grid, const vec2 *points, const uint8 *tags, uint32 count, float cell_size, struct MemoryArena *arena);
+
+// Cells 'aabb' touches, clipped to the grid. False if it misses the grid.
+bool point_grid_cell_range(struct PointGrid *grid, struct AABB aabb, uint32 *min_x, uint32 *min_y, uint32 *max_x, uint32 *max_y);
+
+// Index of the point tagged with any of 'tag_mask' nearest to 'center', the
+// lowest index of equally near ones, or UINT32_MAX if there is none.
+uint32 point_grid_nearest(struct PointGrid *grid, vec2 center, uint8 tag_mask);
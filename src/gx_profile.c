@@ -0,0 +1,202 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime(), nanosleep()
+
+#include "gx_profile.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_PROFILE_DEPTH 64
+
+_Thread_local struct ProfileThread *current_profile_thread;
+
+static struct ProfileThread profile_threads[MAX_PROFILE_THREADS];
+// Slots are reserved first and counted once filled, see register_profile_thread().
+static _Atomic uint32 profile_thread_reserved_count;
+static _Atomic uint32 profile_thread_count;
+static double profile_ticks_per_second = 1.0;
+static bool profile_counters_enabled;
+
+static const char *profile_zone_names[PROFILE_ZONE_COUNT] =
+{
+    "frame",
+
+    "tick_game",
+    "tick_camera",
+    "move_orders",
+    "find_path",
+    "tick_combat",
+    "tick_physics",
+    "visibility_graph",
+
+    "render_game",
+    "draw_world_lines",
+    "draw_world_quads",
+    "draw_buildings",
+    "draw_ships",
+    "draw_projectiles",
+    "draw_screen_quads",
+    "draw_text",
+
+    "overlay",
+};
+
+static double get_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void init_profiler(void)
+{
+    // Invariant TSCs tick at a fixed rate, so a short sample is enough.
+    struct timespec wait = { 0, 20 * 1000 * 1000 };
+    double start_time = get_seconds();
+    uint64 start_ticks = __rdtsc();
+    nanosleep(&wait, NULL);
+    double end_time = get_seconds();
+    uint64 end_ticks = __rdtsc();
+
+    profile_ticks_per_second = (double)(end_ticks - start_ticks) / (end_time - start_time);
+}
+
+void enable_profile_counters(void)
+{
+    profile_counters_enabled = true;
+}
+
+void register_profile_thread(const char *name)
+{
+    uint32 index = atomic_fetch_add(&profile_thread_reserved_count, 1);
+    if (index >= MAX_PROFILE_THREADS)
+    {
+        fprintf(stderr, "[ERROR] No profiler ring left for thread '%s'.\n", name);
+        return;
+    }
+
+    struct ProfileThread *thread = &profile_threads[index];
+    thread->name = name;
+
+    if (profile_counters_enabled && open_perf_counters(&thread->perf))
+    {
+        thread->counters = calloc(PROFILE_EVENT_CAPACITY, sizeof(struct PerfCounterValues));
+        if (!thread->counters)
+            fprintf(stderr, "[ERROR] Failed to allocate counter samples for thread '%s'.\n", name);
+    }
+
+    // Readers on other threads only look at slots below the count, so it is
+    // raised once the slot is filled, and in slot order, so a thread still
+    // filling an earlier slot keeps it hidden.
+    uint32 expected = index;
+    while (!atomic_compare_exchange_weak_explicit(&profile_thread_count, &expected, index + 1, memory_order_release, memory_order_relaxed))
+        expected = index;
+
+    current_profile_thread = thread;
+}
+
+uint32 get_profile_thread_count(void)
+{
+    return atomic_load_explicit(&profile_thread_count, memory_order_acquire);
+}
+
+struct ProfileThread *get_profile_thread(uint32 index)
+{
+    ASSERT(index < get_profile_thread_count());
+    return &profile_threads[index];
+}
+
+const char *get_profile_zone_name(enum ProfileZone zone)
+{
+    ASSERT(zone < PROFILE_ZONE_COUNT);
+    return profile_zone_names[zone];
+}
+
+double get_profile_ticks_per_second(void)
+{
+    return profile_ticks_per_second;
+}
+
+uint32 get_profile_counter_mask(void)
+{
+    for (uint32 i = 0; i < get_profile_thread_count(); ++i)
+    {
+        if (profile_threads[i].counters)
+            return profile_threads[i].perf.mask;
+    }
+
+    return 0;
+}
+
+void print_profile_summary(void)
+{
+    uint64 zone_ticks[PROFILE_ZONE_COUNT] = {0};
+    uint64 zone_counts[PROFILE_ZONE_COUNT] = {0};
+    uint64 zone_counters[PROFILE_ZONE_COUNT][PERF_COUNTER_COUNT] = {{0}};
+
+    for (uint32 i = 0; i < get_profile_thread_count(); ++i)
+    {
+        struct ProfileThread *thread = &profile_threads[i];
+        uint64 end = atomic_load_explicit(&thread->event_count, memory_order_acquire);
+        uint64 begin = (end > PROFILE_EVENT_CAPACITY) ? end - PROFILE_EVENT_CAPACITY : 0;
+
+        // Ends whose begin fell out of the ring are skipped.
+        uint64 stack[MAX_PROFILE_DEPTH];
+        uint32 depth = 0;
+
+        for (uint64 j = begin; j < end; ++j)
+        {
+            struct ProfileEvent *event = &thread->events[j & (PROFILE_EVENT_CAPACITY - 1)];
+            if (event->type == PROFILE_EVENT_BEGIN)
+            {
+                if (depth < MAX_PROFILE_DEPTH)
+                    stack[depth] = j;
+                ++depth;
+            }
+            else if (depth > 0)
+            {
+                --depth;
+                if (depth >= MAX_PROFILE_DEPTH)
+                    continue;
+
+                uint32 begin_slot = stack[depth] & (PROFILE_EVENT_CAPACITY - 1);
+                struct ProfileEvent *begin_event = &thread->events[begin_slot];
+                if (begin_event->zone != event->zone)
+                    continue;
+
+                zone_ticks[event->zone] += event->timestamp - begin_event->timestamp;
+                ++zone_counts[event->zone];
+
+                if (thread->counters)
+                {
+                    uint32 end_slot = j & (PROFILE_EVENT_CAPACITY - 1);
+                    for (uint32 k = 0; k < PERF_COUNTER_COUNT; ++k)
+                        zone_counters[event->zone][k] += thread->counters[end_slot].values[k] - thread->counters[begin_slot].values[k];
+                }
+            }
+        }
+    }
+
+    uint32 counter_mask = get_profile_counter_mask();
+    for (uint32 i = 0; i < PROFILE_ZONE_COUNT; ++i)
+    {
+        if (zone_counts[i] == 0)
+            continue;
+
+        double seconds = (double)zone_ticks[i] / profile_ticks_per_second;
+        fprintf(stdout, "zone %-18s %8llu calls, %9.3f us mean, %9.3f ms total",
+                profile_zone_names[i], (unsigned long long)zone_counts[i],
+                seconds * 1e6 / (double)zone_counts[i], seconds * 1000.0);
+
+        if (counter_mask)
+        {
+            uint64 *counters = zone_counters[i];
+            double calls = (double)zone_counts[i];
+            fprintf(stdout, ", ipc %5.2f, per call %9.1f l1d %8.1f llc %8.1f branch misses",
+                    counters[PERF_COUNTER_CYCLES] ? (double)counters[PERF_COUNTER_INSTRUCTIONS] / (double)counters[PERF_COUNTER_CYCLES] : 0.0,
+                    (double)counters[PERF_COUNTER_L1D_MISSES] / calls, (double)counters[PERF_COUNTER_LLC_MISSES] / calls,
+                    (double)counters[PERF_COUNTER_BRANCH_MISSES] / calls);
+        }
+
+        fprintf(stdout, "\n");
+    }
+}
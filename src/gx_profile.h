@@ -0,0 +1,129 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_perf.h"
+
+#include <stdatomic.h>
+#include <x86intrin.h> // __rdtsc()
+
+//
+// Zone profiler. BEGIN_PROFILE_ZONE and END_PROFILE_ZONE append a timestamp
+// to the calling thread's ring of events; nothing is aggregated while
+// recording. Readers walk the rings afterwards, pairing begins with ends.
+// Built with make PROFILE=0 the macros expand to nothing.
+//
+// With counters enabled every event also samples the thread's hardware
+// counters into a parallel ring, so zones get cycles, instructions and
+// misses as well as time.
+//
+// The rings live in the executable. The game library resolves them against
+// it like the renderer calls, so zones survive reloading the game code.
+//
+
+// Power of two. At a few dozen zones per tick this holds several seconds.
+#define PROFILE_EVENT_CAPACITY (1 << 16)
+#define MAX_PROFILE_THREADS    8
+
+// Zones are an enum rather than string literals: event names must stay
+// valid after the game library that recorded them is unloaded.
+enum ProfileZone
+{
+    PROFILE_FRAME,
+
+    PROFILE_TICK_GAME,
+    PROFILE_TICK_CAMERA,
+    PROFILE_MOVE_ORDERS,
+    PROFILE_FIND_PATH,
+    PROFILE_TICK_COMBAT,
+    PROFILE_TICK_PHYSICS,
+    PROFILE_VISIBILITY_GRAPH,
+
+    PROFILE_RENDER_GAME,
+    PROFILE_DRAW_WORLD_LINES,
+    PROFILE_DRAW_WORLD_QUADS,
+    PROFILE_DRAW_BUILDINGS,
+    PROFILE_DRAW_SHIPS,
+    PROFILE_DRAW_PROJECTILES,
+    PROFILE_DRAW_SCREEN_QUADS,
+    PROFILE_DRAW_TEXT,
+
+    PROFILE_OVERLAY,
+
+    PROFILE_ZONE_COUNT,
+};
+
+enum ProfileEventType
+{
+    PROFILE_EVENT_BEGIN,
+    PROFILE_EVENT_END,
+};
+
+struct ProfileEvent
+{
+    uint64 timestamp;
+    uint32 zone;
+    uint32 type;
+};
+
+struct ProfileThread
+{
+    const char *name;
+
+    // Only the owning thread writes. The count never wraps in practice;
+    // events [count - PROFILE_EVENT_CAPACITY, count) are in the ring.
+    _Atomic uint64 event_count;
+
+    // Counter samples at the same indices as 'events'; NULL without counters.
+    struct PerfCounterValues *counters;
+    struct PerfCounterGroup perf;
+
+    struct ProfileEvent events[PROFILE_EVENT_CAPACITY];
+};
+
+extern _Thread_local struct ProfileThread *current_profile_thread;
+
+// Measures the timestamp rate; call once before any thread registers.
+void init_profiler(void);
+
+// Opens hardware counters on threads registered after this call.
+void enable_profile_counters(void);
+
+// Gives the calling thread a ring. Zones on unregistered threads are dropped.
+void register_profile_thread(const char *name);
+
+uint32 get_profile_thread_count(void);
+struct ProfileThread *get_profile_thread(uint32 index);
+
+const char *get_profile_zone_name(enum ProfileZone zone);
+double get_profile_ticks_per_second(void);
+
+// Bit per enum PerfCounter that the first thread could open, 0 without counters.
+uint32 get_profile_counter_mask(void);
+
+// Mean and total time per zone over what the rings still hold.
+void print_profile_summary(void);
+
+// gx_math's rdtsc() is a call; zones read the counter inline.
+static inline void record_profile_event(uint32 zone, uint32 type)
+{
+    struct ProfileThread *thread = current_profile_thread;
+    if (!thread)
+        return;
+
+    uint64 index = atomic_load_explicit(&thread->event_count, memory_order_relaxed);
+    struct ProfileEvent *event = &thread->events[index & (PROFILE_EVENT_CAPACITY - 1)];
+    event->timestamp = __rdtsc();
+    event->zone = zone;
+    event->type = type;
+    if (thread->counters)
+        read_perf_counters(&thread->perf, &thread->counters[index & (PROFILE_EVENT_CAPACITY - 1)]);
+    atomic_store_explicit(&thread->event_count, index + 1, memory_order_release);
+}
+
+#ifdef GX_PROFILE
+#define BEGIN_PROFILE_ZONE(zone) record_profile_event((zone), PROFILE_EVENT_BEGIN)
+#define END_PROFILE_ZONE(zone)   record_profile_event((zone), PROFILE_EVENT_END)
+#else
+#define BEGIN_PROFILE_ZONE(zone)
+#define END_PROFILE_ZONE(zone)
+#endif
@@ -55,7 +55,7 @@ vec2 world_to_screen_coords(vec2 world_coords, struct Camera *camera, uint32 scr
     return screen_coords;
 }
 
-struct Renderer init_renderer(void)
+struct Renderer init_renderer(struct MemoryArena *arena, struct MemoryArena *scratch)
 {
     // TODO: manual depth sorting
     glDisable(GL_DEPTH_TEST);
@@ -73,13 +73,13 @@ struct Renderer init_renderer(void)
 
     struct Renderer renderer = {0};
 
-    renderer.sprite_batch = create_sprite_batch(1000);
+    renderer.sprite_batch = create_sprite_batch(1000, arena, scratch);
 
-    renderer.debug_font = load_font("ProggyClean");
+    renderer.debug_font = load_font("ProggyClean", scratch);
 
-    renderer.line_program = load_program("line");
-    renderer.quad_program = load_program("quad");
-    renderer.text_program = load_program("text");
+    renderer.line_program = load_program("line", scratch);
+    renderer.quad_program = load_program("quad", scratch);
+    renderer.text_program = load_program("text", scratch);
 
     renderer.camera_ubo = generate_ubo(sizeof(mat4), UBO_CAMERA);
     glGenVertexArrays(1, &renderer.blank_vao);
@@ -137,20 +137,21 @@ void update_ubo(uint32 ubo, size_t size, void *data)
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
-uint32 load_program(const char *name)
+uint32 load_program(const char *name, struct MemoryArena *scratch)
 {
+    struct TempArena file_memory = begin_temp_arena(scratch);
+
     char path[64];
     snprintf(path, sizeof(path), "res/shader/%s.vert", name);
-    struct File vertex_file = load_file(path);
+    struct File vertex_file = load_file(path, scratch);
 
     snprintf(path, sizeof(path), "res/shader/%s.frag", name);
-    struct File fragment_file = load_file(path);
+    struct File fragment_file = load_file(path, scratch);
 
     uint32 vertex_shader = create_shader(vertex_file.source, GL_VERTEX_SHADER);
     uint32 fragment_shader = create_shader(fragment_file.source, GL_FRAGMENT_SHADER);
 
-    free_file(&fragment_file);
-    free_file(&vertex_file);
+    end_temp_arena(file_memory);
 
     uint32 program = create_program(vertex_shader, fragment_shader);
 
@@ -224,22 +225,24 @@ static uint32 generate_font_texture(uint32 width, uint32 height, uint8 *data)
     return id;
 }
 
-struct Font load_font(const char *name)
+struct Font load_font(const char *name, struct MemoryArena *scratch)
 {
+    struct TempArena font_memory = begin_temp_arena(scratch);
+
     char path[64];
     snprintf(path, sizeof(path), "res/font/%s.ttf", name);
-    struct File file = load_file(path);
+    struct File file = load_file(path, scratch);
 
     struct Font font = {0};
     font.size = 13;
 
-    uint8 temp_bitmap[512 * 512] = {0};
+    uint8 *temp_bitmap = push_array(scratch, uint8, 512 * 512);
     stbtt_BakeFontBitmap((uint8 *)file.source, 0, font.size, temp_bitmap, 512, 512, 32, 96, font.char_data);
 
-    free_file(&file);
-
     font.texture = generate_font_texture(512, 512, temp_bitmap);
 
+    end_temp_arena(font_memory);
+
     return font;
 }
 
@@ -258,23 +261,22 @@ void bind_texture_unit(uint32 unit)
     glActiveTexture(GL_TEXTURE0 + unit);
 }
 
-struct SpriteBatch create_sprite_batch(uint32 quad_capacity)
+struct SpriteBatch create_sprite_batch(uint32 quad_capacity, struct MemoryArena *arena, struct MemoryArena *scratch)
 {
     struct SpriteBatch batch = {0};
     batch.max_quad_count = quad_capacity;
 
     size_t batch_data_size = batch.max_quad_count * 4 * sizeof(struct SpriteVertex);
-    batch.data = malloc(batch_data_size);
-    ASSERT_NOT_NULL(batch.data);
+    batch.data = push_array(arena, struct SpriteVertex, batch.max_quad_count * 4);
 
     glGenBuffers(1, &batch.vbo);
     glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
     glBufferData(GL_ARRAY_BUFFER, batch_data_size, NULL, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    struct TempArena index_memory = begin_temp_arena(scratch);
     uint32 index_count = batch.max_quad_count * 6;
-    uint32 *index_data = malloc(index_count * sizeof(uint32));
-    ASSERT_NOT_NULL(index_data);
+    uint32 *index_data = push_array(scratch, uint32, index_count);
     for (uint32 i = 0, face_offset = 0; i < index_count; i += 6, face_offset += 4)
     {
         index_data[i + 0] = 0 + face_offset;
@@ -309,15 +311,18 @@ struct SpriteBatch create_sprite_batch(uint32 quad_capacity)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    free(index_data);
+    end_temp_arena(index_memory);
 
     return batch;
 }
 
+// The vertex data belongs to the arena it was created from.
 void free_sprite_batch(struct SpriteBatch *batch)
 {
-    ASSERT_NOT_NULL(batch->data);
-    free(batch->data);
+    glDeleteVertexArrays(1, &batch->vao);
+    glDeleteBuffers(1, &batch->ibo);
+    glDeleteBuffers(1, &batch->vbo);
+    batch->data = NULL;
 }
 
 void begin_sprite_batch(struct SpriteBatch *batch)
@@ -348,6 +353,7 @@ void flush_sprite_batch(struct SpriteBatch *batch)
     glBindVertexArray(batch->vao);
     glDrawElements(GL_TRIANGLES, batch->current_quad_count * 6, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
+    ++batch->draw_call_count;
 
     batch->current_quad_count = 0;
 }
@@ -519,6 +525,7 @@ void draw_world_line_buffer(struct Renderer *renderer, struct RenderBuffer *rend
 
         glDrawArrays(GL_LINES, 0, 2);
     }
+    renderer->draw_call_count += buffer->current_size;
 
     glBindVertexArray(0);
 }
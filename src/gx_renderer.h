@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gx_define.h"
+#include "gx_arena.h"
 #include "gx_math.h"
 #include <stb/stb_truetype.h>
 
@@ -25,6 +26,9 @@ struct SpriteBatch
     uint32 max_quad_count;
 
     struct SpriteVertex *data;
+
+    // Draw calls issued since the owner last reset it.
+    uint32 draw_call_count;
 };
 
 struct Font
@@ -104,6 +108,9 @@ struct Renderer
 
     uint32 camera_ubo;
     uint32 blank_vao;
+
+    // Draw calls outside the sprite batch since the owner last reset it.
+    uint32 draw_call_count;
 };
 
 
@@ -113,14 +120,16 @@ struct Renderer
 
 vec2 screen_to_world_coords(vec2 screen_coords, struct Camera *camera, uint32 screen_width, uint32 screen_height);
 
-struct Renderer init_renderer(void);
+// Long-lived buffers go on 'arena'; files and staging data on 'scratch',
+// released again before returning.
+struct Renderer init_renderer(struct MemoryArena *arena, struct MemoryArena *scratch);
 void clean_renderer(struct Renderer *renderer);
 
 uint32 generate_ubo(uint32 size, uint32 binding);
 void free_ubo(uint32 *id);
 void update_ubo(uint32 ubo, size_t size, void *data);
 
-uint32 load_program(const char *name);
+uint32 load_program(const char *name, struct MemoryArena *scratch);
 void free_program(uint32 program);
 void bind_program(uint32 program);
 
@@ -131,12 +140,12 @@ void set_uniform_vec2(const char *name, uint32 program, vec2 value);
 void set_uniform_vec3(const char *name, uint32 program, vec3 value);
 void set_uniform_mat4(const char *name, uint32 program, mat4 value);
 
-struct Font load_font(const char *name);
+struct Font load_font(const char *name, struct MemoryArena *scratch);
 void free_texture(uint32 *id);
 void bind_texture(uint32 id);
 void bind_texture_unit(uint32 unit);
 
-struct SpriteBatch create_sprite_batch(uint32 quad_capacity);
+struct SpriteBatch create_sprite_batch(uint32 quad_capacity, struct MemoryArena *arena, struct MemoryArena *scratch);
 void free_sprite_batch(struct SpriteBatch *batch);
 
 void begin_sprite_batch(struct SpriteBatch *batch);
@@ -0,0 +1,192 @@
+#include "gx_replay.h"
+
+#include <string.h>
+
+// Changed runs closer than this are merged, since a run header costs about as much.
+#define REPLAY_RUN_MERGE_GAP 4
+
+static void write_varint(FILE *file, uint32 value)
+{
+    while (value >= 0x80)
+    {
+        fputc((int)((value & 0x7f) | 0x80), file);
+        value >>= 7;
+    }
+
+    fputc((int)value, file);
+}
+
+static bool read_varint(FILE *file, uint32 *value)
+{
+    *value = 0;
+    for (uint32 shift = 0; shift < 35; shift += 7)
+    {
+        int byte = fgetc(file);
+        if (byte == EOF)
+            return false;
+
+        *value |= (uint32)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+struct ReplayHeader create_replay_header(struct GameConfig *config, uint32 screen_width, uint32 screen_height, float tick_dt)
+{
+    // Zeroed as a whole so padding in the file is deterministic.
+    struct ReplayHeader header;
+    memset(&header, 0, sizeof(header));
+
+    header.magic = REPLAY_MAGIC;
+    header.version = REPLAY_VERSION;
+    header.input_size = sizeof(struct Input);
+    header.config = *config;
+    header.screen_width = screen_width;
+    header.screen_height = screen_height;
+    header.tick_dt = tick_dt;
+    return header;
+}
+
+bool begin_replay_recording(struct ReplayRecorder *recorder, const char *path, struct ReplayHeader *header)
+{
+    memset(recorder, 0, sizeof(*recorder));
+
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file)
+    {
+        fprintf(stderr, "[ERROR] Failed to open replay '%s' for writing.\n", path);
+        return false;
+    }
+
+    recorder->header = *header;
+    recorder->header.tick_count = 0;
+    fwrite(&recorder->header, sizeof(recorder->header), 1, recorder->file);
+    return true;
+}
+
+void record_replay_tick(struct ReplayRecorder *recorder, struct Input *input)
+{
+    ASSERT_NOT_NULL(recorder->file);
+
+    const uint8 *current = (const uint8 *)input;
+    const uint8 *previous = (const uint8 *)&recorder->previous;
+    const uint32 size = sizeof(struct Input);
+
+    uint32 cursor = 0;
+    uint32 i = 0;
+    while (i < size)
+    {
+        if (current[i] == previous[i])
+        {
+            ++i;
+            continue;
+        }
+
+        // Extend the run until REPLAY_RUN_MERGE_GAP unchanged bytes in a row.
+        uint32 end = i + 1;
+        uint32 unchanged = 0;
+        while ((end < size) && (unchanged < REPLAY_RUN_MERGE_GAP))
+        {
+            unchanged = (current[end] == previous[end]) ? unchanged + 1 : 0;
+            ++end;
+        }
+        end -= unchanged;
+
+        write_varint(recorder->file, i - cursor);
+        write_varint(recorder->file, end - i);
+        fwrite(&current[i], end - i, 1, recorder->file);
+
+        cursor = end;
+        i = end;
+    }
+
+    // A zero-length run ends the tick.
+    write_varint(recorder->file, 0);
+    write_varint(recorder->file, 0);
+
+    recorder->previous = *input;
+    ++recorder->header.tick_count;
+}
+
+void end_replay_recording(struct ReplayRecorder *recorder)
+{
+    if (!recorder->file)
+        return;
+
+    fseek(recorder->file, 0, SEEK_SET);
+    fwrite(&recorder->header, sizeof(recorder->header), 1, recorder->file);
+    fclose(recorder->file);
+
+    fprintf(stderr, "Recorded %u ticks.\n", recorder->header.tick_count);
+    recorder->file = NULL;
+}
+
+bool open_replay(struct ReplayPlayer *player, const char *path)
+{
+    memset(player, 0, sizeof(*player));
+
+    player->file = fopen(path, "rb");
+    if (!player->file)
+    {
+        fprintf(stderr, "[ERROR] Failed to open replay '%s'.\n", path);
+        return false;
+    }
+
+    struct ReplayHeader *header = &player->header;
+    if ((fread(header, sizeof(*header), 1, player->file) != 1) ||
+        (header->magic != REPLAY_MAGIC) || (header->version != REPLAY_VERSION) ||
+        (header->input_size != sizeof(struct Input)))
+    {
+        fprintf(stderr, "[ERROR] '%s' is not a replay from this build.\n", path);
+        fclose(player->file);
+        player->file = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+bool play_replay_tick(struct ReplayPlayer *player, struct Input *input)
+{
+    if (!player->file)
+        return false;
+    if ((player->header.tick_count > 0) && (player->tick_index >= player->header.tick_count))
+        return false;
+
+    uint8 *current = (uint8 *)&player->current;
+    const uint32 size = sizeof(struct Input);
+
+    uint32 cursor = 0;
+    for (;;)
+    {
+        uint32 skip, length;
+        if (!read_varint(player->file, &skip) || !read_varint(player->file, &length))
+            return false;
+
+        if (length == 0)
+            break;
+
+        cursor += skip;
+        if ((cursor + length > size) || (fread(&current[cursor], length, 1, player->file) != 1))
+        {
+            fprintf(stderr, "[ERROR] Replay is corrupt at tick %u.\n", player->tick_index);
+            return false;
+        }
+
+        cursor += length;
+    }
+
+    *input = player->current;
+    ++player->tick_index;
+    return true;
+}
+
+void close_replay(struct ReplayPlayer *player)
+{
+    if (player->file)
+        fclose(player->file);
+
+    player->file = NULL;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_io.h"
+#include "gx.h"
+
+//
+// Replay files hold the game config plus the struct Input handed to
+// tick_game on every tick. Each tick is stored as the byte runs that changed
+// since the previous tick, so held keys and a resting mouse cost nothing.
+//
+
+#define REPLAY_MAGIC   0x50525847 // "GXRP"
+#define REPLAY_VERSION 3
+
+struct ReplayHeader
+{
+    uint32 magic;
+    uint32 version;
+
+    // Rejects files recorded against a different struct Input layout.
+    uint32 input_size;
+
+    struct GameConfig config;
+    uint32 screen_width;
+    uint32 screen_height;
+    float tick_dt;
+
+    // Written when recording ends; zero if the recorder did not exit cleanly.
+    uint32 tick_count;
+};
+
+struct ReplayRecorder
+{
+    FILE *file;
+    struct ReplayHeader header;
+    struct Input previous;
+};
+
+struct ReplayPlayer
+{
+    FILE *file;
+    struct ReplayHeader header;
+    struct Input current;
+    uint32 tick_index;
+};
+
+bool begin_replay_recording(struct ReplayRecorder *recorder, const char *path, struct ReplayHeader *header);
+void record_replay_tick(struct ReplayRecorder *recorder, struct Input *input);
+void end_replay_recording(struct ReplayRecorder *recorder);
+
+bool open_replay(struct ReplayPlayer *player, const char *path);
+// Returns false once every recorded tick has been played.
+bool play_replay_tick(struct ReplayPlayer *player, struct Input *input);
+void close_replay(struct ReplayPlayer *player);
+
+struct ReplayHeader create_replay_header(struct GameConfig *config, uint32 screen_width, uint32 screen_height, float tick_dt);
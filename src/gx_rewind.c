@@ -0,0 +1,264 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime()
+
+#include "gx_rewind.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static struct RewindRecord *get_record(struct RewindBuffer *buffer, uint32 index)
+{
+    ASSERT(index < buffer->record_count);
+    return &buffer->records[(buffer->first_record + index) % buffer->record_capacity];
+}
+
+static void drop_oldest_record(struct RewindBuffer *buffer)
+{
+    ASSERT(buffer->record_count > 0);
+    buffer->first_record = (buffer->first_record + 1) % buffer->record_capacity;
+    --buffer->record_count;
+}
+
+static size_t get_block_size(struct RewindBuffer *buffer, uint32 block)
+{
+    size_t begin = (size_t)block * REWIND_BLOCK_SIZE;
+    size_t end = begin + REWIND_BLOCK_SIZE;
+    return ((end < buffer->state_size) ? end : buffer->state_size) - begin;
+}
+
+static void xor_block(uint8 *destination, const uint8 *source, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        destination[i] ^= source[i];
+}
+
+// Reserves 'size' bytes at the head of the data ring, evicting the oldest
+// records the reservation runs over.
+static size_t reserve_data(struct RewindBuffer *buffer, size_t size)
+{
+    ASSERT(size <= buffer->data_capacity);
+
+    size_t offset = buffer->data_head;
+    if (offset + size > buffer->data_capacity)
+        offset = 0;
+
+    while (buffer->record_count > 0)
+    {
+        struct RewindRecord *oldest = get_record(buffer, 0);
+        bool overlaps = (oldest->offset < offset + size) && (offset < oldest->offset + oldest->size);
+        if (!overlaps)
+            break;
+
+        drop_oldest_record(buffer);
+    }
+
+    buffer->data_head = offset + size;
+    return offset;
+}
+
+bool init_rewind_buffer(struct RewindBuffer *buffer, size_t state_size, uint32 history_ticks, size_t data_capacity)
+{
+    ASSERT(history_ticks > 0);
+    memset(buffer, 0, sizeof(*buffer));
+
+    buffer->state_size = state_size;
+    buffer->block_count = (uint32)((state_size + REWIND_BLOCK_SIZE - 1) / REWIND_BLOCK_SIZE);
+    buffer->data_capacity = data_capacity;
+    buffer->record_capacity = history_ticks;
+
+    buffer->shadow = malloc(state_size);
+    buffer->data = malloc(data_capacity);
+    buffer->records = calloc(history_ticks, sizeof(struct RewindRecord));
+    buffer->inputs = calloc(history_ticks, sizeof(struct Input));
+    buffer->changed_blocks = malloc(buffer->block_count * sizeof(uint32));
+    buffer->static_blocks = calloc(buffer->block_count, sizeof(bool));
+
+    if (!buffer->shadow || !buffer->data || !buffer->records || !buffer->inputs || !buffer->changed_blocks || !buffer->static_blocks)
+    {
+        fprintf(stderr, "[ERROR] Failed to allocate rewind buffer.\n");
+        free_rewind_buffer(buffer);
+        return false;
+    }
+
+    return true;
+}
+
+void free_rewind_buffer(struct RewindBuffer *buffer)
+{
+    free(buffer->static_blocks);
+    free(buffer->changed_blocks);
+    free(buffer->inputs);
+    free(buffer->records);
+    free(buffer->data);
+    free(buffer->shadow);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+void mark_rewind_range_static(struct RewindBuffer *buffer, size_t offset, size_t size)
+{
+    ASSERT(offset + size <= buffer->state_size);
+
+    // Only blocks entirely inside the range; partial blocks are still compared.
+    uint32 first = (uint32)((offset + REWIND_BLOCK_SIZE - 1) / REWIND_BLOCK_SIZE);
+    uint32 last = (uint32)((offset + size) / REWIND_BLOCK_SIZE);
+    for (uint32 block = first; block < last; ++block)
+        buffer->static_blocks[block] = true;
+}
+
+void reset_rewind_buffer(struct RewindBuffer *buffer)
+{
+    buffer->has_shadow = false;
+    buffer->first_record = 0;
+    buffer->record_count = 0;
+    buffer->data_head = 0;
+}
+
+void push_rewind_snapshot(struct RewindBuffer *buffer, const void *state, uint32 tick, struct Input *input)
+{
+    double start = get_time();
+    const uint8 *bytes = (const uint8 *)state;
+
+    if (input)
+        buffer->inputs[tick % buffer->record_capacity] = *input;
+
+    if (!buffer->has_shadow)
+    {
+        memcpy(buffer->shadow, bytes, buffer->state_size);
+        buffer->shadow_tick = tick;
+        buffer->has_shadow = true;
+        return;
+    }
+
+    ASSERT(tick == buffer->shadow_tick + 1);
+
+    // Find changed blocks first so the record can be reserved in one piece.
+    uint32 changed_count = 0;
+    size_t changed_size = 0;
+    for (uint32 block = 0; block < buffer->block_count; ++block)
+    {
+        if (buffer->static_blocks[block])
+            continue;
+
+        size_t offset = (size_t)block * REWIND_BLOCK_SIZE;
+        size_t size = get_block_size(buffer, block);
+        if (memcmp(bytes + offset, buffer->shadow + offset, size) != 0)
+        {
+            buffer->changed_blocks[changed_count++] = block;
+            changed_size += size;
+        }
+    }
+
+    if (buffer->record_count == buffer->record_capacity)
+        drop_oldest_record(buffer);
+
+    size_t record_size = changed_count * sizeof(uint32) + changed_size;
+    size_t record_offset = reserve_data(buffer, record_size);
+
+    uint32 *indices = (uint32 *)(buffer->data + record_offset);
+    uint8 *deltas = buffer->data + record_offset + changed_count * sizeof(uint32);
+    memcpy(indices, buffer->changed_blocks, changed_count * sizeof(uint32));
+
+    for (uint32 i = 0; i < changed_count; ++i)
+    {
+        size_t offset = (size_t)buffer->changed_blocks[i] * REWIND_BLOCK_SIZE;
+        size_t size = get_block_size(buffer, buffer->changed_blocks[i]);
+
+        // delta = new ^ old; the shadow then moves forward to the new contents.
+        memcpy(deltas, bytes + offset, size);
+        xor_block(deltas, buffer->shadow + offset, size);
+        memcpy(buffer->shadow + offset, bytes + offset, size);
+        deltas += size;
+    }
+
+
+    struct RewindRecord *record = &buffer->records[(buffer->first_record + buffer->record_count) % buffer->record_capacity];
+    record->tick = tick;
+    record->block_count = changed_count;
+    record->offset = record_offset;
+    record->size = record_size;
+    ++buffer->record_count;
+
+    buffer->shadow_tick = tick;
+
+    ++buffer->snapshot_count;
+    buffer->snapshot_bytes += record_size;
+    buffer->snapshot_seconds += get_time() - start;
+}
+
+uint32 get_oldest_rewind_tick(struct RewindBuffer *buffer)
+{
+    return buffer->shadow_tick - buffer->record_count;
+}
+
+uint32 get_newest_rewind_tick(struct RewindBuffer *buffer)
+{
+    return buffer->shadow_tick;
+}
+
+bool rewind_to_tick(struct RewindBuffer *buffer, void *state, uint32 tick)
+{
+    if (!buffer->has_shadow || (tick > buffer->shadow_tick) || (tick < get_oldest_rewind_tick(buffer)))
+        return false;
+
+    // Undo the newest deltas on the shadow, one tick at a time.
+    while (buffer->shadow_tick > tick)
+    {
+        struct RewindRecord *record = get_record(buffer, buffer->record_count - 1);
+        ASSERT(record->tick == buffer->shadow_tick);
+
+        uint32 *indices = (uint32 *)(buffer->data + record->offset);
+        uint8 *deltas = buffer->data + record->offset + record->block_count * sizeof(uint32);
+        for (uint32 i = 0; i < record->block_count; ++i)
+        {
+            size_t offset = (size_t)indices[i] * REWIND_BLOCK_SIZE;
+            size_t size = get_block_size(buffer, indices[i]);
+            xor_block(buffer->shadow + offset, deltas, size);
+            deltas += size;
+        }
+
+        // The record's space is free again.
+        buffer->data_head = record->offset;
+        --buffer->record_count;
+        --buffer->shadow_tick;
+    }
+
+    memcpy(state, buffer->shadow, buffer->state_size);
+    return true;
+}
+
+struct Input *get_rewind_input(struct RewindBuffer *buffer, uint32 tick)
+{
+    return &buffer->inputs[tick % buffer->record_capacity];
+}
+
+void resimulate_to_tick(struct RewindBuffer *buffer, struct GameMemory *memory, tick_game_function *tick, uint32 target_tick, uint32 screen_width, uint32 screen_height, float dt)
+{
+    struct GameState *game_state = (struct GameState *)memory->game_memory;
+    ASSERT(game_state->tick_count == buffer->shadow_tick);
+    ASSERT(target_tick - game_state->tick_count <= buffer->record_capacity);
+
+    while (game_state->tick_count < target_tick)
+    {
+        // tick_game may consume the input; the recorded copy stays untouched.
+        uint32 next_tick = game_state->tick_count + 1;
+        struct Input input = *get_rewind_input(buffer, next_tick);
+
+        tick(memory, &input, screen_width, screen_height, dt);
+        push_rewind_snapshot(buffer, memory->game_memory, game_state->tick_count, get_rewind_input(buffer, next_tick));
+    }
+}
+
+size_t get_rewind_memory_per_second(struct RewindBuffer *buffer, uint32 ticks_per_second)
+{
+    if (buffer->snapshot_count == 0)
+        return 0;
+
+    return (size_t)(buffer->snapshot_bytes / buffer->snapshot_count) * ticks_per_second;
+}
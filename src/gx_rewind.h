@@ -0,0 +1,93 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_io.h"
+#include "gx.h"
+
+//
+// Rewind history for rollback and replay scrubbing. The buffer keeps a shadow
+// copy of the newest state plus, per tick, the XOR of every block that
+// changed. XORing those back into the shadow walks the state backward one
+// tick at a time, so going back a few ticks only touches what those ticks
+// changed. The input of each tick is kept too, so rewound ticks can be
+// simulated again.
+//
+
+#define REWIND_BLOCK_SIZE 1024
+
+struct RewindRecord
+{
+    // The tick this delta produces from the one before it.
+    uint32 tick;
+    uint32 block_count;
+
+    // Block indices, then XORed block contents, in the data ring.
+    size_t offset;
+    size_t size;
+};
+
+struct RewindBuffer
+{
+    size_t state_size;
+    uint32 block_count;
+
+    uint8 *shadow;
+    uint32 shadow_tick;
+    bool has_shadow;
+
+    uint8 *data;
+    size_t data_capacity;
+    size_t data_head;
+
+    // Ring of records, oldest first.
+    struct RewindRecord *records;
+    uint32 record_capacity;
+    uint32 first_record;
+    uint32 record_count;
+
+    // Input that produced each tick, indexed by tick % record_capacity.
+    struct Input *inputs;
+
+    // Scratch list of blocks that differ from the shadow.
+    uint32 *changed_blocks;
+
+    // Blocks never compared, see mark_rewind_range_static().
+    bool *static_blocks;
+
+    // Totals for reporting snapshot cost.
+    uint64 snapshot_count;
+    uint64 snapshot_bytes;
+    double snapshot_seconds;
+};
+
+bool init_rewind_buffer(struct RewindBuffer *buffer, size_t state_size, uint32 history_ticks, size_t data_capacity);
+void free_rewind_buffer(struct RewindBuffer *buffer);
+
+// Skips comparing a range that does not change after the first snapshot, such
+// as the map. Most of the per-tick cost is reading memory, so this matters.
+void mark_rewind_range_static(struct RewindBuffer *buffer, size_t offset, size_t size);
+
+// Drops all history; the next snapshot becomes the new base.
+void reset_rewind_buffer(struct RewindBuffer *buffer);
+
+// Record 'state' as of 'tick'. 'input' is what produced it, NULL for the first snapshot.
+void push_rewind_snapshot(struct RewindBuffer *buffer, const void *state, uint32 tick, struct Input *input);
+
+uint32 get_oldest_rewind_tick(struct RewindBuffer *buffer);
+uint32 get_newest_rewind_tick(struct RewindBuffer *buffer);
+
+// Restores 'state' to 'tick' and discards the history after it.
+bool rewind_to_tick(struct RewindBuffer *buffer, void *state, uint32 tick);
+
+// Input recorded for 'tick', still available after rewinding past it. May be
+// edited before simulating again, e.g. when a late remote input arrives.
+struct Input *get_rewind_input(struct RewindBuffer *buffer, uint32 tick);
+
+// Simulates from the current (rewound) tick up to 'tick' with the recorded
+// inputs, snapshotting as it goes. 'tick' is passed in because the game code
+// may live in a reloadable library.
+void resimulate_to_tick(struct RewindBuffer *buffer, struct GameMemory *memory, tick_game_function *tick, uint32 target_tick, uint32 screen_width, uint32 screen_height, float dt);
+
+// Mean delta bytes per tick times 'ticks_per_second'. The shadow copy
+// (state_size) comes on top, once.
+size_t get_rewind_memory_per_second(struct RewindBuffer *buffer, uint32 ticks_per_second);
@@ -0,0 +1,198 @@
+#include "gx_scenario.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct ScenarioPreset
+{
+    const char *name;
+    const char *description;
+    struct Scenario scenario;
+};
+
+// Ships per team, repeater share, orders, building count, building size, layout, clusters, broadphase.
+static const struct ScenarioPreset scenario_presets[] =
+{
+    { "default",  "five ships among four buildings",         { {5, 0},         0.0f,  ORDERS_HOLD,    4,  2.0f, BUILDING_LAYOUT_RANDOM,    0, BROADPHASE_SWEEP_AND_PRUNE } },
+    { "skirmish", "two squads routing past each other",      { {24, 24},       0.0f,  ORDERS_ROUTE,   12, 2.0f, BUILDING_LAYOUT_RANDOM,    0, BROADPHASE_SWEEP_AND_PRUNE } },
+    { "city",     "street fight through a grid of blocks",   { {24, 24},       0.0f,  ORDERS_ROUTE,   49, 4.0f, BUILDING_LAYOUT_GRID,      0, BROADPHASE_SWEEP_AND_PRUNE } },
+    { "clusters", "advance into clumps of buildings",        { {24, 24},       0.25f, ORDERS_ADVANCE, 40, 2.0f, BUILDING_LAYOUT_CLUSTERED, 4, BROADPHASE_SWEEP_AND_PRUNE } },
+    { "barrage",  "repeaters only, projectiles at the cap",  { {32, 32},       1.0f,  ORDERS_HOLD,    8,  2.0f, BUILDING_LAYOUT_RANDOM,    0, BROADPHASE_SWEEP_AND_PRUNE } },
+    { "stress",   "10k a side charging through clusters",    { {10240, 10240}, 0.25f, ORDERS_ADVANCE, 64, 2.0f, BUILDING_LAYOUT_CLUSTERED, 6, BROADPHASE_GRID } },
+};
+
+static const char *building_layout_names[BUILDING_LAYOUT_COUNT] = { "random", "grid", "clustered" };
+static const char *initial_orders_names[INITIAL_ORDERS_COUNT] = { "hold", "advance", "route" };
+
+static void print_scenario_usage(void)
+{
+    fprintf(stderr, "Scenarios, as NAME[,KEY=VALUE...]:\n");
+    for (uint32 i = 0; i < ARRAY_SIZE(scenario_presets); ++i)
+        fprintf(stderr, "  %-10s %s\n", scenario_presets[i].name, scenario_presets[i].description);
+
+    fprintf(stderr, "Keys: ships, allies, enemies (0 to %u each in this build), repeaters (0 to 1),\n"
+                    "      orders (hold, advance, route), buildings, building_size,\n"
+                    "      layout (random, grid, clustered), clusters,\n"
+                    "      broadphase (sweep_and_prune, grid, brute_force)\n", MAX_SHIPS);
+}
+
+// strtoul would take "-1" as ULONG_MAX, so only plain digits are accepted.
+static bool parse_scenario_uint(const char *text, uint32 max_value, uint32 *value)
+{
+    if ((*text < '0') || (*text > '9'))
+        return false;
+
+    char *end = NULL;
+    unsigned long result = strtoul(text, &end, 10);
+    if ((*end != '\0') || (result > max_value))
+        return false;
+
+    *value = (uint32)result;
+    return true;
+}
+
+static bool parse_scenario_float(const char *text, float *value)
+{
+    char *end = NULL;
+    float result = strtof(text, &end);
+    if ((end == text) || (*end != '\0'))
+        return false;
+
+    *value = result;
+    return true;
+}
+
+static bool parse_scenario_name(const char *text, const char *const *names, uint32 name_count, uint8 *value)
+{
+    for (uint32 i = 0; i < name_count; ++i)
+    {
+        if (!strcmp(text, names[i]))
+        {
+            *value = (uint8)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool apply_scenario_option(struct Scenario *scenario, const char *key, const char *value)
+{
+    if (!strcmp(key, "ships"))
+    {
+        if (!parse_scenario_uint(value, MAX_SHIPS, &scenario->ship_counts[TEAM_ALLY]))
+            return false;
+
+        scenario->ship_counts[TEAM_ENEMY] = scenario->ship_counts[TEAM_ALLY];
+        return true;
+    }
+
+    if (!strcmp(key, "allies"))
+        return parse_scenario_uint(value, MAX_SHIPS, &scenario->ship_counts[TEAM_ALLY]);
+    if (!strcmp(key, "enemies"))
+        return parse_scenario_uint(value, MAX_SHIPS, &scenario->ship_counts[TEAM_ENEMY]);
+    if (!strcmp(key, "repeaters"))
+        return parse_scenario_float(value, &scenario->repeater_share) && (scenario->repeater_share >= 0.0f) && (scenario->repeater_share <= 1.0f);
+    if (!strcmp(key, "orders"))
+        return parse_scenario_name(value, initial_orders_names, ARRAY_SIZE(initial_orders_names), &scenario->orders);
+    if (!strcmp(key, "buildings"))
+        return parse_scenario_uint(value, UINT32_MAX, &scenario->building_count);
+    if (!strcmp(key, "building_size"))
+        return parse_scenario_float(value, &scenario->building_size) && (scenario->building_size > 0.0f);
+    if (!strcmp(key, "layout"))
+        return parse_scenario_name(value, building_layout_names, ARRAY_SIZE(building_layout_names), &scenario->building_layout);
+    if (!strcmp(key, "clusters"))
+        return parse_scenario_uint(value, UINT32_MAX, &scenario->cluster_count);
+    if (!strcmp(key, "broadphase"))
+        return parse_scenario_name(value, broadphase_type_names, ARRAY_SIZE(broadphase_type_names), &scenario->broadphase);
+
+    return false;
+}
+
+// Scales the scenario down to what GameState holds, keeping the teams' proportions.
+static void fit_scenario(struct Scenario *scenario)
+{
+    uint64 ship_count = (uint64)scenario->ship_counts[TEAM_ALLY] + scenario->ship_counts[TEAM_ENEMY];
+    if (ship_count > MAX_SHIPS)
+    {
+        for (uint32 i = 0; i < TEAM_COUNT; ++i)
+            scenario->ship_counts[i] = (uint32)((uint64)scenario->ship_counts[i] * MAX_SHIPS / ship_count);
+
+#ifdef GX_STRESS
+        const char *hint = "";
+#else
+        const char *hint = " Build with make STRESS=1 for more.";
+#endif
+        fprintf(stderr, "Scenario has %llu ships but this build holds %u; using %u v %u.%s\n",
+                (unsigned long long)ship_count, MAX_SHIPS, scenario->ship_counts[TEAM_ALLY], scenario->ship_counts[TEAM_ENEMY], hint);
+    }
+
+    if (scenario->building_count > MAX_BUILDINGS)
+    {
+        fprintf(stderr, "Scenario has %u buildings but the map holds %u.\n", scenario->building_count, MAX_BUILDINGS);
+        scenario->building_count = MAX_BUILDINGS;
+    }
+
+    scenario->cluster_count = min_uint32(max_uint32(scenario->cluster_count, 1), max_uint32(scenario->building_count, 1));
+}
+
+bool parse_scenario(const char *text, struct Scenario *scenario)
+{
+    char buffer[256];
+    if (strlen(text) >= sizeof(buffer))
+    {
+        fprintf(stderr, "[ERROR] Scenario '%s' is too long.\n", text);
+        return false;
+    }
+
+    strcpy(buffer, text);
+
+    char *option = strchr(buffer, ',');
+    if (option)
+        *option++ = '\0';
+
+    const struct ScenarioPreset *preset = NULL;
+    for (uint32 i = 0; i < ARRAY_SIZE(scenario_presets); ++i)
+    {
+        if (!strcmp(buffer, scenario_presets[i].name))
+            preset = &scenario_presets[i];
+    }
+
+    if (!preset)
+    {
+        fprintf(stderr, "[ERROR] Unknown scenario '%s'.\n", buffer);
+        print_scenario_usage();
+        return false;
+    }
+
+    *scenario = preset->scenario;
+
+    while (option)
+    {
+        char *next = strchr(option, ',');
+        if (next)
+            *next++ = '\0';
+
+        char *value = strchr(option, '=');
+        if (value)
+            *value++ = '\0';
+
+        if (!value || !apply_scenario_option(scenario, option, value))
+        {
+            fprintf(stderr, "[ERROR] Bad scenario override '%s'.\n", option);
+            print_scenario_usage();
+            return false;
+        }
+
+        option = next;
+    }
+
+    fit_scenario(scenario);
+
+    fprintf(stderr, "Scenario '%s': %u v %u ships, %.0f%% repeaters, %s; %u %s buildings; %s broadphase.\n",
+            preset->name, scenario->ship_counts[TEAM_ALLY], scenario->ship_counts[TEAM_ENEMY],
+            (double)(scenario->repeater_share * 100.0f), initial_orders_names[scenario->orders],
+            scenario->building_count, building_layout_names[scenario->building_layout],
+            broadphase_type_names[scenario->broadphase]);
+    return true;
+}
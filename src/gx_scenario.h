@@ -0,0 +1,21 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx.h"
+
+//
+// Named scenarios for init_game. A name can be followed by overrides, as in
+// "stress,ships=2000,layout=grid", to scale or reshape a preset without
+// adding another, or "clusters,broadphase=grid" to compare how the
+// collision backends handle the same battle. Ship and building counts beyond what this build's
+// GameState holds are scaled down with a message; the 10k a side of
+// "stress" only fits with make STRESS=1. "stress" uses the grid broadphase:
+// with two armies passing through each other, sweep and prune spends most
+// of the tick re-sorting endpoints.
+//
+
+#define DEFAULT_SCENARIO "default"
+
+// Fills 'scenario' from 'text'. Returns false, after listing the presets and
+// overrides, if the name or an override is not recognized.
+bool parse_scenario(const char *text, struct Scenario *scenario);
@@ -0,0 +1,263 @@
+#define _DEFAULT_SOURCE // MAP_FIXED
+
+#include "gx_snapshot.h"
+#include "gx_hash.h"
+#include "gx_memory.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint32 get_build_flags(void)
+{
+#ifdef GX_FIXED_POINT
+    return SNAPSHOT_FIXED_POINT;
+#else
+    return 0;
+#endif
+}
+
+static void hash_layout_field(struct Hash *hash, const char *name, size_t offset, size_t size)
+{
+    uint64 layout[2] = { offset, size };
+    update_hash(hash, name, strlen(name));
+    update_hash(hash, layout, sizeof(layout));
+}
+
+#define HASH_LAYOUT_FIELD(hash, type, field) \
+    hash_layout_field((hash), #type "." #field, offsetof(type, field), sizeof(((type *)0)->field))
+
+// Offsets and sizes of GameState's fields and of the structs it holds arrays
+// of. A reordered or resized field changes this even when sizeof(struct
+// GameState) does not. Fields added to those structs belong here too.
+static uint64 get_state_layout_hash(void)
+{
+    struct Hash hash = begin_hash(0);
+
+    HASH_LAYOUT_FIELD(&hash, struct GameState, camera);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, tick_count);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, deterministic);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, random);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, state_hash);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, visibility_graph);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, buildings);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, building_count);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, building_bvh);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, building_occupancy);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, ships);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, ship_count);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, ship_ids);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, ship_id_map);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, selected_ships);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, selected_ship_count);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, path_request_count);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, tier_counts);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, ship_broadphase);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, pair_sort_keys);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, pair_sort_scratch);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, projectiles);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, projectile_count);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, removals_since_spatial_sort);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, sort_keys);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, sort_scratch);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, worker_count);
+    HASH_LAYOUT_FIELD(&hash, struct GameState, stats);
+
+    HASH_LAYOUT_FIELD(&hash, struct Camera, position);
+    HASH_LAYOUT_FIELD(&hash, struct Camera, rotation);
+    HASH_LAYOUT_FIELD(&hash, struct Camera, zoom);
+    HASH_LAYOUT_FIELD(&hash, struct Camera, move_velocity);
+    HASH_LAYOUT_FIELD(&hash, struct Camera, zoom_velocity);
+    HASH_LAYOUT_FIELD(&hash, struct Camera, previous_position);
+    HASH_LAYOUT_FIELD(&hash, struct Camera, previous_zoom);
+
+    HASH_LAYOUT_FIELD(&hash, struct Ship, id);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, team);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, flags);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, position);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, rotation);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, size);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, previous_position);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, move_velocity);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, rotation_velocity);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, health);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, fire_cooldown);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, fire_cooldown_timer);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, path);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, broadphase_proxy);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, tier);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, idle_ticks);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, pending_dt);
+    HASH_LAYOUT_FIELD(&hash, struct Ship, step_dt);
+
+    HASH_LAYOUT_FIELD(&hash, struct Path, node_indices);
+    HASH_LAYOUT_FIELD(&hash, struct Path, node_count);
+    HASH_LAYOUT_FIELD(&hash, struct Path, current_node_index);
+    HASH_LAYOUT_FIELD(&hash, struct Path, start);
+    HASH_LAYOUT_FIELD(&hash, struct Path, end);
+
+    HASH_LAYOUT_FIELD(&hash, struct Projectile, owner);
+    HASH_LAYOUT_FIELD(&hash, struct Projectile, team);
+    HASH_LAYOUT_FIELD(&hash, struct Projectile, damage);
+    HASH_LAYOUT_FIELD(&hash, struct Projectile, position);
+    HASH_LAYOUT_FIELD(&hash, struct Projectile, size);
+    HASH_LAYOUT_FIELD(&hash, struct Projectile, velocity);
+    HASH_LAYOUT_FIELD(&hash, struct Projectile, previous_position);
+    HASH_LAYOUT_FIELD(&hash, struct Projectile, lifetime);
+
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, type);
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, proxies);
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, proxy_count);
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, first_free_proxy);
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, pairs);
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, pair_count);
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, tested_pair_count);
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, sap);
+    HASH_LAYOUT_FIELD(&hash, struct Broadphase, grid);
+
+    return end_hash(&hash);
+}
+
+static bool write_all(int fd, const void *data, size_t size)
+{
+    const uint8 *bytes = (const uint8 *)data;
+    while (size > 0)
+    {
+        ssize_t written = write(fd, bytes, size);
+        if (written <= 0)
+            return false;
+
+        bytes += written;
+        size -= (size_t)written;
+    }
+
+    return true;
+}
+
+static bool read_all(int fd, void *data, size_t size, off_t offset)
+{
+    uint8 *bytes = (uint8 *)data;
+    while (size > 0)
+    {
+        ssize_t count = pread(fd, bytes, size, offset);
+        if (count <= 0)
+            return false;
+
+        bytes += count;
+        size -= (size_t)count;
+        offset += count;
+    }
+
+    return true;
+}
+
+bool save_game_snapshot(struct GameMemory *memory, const char *path)
+{
+    struct GameState *game_state = (struct GameState *)memory->game_memory;
+
+    struct SnapshotHeader header = {0};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.flags = get_build_flags();
+    header.tick_count = game_state->tick_count;
+    header.state_hash = game_state->state_hash;
+    header.state_size = sizeof(struct GameState);
+    header.layout_hash = get_state_layout_hash();
+    header.data_offset = get_page_size();
+
+    // Pad the block to whole pages so the mapping never reaches past the end of the file.
+    size_t data_size = round_up_to_page(sizeof(struct GameState));
+    ASSERT(data_size <= memory->game_memory_size);
+
+    // Write next to the target and rename over it. A snapshot that is
+    // currently mapped keeps its old inode, so loaded games are unaffected.
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        fprintf(stderr, "[ERROR] Failed to open snapshot '%s' for writing.\n", temp_path);
+        return false;
+    }
+
+    uint8 header_page[65536] = {0};
+    ASSERT(header.data_offset <= sizeof(header_page));
+    memcpy(header_page, &header, sizeof(header));
+
+    bool written = write_all(fd, header_page, header.data_offset) &&
+                   write_all(fd, memory->game_memory, data_size);
+    close(fd);
+
+    if (!written || (rename(temp_path, path) != 0))
+    {
+        fprintf(stderr, "[ERROR] Failed to write snapshot '%s'.\n", path);
+        unlink(temp_path);
+        return false;
+    }
+
+    fprintf(stderr, "Saved snapshot of tick %u to '%s', %zu KB.\n", header.tick_count, path, data_size / 1024);
+    return true;
+}
+
+bool load_game_snapshot(struct GameMemory *memory, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "[ERROR] Failed to open snapshot '%s'.\n", path);
+        return false;
+    }
+
+    struct SnapshotHeader header = {0};
+    if ((pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) ||
+        (header.magic != SNAPSHOT_MAGIC) || (header.version != SNAPSHOT_VERSION) ||
+        (header.flags != get_build_flags()) || (header.state_size != sizeof(struct GameState)) ||
+        (header.layout_hash != get_state_layout_hash()) ||
+        (header.data_offset % get_page_size() != 0))
+    {
+        fprintf(stderr, "[ERROR] '%s' is not a snapshot from this build.\n", path);
+        close(fd);
+        return false;
+    }
+
+    // Touching a mapped page past the end of a truncated file would raise SIGBUS mid-tick.
+    size_t data_size = round_up_to_page(sizeof(struct GameState));
+    struct stat file_stat;
+    if ((fstat(fd, &file_stat) != 0) || ((uint64)file_stat.st_size < header.data_offset + data_size))
+    {
+        fprintf(stderr, "[ERROR] Snapshot '%s' is truncated.\n", path);
+        close(fd);
+        return false;
+    }
+
+    ASSERT(data_size <= memory->game_memory_size);
+    ASSERT(((uintptr_t)memory->game_memory % get_page_size()) == 0);
+
+    // Part of a hugetlb mapping cannot be replaced, so copy instead.
+    if (memory->page_size > get_page_size())
+    {
+        bool read = read_all(fd, memory->game_memory, data_size, (off_t)header.data_offset);
+        close(fd);
+
+        if (!read)
+            fprintf(stderr, "[ERROR] Failed to read snapshot '%s'.\n", path);
+        return read;
+    }
+
+    // Private mapping: the simulation writes to its own copy of each page,
+    // never to the file. The mapping outlives the descriptor.
+    void *mapped = mmap(memory->game_memory, data_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, (off_t)header.data_offset);
+    close(fd);
+
+    if (mapped == MAP_FAILED)
+    {
+        fprintf(stderr, "[ERROR] Failed to map snapshot '%s'.\n", path);
+        return false;
+    }
+
+    ASSERT(mapped == memory->game_memory);
+    return true;
+}
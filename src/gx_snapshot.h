@@ -0,0 +1,40 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx.h"
+
+//
+// Snapshot files are a header page followed by the GameState block, byte for
+// byte. GameState holds no pointers, so loading maps the file over the game
+// memory copy-on-write instead of parsing it; pages fault in as the next tick
+// touches them.
+//
+
+#define SNAPSHOT_MAGIC   0x53535847 // "GXSS"
+#define SNAPSHOT_VERSION 2
+
+enum SnapshotFlags
+{
+    SNAPSHOT_FIXED_POINT = 0x01,
+};
+
+struct SnapshotHeader
+{
+    uint32 magic;
+    uint32 version;
+    uint32 flags;
+
+    uint32 tick_count;
+    uint64 state_hash;
+
+    // sizeof(struct GameState) and a hash of its field offsets when saved;
+    // a different build layout is rejected.
+    uint64 state_size;
+    uint64 layout_hash;
+
+    // Page-aligned file offset of the GameState block.
+    uint64 data_offset;
+};
+
+bool save_game_snapshot(struct GameMemory *memory, const char *path);
+bool load_game_snapshot(struct GameMemory *memory, const char *path);
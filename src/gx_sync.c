@@ -0,0 +1,119 @@
+#include "gx_sync.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIPLE_BUFFER_INDEX_MASK 0x3
+#define TRIPLE_BUFFER_FRESH      0x4
+
+// Slots and items start on their own cache line so the two threads do not
+// share one.
+#define SYNC_ALIGNMENT 64
+
+static size_t align_size(size_t size)
+{
+    return (size + SYNC_ALIGNMENT - 1) & ~(size_t)(SYNC_ALIGNMENT - 1);
+}
+
+bool init_triple_buffer(struct TripleBuffer *buffer, size_t slot_size)
+{
+    memset(buffer, 0, sizeof(*buffer));
+
+    buffer->slot_size = align_size(slot_size);
+    buffer->slots = aligned_alloc(SYNC_ALIGNMENT, 3 * buffer->slot_size);
+    if (!buffer->slots)
+    {
+        fprintf(stderr, "[ERROR] Failed to allocate %zu KB for a triple buffer.\n", 3 * buffer->slot_size / 1024);
+        return false;
+    }
+
+    memset(buffer->slots, 0, 3 * buffer->slot_size);
+    buffer->write_index = 0;
+    buffer->read_index = 1;
+    atomic_init(&buffer->shared, 2);
+    return true;
+}
+
+void free_triple_buffer(struct TripleBuffer *buffer)
+{
+    free(buffer->slots);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+void *get_triple_buffer_write_slot(struct TripleBuffer *buffer)
+{
+    return buffer->slots + buffer->write_index * buffer->slot_size;
+}
+
+void publish_triple_buffer(struct TripleBuffer *buffer)
+{
+    // Release makes the slot contents visible with the index; acquire makes
+    // sure the reader is done with the slot we get back.
+    uint32 previous = atomic_exchange_explicit(&buffer->shared, buffer->write_index | TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+    buffer->write_index = previous & TRIPLE_BUFFER_INDEX_MASK;
+}
+
+void *acquire_triple_buffer(struct TripleBuffer *buffer)
+{
+    if (atomic_load_explicit(&buffer->shared, memory_order_relaxed) & TRIPLE_BUFFER_FRESH)
+    {
+        uint32 previous = atomic_exchange_explicit(&buffer->shared, buffer->read_index, memory_order_acq_rel);
+        buffer->read_index = previous & TRIPLE_BUFFER_INDEX_MASK;
+        buffer->has_read = true;
+    }
+
+    if (!buffer->has_read)
+        return NULL;
+
+    return buffer->slots + buffer->read_index * buffer->slot_size;
+}
+
+bool init_ring_queue(struct RingQueue *queue, size_t item_size, uint32 capacity)
+{
+    ASSERT((capacity > 0) && ((capacity & (capacity - 1)) == 0));
+    memset(queue, 0, sizeof(*queue));
+
+    queue->item_size = item_size;
+    queue->item_stride = align_size(item_size);
+    queue->capacity = capacity;
+    queue->items = aligned_alloc(SYNC_ALIGNMENT, capacity * queue->item_stride);
+    if (!queue->items)
+    {
+        fprintf(stderr, "[ERROR] Failed to allocate %zu KB for a queue.\n", capacity * queue->item_stride / 1024);
+        return false;
+    }
+
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return true;
+}
+
+void free_ring_queue(struct RingQueue *queue)
+{
+    free(queue->items);
+    memset(queue, 0, sizeof(*queue));
+}
+
+bool push_ring_queue(struct RingQueue *queue, const void *item)
+{
+    uint32 tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint32 head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head == queue->capacity)
+        return false;
+
+    memcpy(queue->items + (tail & (queue->capacity - 1)) * queue->item_stride, item, queue->item_size);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool pop_ring_queue(struct RingQueue *queue, void *item)
+{
+    uint32 head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint32 tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == tail)
+        return false;
+
+    memcpy(item, queue->items + (head & (queue->capacity - 1)) * queue->item_stride, queue->item_size);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "gx_define.h"
+
+#include <stdatomic.h>
+
+//
+// Lock-free handoffs between the main thread and the simulation thread. Each
+// has exactly one producer and one consumer, and neither side ever waits on
+// the other.
+//
+
+// Three slots: one the writer fills, one the reader holds, and one holding
+// the newest complete write. Publishing and acquiring swap a slot with the
+// shared one, so the reader always gets the latest state and skips any it
+// was too slow to see.
+struct TripleBuffer
+{
+    uint8 *slots;
+    size_t slot_size;
+
+    // Owned by the writer and the reader respectively.
+    uint32 write_index;
+    uint32 read_index;
+
+    // Index of the shared slot, plus TRIPLE_BUFFER_FRESH while it holds a
+    // write the reader has not taken.
+    _Atomic uint32 shared;
+    bool has_read;
+};
+
+bool init_triple_buffer(struct TripleBuffer *buffer, size_t slot_size);
+void free_triple_buffer(struct TripleBuffer *buffer);
+
+// The slot to fill next; it stays the same until published.
+void *get_triple_buffer_write_slot(struct TripleBuffer *buffer);
+void publish_triple_buffer(struct TripleBuffer *buffer);
+
+// The newest published slot, NULL before the first publish. The slot stays
+// valid and unchanged until the next call.
+void *acquire_triple_buffer(struct TripleBuffer *buffer);
+
+// Fixed-size ring of items copied in and out by value.
+struct RingQueue
+{
+    uint8 *items;
+    size_t item_size;
+    size_t item_stride;
+    uint32 capacity;
+
+    // Free-running counters; the difference is the item count.
+    _Atomic uint32 head;
+    _Atomic uint32 tail;
+};
+
+// 'capacity' must be a power of two.
+bool init_ring_queue(struct RingQueue *queue, size_t item_size, uint32 capacity);
+void free_ring_queue(struct RingQueue *queue);
+
+// Returns false if the queue is full.
+bool push_ring_queue(struct RingQueue *queue, const void *item);
+// Returns false if the queue is empty.
+bool pop_ring_queue(struct RingQueue *queue, void *item);
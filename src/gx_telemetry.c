@@ -0,0 +1,179 @@
+#define _DEFAULT_SOURCE // MAP_NORESERVE, ftruncate()
+
+#include "gx_telemetry.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// The file grows a chunk at a time: 65536 records, over half an hour at 30 Hz.
+#define TELEMETRY_CHUNK_SIZE   MEGABYTES(4)
+#define TELEMETRY_CHUNK_RECORDS (TELEMETRY_CHUNK_SIZE / sizeof(struct TelemetryRecord))
+#define TELEMETRY_MAX_SIZE     MEGABYTES(1024)
+
+// Extends the file by a chunk, maps it after the previous one and touches
+// every page, so the writer never takes a fault that allocates.
+static bool grow_telemetry_file(struct TelemetryWriter *writer)
+{
+    size_t offset = writer->mapped_size;
+    if (offset + TELEMETRY_CHUNK_SIZE > TELEMETRY_MAX_SIZE)
+    {
+        fprintf(stderr, "Telemetry log '%s' is full; later ticks are dropped.\n", writer->path);
+        return false;
+    }
+
+    if (ftruncate(writer->fd, (off_t)(offset + TELEMETRY_CHUNK_SIZE)) != 0)
+    {
+        fprintf(stderr, "[ERROR] Failed to grow telemetry log '%s'; later ticks are dropped.\n", writer->path);
+        return false;
+    }
+
+    void *chunk = mmap(writer->base + offset, TELEMETRY_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, writer->fd, (off_t)offset);
+    if (chunk == MAP_FAILED)
+    {
+        fprintf(stderr, "[ERROR] Failed to map telemetry log '%s'; later ticks are dropped.\n", writer->path);
+        return false;
+    }
+
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < TELEMETRY_CHUNK_SIZE; i += page_size)
+        ((volatile uint8 *)chunk)[i] = 0;
+
+    writer->mapped_size = offset + TELEMETRY_CHUNK_SIZE;
+    uint64 capacity = (writer->mapped_size - sizeof(struct TelemetryHeader)) / sizeof(struct TelemetryRecord);
+    atomic_store_explicit(&writer->record_capacity, capacity, memory_order_release);
+    return true;
+}
+
+static void *run_telemetry_helper(void *data)
+{
+    struct TelemetryWriter *writer = (struct TelemetryWriter *)data;
+
+    while (true)
+    {
+        sem_wait(&writer->grow);
+        if (!atomic_load(&writer->running))
+            break;
+
+        if (!grow_telemetry_file(writer))
+            break;
+    }
+
+    return NULL;
+}
+
+bool open_telemetry(struct TelemetryWriter *writer, const char *path, double ticks_per_second)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->path = path;
+
+    writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0)
+    {
+        fprintf(stderr, "[ERROR] Failed to open telemetry log '%s' for writing.\n", path);
+        return false;
+    }
+
+    void *base = mmap(NULL, TELEMETRY_MAX_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        fprintf(stderr, "[ERROR] Failed to reserve address space for telemetry.\n");
+        close(writer->fd);
+        writer->fd = -1;
+        return false;
+    }
+
+    writer->base = (uint8 *)base;
+    if (!grow_telemetry_file(writer))
+    {
+        munmap(writer->base, TELEMETRY_MAX_SIZE);
+        close(writer->fd);
+        writer->fd = -1;
+        return false;
+    }
+
+    writer->header = (struct TelemetryHeader *)writer->base;
+    writer->records = (struct TelemetryRecord *)(writer->base + sizeof(struct TelemetryHeader));
+
+    struct TelemetryHeader *header = writer->header;
+    header->magic = TELEMETRY_MAGIC;
+    header->version = TELEMETRY_VERSION;
+    header->header_size = sizeof(struct TelemetryHeader);
+    header->record_size = sizeof(struct TelemetryRecord);
+    header->ticks_per_second = ticks_per_second;
+    atomic_store_explicit(&header->record_count, 0, memory_order_release);
+
+    sem_init(&writer->grow, 0, 0);
+    atomic_store(&writer->running, true);
+    if (pthread_create(&writer->helper, NULL, run_telemetry_helper, writer) != 0)
+    {
+        // The first chunk still works; the log just stops growing.
+        fprintf(stderr, "[ERROR] Failed to start the telemetry helper.\n");
+        atomic_store(&writer->running, false);
+    }
+
+    fprintf(stderr, "Writing telemetry to '%s'.\n", path);
+    return true;
+}
+
+void write_telemetry(struct TelemetryWriter *writer, struct GameState *game_state, uint64 tick_time, uint64 render_time)
+{
+    uint64 start = rdtsc();
+
+    uint64 capacity = atomic_load_explicit(&writer->record_capacity, memory_order_acquire);
+    if (writer->record_count >= capacity)
+    {
+        ++writer->dropped_count;
+        return;
+    }
+
+    struct TelemetryRecord *record = &writer->records[writer->record_count++];
+    record->tick_time = tick_time;
+    record->render_time = render_time;
+    record->tick = game_state->tick_count;
+    record->ship_count = game_state->ship_count;
+    record->active_ship_count = game_state->tier_counts[TIER_ACTIVE];
+    record->projectile_count = game_state->projectile_count;
+    record->stats = game_state->stats;
+
+    atomic_store_explicit(&writer->header->record_count, writer->record_count, memory_order_release);
+
+    // Half a chunk before the end, have the helper map the next one.
+    if (writer->record_count + TELEMETRY_CHUNK_RECORDS / 2 == capacity)
+        sem_post(&writer->grow);
+
+    writer->write_time += rdtsc() - start;
+}
+
+void close_telemetry(struct TelemetryWriter *writer)
+{
+    if (!writer->base)
+        return;
+
+    if (atomic_load(&writer->running))
+    {
+        atomic_store(&writer->running, false);
+        sem_post(&writer->grow);
+        pthread_join(writer->helper, NULL);
+    }
+
+    sem_destroy(&writer->grow);
+
+    uint64 record_count = writer->record_count;
+    double ticks_per_second = writer->header->ticks_per_second;
+    munmap(writer->base, TELEMETRY_MAX_SIZE);
+
+    if (ftruncate(writer->fd, (off_t)(sizeof(struct TelemetryHeader) + record_count * sizeof(struct TelemetryRecord))) != 0)
+        fprintf(stderr, "[ERROR] Failed to trim telemetry log '%s'.\n", writer->path);
+
+    close(writer->fd);
+
+    double nanoseconds = (record_count > 0) ? (double)writer->write_time * 1e9 / ticks_per_second / (double)record_count : 0.0;
+    fprintf(stderr, "Wrote %llu telemetry records to '%s', %.0f ns per tick", (unsigned long long)record_count, writer->path, nanoseconds);
+    if (writer->dropped_count > 0)
+        fprintf(stderr, ", %llu dropped", (unsigned long long)writer->dropped_count);
+    fprintf(stderr, ".\n");
+
+    memset(writer, 0, sizeof(*writer));
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+//
+// Telemetry logs hold one fixed-size record per tick: entity counts, the
+// tick's TickStats, and how long the tick and the latest frame took. The file
+// is a header followed by the records and is written through a shared
+// mapping, so appending is a copy into memory the kernel writes back on its
+// own. A helper thread grows the file and faults the next chunk in ahead of
+// the writer; if it ever falls behind, records are dropped rather than
+// waited for. tools/gx_telemetry_csv.c turns a log into CSV.
+//
+
+#define TELEMETRY_MAGIC   0x4d545847 // "GXTM"
+#define TELEMETRY_VERSION 1
+
+struct TelemetryHeader
+{
+    uint32 magic;
+    uint32 version;
+    uint32 header_size;
+    uint32 record_size;
+
+    // Rate of the timestamp counter the durations are measured in.
+    double ticks_per_second;
+
+    // Stored after each record is complete, so a reader of a live log only
+    // sees whole records.
+    _Atomic uint64 record_count;
+
+    uint8 reserved[32];
+};
+
+struct TelemetryRecord
+{
+    // Timestamp counter ticks spent in tick_game, and in the newest frame's
+    // render_game; zero without a renderer.
+    uint64 tick_time;
+    uint64 render_time;
+
+    uint32 tick;
+    uint32 ship_count;
+    uint32 active_ship_count;
+    uint32 projectile_count;
+
+    struct TickStats stats;
+};
+
+struct TelemetryWriter
+{
+    const char *path;
+    int fd;
+
+    // Address space for the largest log, reserved up front so the mapped
+    // chunks stay contiguous.
+    uint8 *base;
+    struct TelemetryHeader *header;
+    struct TelemetryRecord *records;
+    uint64 record_count;
+    uint64 dropped_count;
+
+    // Records the mapped and faulted-in chunks hold. Raised by the helper.
+    _Atomic uint64 record_capacity;
+    size_t mapped_size;
+
+    pthread_t helper;
+    sem_t grow;
+    atomic_bool running;
+
+    // Timestamp counter ticks spent in write_telemetry, for the cost report.
+    uint64 write_time;
+};
+
+// 'ticks_per_second' is the rate of the timestamp counter the durations
+// passed to write_telemetry are measured in.
+bool open_telemetry(struct TelemetryWriter *writer, const char *path, double ticks_per_second);
+
+// Appends a record for the tick just simulated. Never waits on the disk or
+// the helper thread.
+void write_telemetry(struct TelemetryWriter *writer, struct GameState *game_state, uint64 tick_time, uint64 render_time);
+
+// Trims the file to the records written and reports the writer's cost.
+void close_telemetry(struct TelemetryWriter *writer);
@@ -0,0 +1,284 @@
+#include "gx_trace.h"
+#include "gx_math.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// A lapped ring is still being overwritten at its oldest end while we copy,
+// so that many of the oldest events are left out.
+#define TRACE_RING_MARGIN 1024
+
+// Deeper zones are still written, without counters.
+#define MAX_TRACE_DEPTH 64
+
+struct TraceThread
+{
+    const char *name;
+    struct ProfileEvent *events;
+    struct PerfCounterValues *counters;
+    uint64 event_count;
+};
+
+// Everything the writer needs, owned by it once handed over.
+struct TraceJob
+{
+    const char *path;
+    struct TraceCapture *capture;
+    uint32 frame_count;
+    double ticks_per_second;
+    uint32 counter_mask;
+    uint32 entity_count;
+
+    uint32 thread_count;
+    struct TraceThread threads[MAX_PROFILE_THREADS];
+
+    // All threads' events, then their counter samples if any.
+    uint8 data[];
+};
+
+static void write_trace_counters(FILE *file, struct TraceJob *job, struct PerfCounterValues *begin, struct PerfCounterValues *end)
+{
+    uint64 counts[PERF_COUNTER_COUNT];
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; ++i)
+        counts[i] = end->values[i] - begin->values[i];
+
+    double entity_count = (double)max_uint32(job->entity_count, 1);
+    double ipc = counts[PERF_COUNTER_CYCLES] ? (double)counts[PERF_COUNTER_INSTRUCTIONS] / (double)counts[PERF_COUNTER_CYCLES] : 0.0;
+    fprintf(file, ",\"args\":{\"ipc\":%.3f", ipc);
+
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; ++i)
+    {
+        if (!(job->counter_mask & (1u << i)))
+            continue;
+
+        const char *name = get_perf_counter_name((enum PerfCounter)i);
+        fprintf(file, ",\"%s\":%llu", name, (unsigned long long)counts[i]);
+        if ((i != PERF_COUNTER_CYCLES) && (i != PERF_COUNTER_INSTRUCTIONS))
+            fprintf(file, ",\"%s_per_entity\":%.3f", name, (double)counts[i] / entity_count);
+    }
+
+    fprintf(file, "}");
+}
+
+static void write_trace(struct TraceJob *job)
+{
+    FILE *file = fopen(job->path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[ERROR] Failed to open trace '%s' for writing.\n", job->path);
+        return;
+    }
+
+    uint64 base = UINT64_MAX;
+    for (uint32 i = 0; i < job->thread_count; ++i)
+    {
+        if (job->threads[i].event_count > 0)
+            base = (job->threads[i].events[0].timestamp < base) ? job->threads[i].events[0].timestamp : base;
+    }
+
+    double microseconds_per_tick = 1e6 / job->ticks_per_second;
+    uint64 written = 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"gx\"}}");
+
+    for (uint32 i = 0; i < job->thread_count; ++i)
+    {
+        struct TraceThread *thread = &job->threads[i];
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", i, thread->name);
+        fprintf(file, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}", i, i);
+
+        // Ends whose begin was before the window would close zones the viewer
+        // never saw open. Begins left open run to the end of the trace.
+        uint64 open_events[MAX_TRACE_DEPTH];
+        uint32 depth = 0;
+        for (uint64 j = 0; j < thread->event_count; ++j)
+        {
+            struct ProfileEvent *event = &thread->events[j];
+            if (event->type == PROFILE_EVENT_BEGIN)
+            {
+                if (depth < MAX_TRACE_DEPTH)
+                    open_events[depth] = j;
+                ++depth;
+            }
+            else if (depth > 0)
+            {
+                --depth;
+            }
+            else
+            {
+                continue;
+            }
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                    get_profile_zone_name((enum ProfileZone)event->zone), (event->type == PROFILE_EVENT_BEGIN) ? 'B' : 'E',
+                    (double)(event->timestamp - base) * microseconds_per_tick, i);
+
+            // Viewers merge the arguments of an end into its zone.
+            if ((event->type == PROFILE_EVENT_END) && thread->counters && (depth < MAX_TRACE_DEPTH))
+                write_trace_counters(file, job, &thread->counters[open_events[depth]], &thread->counters[j]);
+
+            fprintf(file, "}");
+            ++written;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+
+    if (fclose(file) != 0)
+    {
+        fprintf(stderr, "[ERROR] Failed to write trace '%s'.\n", job->path);
+        return;
+    }
+
+    fprintf(stderr, "Wrote %llu events over %u frames to '%s'.\n", (unsigned long long)written, job->frame_count, job->path);
+}
+
+static void *run_trace_writer(void *data)
+{
+    struct TraceJob *job = (struct TraceJob *)data;
+    struct TraceCapture *capture = job->capture;
+
+    write_trace(job);
+    free(job);
+
+    atomic_store_explicit(&capture->writer_done, true, memory_order_release);
+    return NULL;
+}
+
+static void wait_for_trace_writer(struct TraceCapture *capture)
+{
+    if (!capture->has_writer)
+        return;
+
+    pthread_join(capture->writer, NULL);
+    capture->has_writer = false;
+}
+
+// Copies each ring from where the capture started and starts the writer.
+static void end_trace_capture(struct TraceCapture *capture)
+{
+    uint32 frame_count = capture->frame_count - capture->frames_left;
+    capture->capturing = false;
+
+    uint32 thread_count = get_profile_thread_count();
+    uint64 first[MAX_PROFILE_THREADS];
+    uint64 end[MAX_PROFILE_THREADS];
+    uint64 total = 0;
+
+    for (uint32 i = 0; i < thread_count; ++i)
+    {
+        struct ProfileThread *thread = get_profile_thread(i);
+        end[i] = atomic_load_explicit(&thread->event_count, memory_order_acquire);
+        first[i] = capture->first_events[i];
+
+        if (end[i] - first[i] > PROFILE_EVENT_CAPACITY - TRACE_RING_MARGIN)
+        {
+            uint64 kept = PROFILE_EVENT_CAPACITY - TRACE_RING_MARGIN;
+            fprintf(stderr, "Trace dropped the first %llu events of thread '%s'.\n",
+                    (unsigned long long)(end[i] - first[i] - kept), thread->name);
+            first[i] = end[i] - kept;
+        }
+
+        total += end[i] - first[i];
+    }
+
+    uint32 counter_mask = get_profile_counter_mask();
+    size_t sample_size = sizeof(struct ProfileEvent) + (counter_mask ? sizeof(struct PerfCounterValues) : 0);
+
+    struct TraceJob *job = malloc(sizeof(struct TraceJob) + total * sample_size);
+    if (!job)
+    {
+        fprintf(stderr, "[ERROR] Failed to allocate %llu KB for a trace.\n", (unsigned long long)(total * sample_size / 1024));
+        return;
+    }
+
+    job->path = capture->path;
+    job->capture = capture;
+    job->frame_count = frame_count;
+    job->ticks_per_second = get_profile_ticks_per_second();
+    job->counter_mask = counter_mask;
+    job->entity_count = capture->entity_count;
+    job->thread_count = thread_count;
+
+    struct ProfileEvent *events = (struct ProfileEvent *)job->data;
+    struct PerfCounterValues *counters = (struct PerfCounterValues *)(events + total);
+    for (uint32 i = 0; i < thread_count; ++i)
+    {
+        struct ProfileThread *thread = get_profile_thread(i);
+        struct TraceThread *trace_thread = &job->threads[i];
+        trace_thread->name = thread->name;
+        trace_thread->events = events;
+        trace_thread->counters = (counter_mask && thread->counters) ? counters : NULL;
+        trace_thread->event_count = end[i] - first[i];
+
+        // The range may wrap around the end of the ring.
+        for (uint64 j = first[i]; j < end[i]; ++j)
+        {
+            uint32 slot = j & (PROFILE_EVENT_CAPACITY - 1);
+            *events++ = thread->events[slot];
+            if (trace_thread->counters)
+                *counters++ = thread->counters[slot];
+        }
+    }
+
+    atomic_store_explicit(&capture->writer_done, false, memory_order_relaxed);
+    if (pthread_create(&capture->writer, NULL, run_trace_writer, job) != 0)
+    {
+        fprintf(stderr, "[ERROR] Failed to start the trace writer.\n");
+        free(job);
+        return;
+    }
+
+    capture->has_writer = true;
+}
+
+bool start_trace_capture(struct TraceCapture *capture, const char *path, uint32 frame_count)
+{
+    ASSERT(frame_count > 0);
+
+    if (capture->capturing)
+        return false;
+
+    if (capture->has_writer)
+    {
+        if (!atomic_load_explicit(&capture->writer_done, memory_order_acquire))
+            return false;
+
+        wait_for_trace_writer(capture);
+    }
+
+    capture->path = path;
+    capture->capturing = true;
+    capture->frame_count = frame_count;
+    capture->frames_left = frame_count;
+
+    for (uint32 i = 0; i < MAX_PROFILE_THREADS; ++i)
+    {
+        // Threads that register later start at zero.
+        capture->first_events[i] = (i < get_profile_thread_count())
+            ? atomic_load_explicit(&get_profile_thread(i)->event_count, memory_order_acquire)
+            : 0;
+    }
+
+    fprintf(stderr, "Capturing a trace of %u frames to '%s'.\n", frame_count, path);
+    return true;
+}
+
+void update_trace_capture(struct TraceCapture *capture, uint32 entity_count)
+{
+    if (!capture->capturing)
+        return;
+
+    capture->entity_count = entity_count;
+    if (--capture->frames_left == 0)
+        end_trace_capture(capture);
+}
+
+void finish_trace_capture(struct TraceCapture *capture)
+{
+    if (capture->capturing)
+        end_trace_capture(capture);
+
+    wait_for_trace_writer(capture);
+}
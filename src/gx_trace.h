@@ -0,0 +1,47 @@
+#pragma once
+
+#include "gx_define.h"
+#include "gx_profile.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+//
+// Trace captures. A capture copies what the profiler rings recorded over a
+// window of frames and writes it as Chrome trace_event JSON, which
+// chrome://tracing and ui.perfetto.dev both open. Each profiled thread gets
+// its own track. The copy is taken on the calling thread; formatting and
+// writing the file happen on a writer thread so the frame does not hitch.
+// With hardware counters on, each zone carries its counts as arguments.
+//
+
+// Five seconds at 60 Hz, well inside what the rings hold.
+#define TRACE_CAPTURE_FRAMES 300
+
+struct TraceCapture
+{
+    const char *path;
+    bool capturing;
+    uint32 frame_count;
+    uint32 frames_left;
+
+    // Divides the misses of each zone; the latest count is used for all of them.
+    uint32 entity_count;
+
+    // Ring positions when the capture started.
+    uint64 first_events[MAX_PROFILE_THREADS];
+
+    pthread_t writer;
+    bool has_writer;
+    _Atomic bool writer_done;
+};
+
+// Returns false if a capture is running or the previous file is still being written.
+bool start_trace_capture(struct TraceCapture *capture, const char *path, uint32 frame_count);
+
+// Call once per frame, outside any profile zone. Hands the events to the
+// writer when the window is complete.
+void update_trace_capture(struct TraceCapture *capture, uint32 entity_count);
+
+// Writes a capture still in progress and waits for the writer.
+void finish_trace_capture(struct TraceCapture *capture);
@@ -1,13 +1,53 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 
 #include "gx_define.h"
+#include "gx_alloc_check.h"
 #include "gx_io.h"
 #include "gx_math.h"
+#include "gx_memory.h"
+#include "gx_overlay.h"
+#include "gx_profile.h"
 #include "gx_renderer.h"
+#include "gx_replay.h"
+#include "gx_rewind.h"
+#include "gx_scenario.h"
+#include "gx_snapshot.h"
+#include "gx_sync.h"
+#include "gx_telemetry.h"
+#include "gx_trace.h"
 #include "gx.h"
 
+// Built by 'make game'; reloaded whenever it changes.
+#define GAME_LIBRARY_PATH "bin/libgx_game.so"
+
+// Default fixed address of game memory, far from where the kernel places
+// the heap, libraries and stacks. --memory-base 0 lets the kernel choose.
+#define GAME_MEMORY_BASE_ADDRESS 0x100000000000ull
+
+struct GameCode
+{
+    void *library;
+    struct timespec write_time;
+    uint32 load_count;
+
+    init_game_function *init_game;
+    get_static_state_range_function *get_static_state_range;
+    tick_game_function *tick_game;
+    render_game_function *render_game;
+    copy_render_state_function *copy_render_state;
+    extract_render_buffer_function *extract_render_buffer;
+};
+
 struct GameWindow
 {
     GLFWwindow *glfw;
@@ -15,12 +55,336 @@ struct GameWindow
     uint32 height;
 };
 
+// Input for one tick as sampled on the main thread.
+struct TickInput
+{
+    struct Input input;
+    double sample_time;
+};
+
+// What the simulation publishes after each tick.
+struct RenderFrame
+{
+    struct RenderState state;
+
+    // Ticks simulated so far, to place the frame on the main thread's clock.
+    uint64 tick_sequence;
+
+    // When the input of that tick was sampled.
+    double input_time;
+};
+
+// The simulation consumes queued tick inputs and publishes a RenderFrame
+// after each tick. It runs on its own thread unless started with
+// --single-thread, in which case the main thread drains the queue every
+// frame, which is how the game used to run.
+struct Simulation
+{
+    struct GameCode *game_code;
+    struct GameMemory *memory;
+    struct RewindBuffer *rewind_buffer;
+
+    uint32 screen_width;
+    uint32 screen_height;
+    float tick_dt;
+    uint32 ticks_per_second;
+    uint64 tick_sequence;
+
+    struct RingQueue inputs;
+    struct TripleBuffer frames;
+
+    bool threaded;
+    pthread_t thread;
+    sem_t inputs_ready;
+    atomic_bool running;
+
+    // Held while ticking. The main thread only takes it to swap game code,
+    // which is the one time either side waits.
+    pthread_mutex_t code_lock;
+
+    // Written by the simulation after every tick when --telemetry is given.
+    // The main thread stores how long the last frame took to render.
+    struct TelemetryWriter *telemetry;
+    _Atomic uint64 render_time;
+};
+
+struct LatencyStats
+{
+    double total;
+    double max;
+    uint64 count;
+};
+
 static void APIENTRY debug_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user_param)
 {
     // TODO: output severity?
     fprintf(stderr, "[GL_ERROR] %s\n", message);
 }
 
+static bool copy_file(const char *source_path, const char *target_path)
+{
+    FILE *source = fopen(source_path, "rb");
+    if (!source)
+        return false;
+
+    FILE *target = fopen(target_path, "wb");
+    if (!target)
+    {
+        fclose(source);
+        return false;
+    }
+
+    char buffer[65536];
+    size_t size;
+    bool success = true;
+    while ((size = fread(buffer, 1, sizeof(buffer), source)) > 0)
+    {
+        if (fwrite(buffer, 1, size, target) != size)
+        {
+            success = false;
+            break;
+        }
+    }
+
+    success = success && !ferror(source);
+    fclose(source);
+    success = (fclose(target) == 0) && success;
+    return success;
+}
+
+static bool load_game_code(struct GameCode *code, const char *path)
+{
+    struct stat library_stat;
+    if (stat(path, &library_stat) != 0)
+    {
+        fprintf(stderr, "[ERROR] Game library '%s' not found.\n", path);
+        return false;
+    }
+
+    // Remembered even if loading fails, so a broken build is reported once
+    // rather than every frame. The next build changes it again.
+    code->write_time = library_stat.st_mtim;
+
+    // dlopen returns the already loaded library for a path it has seen, and
+    // the linker may rewrite the file while it is mapped. Load a private copy
+    // under a fresh name instead; it can be unlinked once mapped.
+    char loaded_path[4096];
+    snprintf(loaded_path, sizeof(loaded_path), "%s.%u", path, code->load_count + 1);
+    if (!copy_file(path, loaded_path))
+    {
+        fprintf(stderr, "[ERROR] Failed to copy game library to '%s'.\n", loaded_path);
+        remove(loaded_path);
+        return false;
+    }
+
+    void *library = dlopen(loaded_path, RTLD_NOW | RTLD_LOCAL);
+    remove(loaded_path);
+    if (!library)
+    {
+        fprintf(stderr, "[ERROR] Failed to load game library: %s\n", dlerror());
+        return false;
+    }
+
+    // ISO C has no cast from void * to a function pointer; POSIX guarantees
+    // this form works.
+    struct GameCode new_code = *code;
+    new_code.library = library;
+    *(void **)&new_code.init_game = dlsym(library, "init_game");
+    *(void **)&new_code.get_static_state_range = dlsym(library, "get_static_state_range");
+    *(void **)&new_code.tick_game = dlsym(library, "tick_game");
+    *(void **)&new_code.render_game = dlsym(library, "render_game");
+    *(void **)&new_code.copy_render_state = dlsym(library, "copy_render_state");
+    *(void **)&new_code.extract_render_buffer = dlsym(library, "extract_render_buffer");
+
+    get_game_state_size_function *get_state_size;
+    *(void **)&get_state_size = dlsym(library, "get_game_state_size");
+
+    if (!new_code.init_game || !new_code.get_static_state_range || !new_code.tick_game || !new_code.render_game ||
+        !new_code.copy_render_state || !new_code.extract_render_buffer || !get_state_size)
+    {
+        fprintf(stderr, "[ERROR] Game library '%s' is missing entry points.\n", path);
+        dlclose(library);
+        return false;
+    }
+
+    // The memory block outlives the library, so its layout has to match.
+    if (get_state_size() != sizeof(struct GameState))
+    {
+        fprintf(stderr, "[ERROR] GameState layout changed (%zu -> %zu bytes); restart to use this build.\n",
+                sizeof(struct GameState), get_state_size());
+        dlclose(library);
+        return false;
+    }
+
+    // Only now is the old code let go, so a failed reload keeps the game running.
+    if (code->library)
+        dlclose(code->library);
+
+    ++new_code.load_count;
+    *code = new_code;
+    return true;
+}
+
+static bool game_code_changed(struct GameCode *code, const char *path)
+{
+    struct stat library_stat;
+    if (stat(path, &library_stat) != 0)
+        return false;
+
+    return (library_stat.st_mtim.tv_sec != code->write_time.tv_sec) ||
+           (library_stat.st_mtim.tv_nsec != code->write_time.tv_nsec);
+}
+
+static void unload_game_code(struct GameCode *code)
+{
+    if (code->library)
+        dlclose(code->library);
+
+    memset(code, 0, sizeof(*code));
+}
+
+//
+// simulation
+//
+
+static void publish_render_frame(struct Simulation *simulation, double input_time)
+{
+    struct RenderFrame *frame = (struct RenderFrame *)get_triple_buffer_write_slot(&simulation->frames);
+    simulation->game_code->copy_render_state(simulation->memory, &frame->state);
+    frame->tick_sequence = simulation->tick_sequence;
+    frame->input_time = input_time;
+    publish_triple_buffer(&simulation->frames);
+}
+
+static void simulate_tick(struct Simulation *simulation, struct TickInput *tick_input)
+{
+    struct GameMemory *memory = simulation->memory;
+    struct GameState *game_state = (struct GameState *)memory->game_memory;
+    struct RewindBuffer *rewind_buffer = simulation->rewind_buffer;
+    struct Input *input = &tick_input->input;
+
+    // Quicksave and quickload.
+    if (key_down_new(KEY_F5, input))
+        save_game_snapshot(memory, "quicksave.gxs");
+    if (key_down_new(KEY_F9, input) && load_game_snapshot(memory, "quicksave.gxs"))
+    {
+        reset_rewind_buffer(rewind_buffer);
+        push_rewind_snapshot(rewind_buffer, game_state, game_state->tick_count, NULL);
+    }
+
+    if (key_down_new(KEY_BACKSPACE, input))
+    {
+        uint32 step = simulation->ticks_per_second;
+        uint32 oldest_tick = get_oldest_rewind_tick(rewind_buffer);
+        uint32 target_tick = (game_state->tick_count > oldest_tick + step) ? game_state->tick_count - step : oldest_tick;
+        rewind_to_tick(rewind_buffer, game_state, target_tick);
+    }
+
+    set_allocation_phase(ALLOCATION_PHASE_TICK);
+    uint64 tick_start = __rdtsc();
+    simulation->game_code->tick_game(memory, input, simulation->screen_width, simulation->screen_height, simulation->tick_dt);
+    uint64 tick_time = __rdtsc() - tick_start;
+    push_rewind_snapshot(rewind_buffer, game_state, game_state->tick_count, input);
+
+    if (simulation->telemetry)
+        write_telemetry(simulation->telemetry, game_state, tick_time, atomic_load_explicit(&simulation->render_time, memory_order_relaxed));
+    set_allocation_phase(ALLOCATION_PHASE_NONE);
+
+    ++simulation->tick_sequence;
+    publish_render_frame(simulation, tick_input->sample_time);
+}
+
+static void simulate_queued_ticks(struct Simulation *simulation)
+{
+    struct TickInput tick_input;
+
+    pthread_mutex_lock(&simulation->code_lock);
+    while (pop_ring_queue(&simulation->inputs, &tick_input))
+        simulate_tick(simulation, &tick_input);
+    pthread_mutex_unlock(&simulation->code_lock);
+}
+
+static void *run_simulation_thread(void *data)
+{
+    struct Simulation *simulation = (struct Simulation *)data;
+    register_profile_thread("simulation");
+
+    // Ticks are paced by the main thread queueing input, so sleep until it does.
+    while (atomic_load(&simulation->running))
+    {
+        sem_wait(&simulation->inputs_ready);
+        simulate_queued_ticks(simulation);
+    }
+
+    return NULL;
+}
+
+static bool start_simulation(struct Simulation *simulation, bool threaded)
+{
+    simulation->threaded = threaded;
+
+    if (!init_ring_queue(&simulation->inputs, sizeof(struct TickInput), 64) ||
+        !init_triple_buffer(&simulation->frames, sizeof(struct RenderFrame)))
+        return false;
+
+    sem_init(&simulation->inputs_ready, 0, 0);
+    pthread_mutex_init(&simulation->code_lock, NULL);
+
+    // The renderer always has a frame, even before the first tick.
+    publish_render_frame(simulation, 0.0);
+
+    if (!threaded)
+        return true;
+
+    atomic_store(&simulation->running, true);
+    if (pthread_create(&simulation->thread, NULL, run_simulation_thread, simulation) != 0)
+    {
+        fprintf(stderr, "[ERROR] Failed to start the simulation thread.\n");
+        atomic_store(&simulation->running, false);
+        return false;
+    }
+
+    return true;
+}
+
+static void stop_simulation(struct Simulation *simulation)
+{
+    if (simulation->threaded && atomic_load(&simulation->running))
+    {
+        atomic_store(&simulation->running, false);
+        sem_post(&simulation->inputs_ready);
+        pthread_join(simulation->thread, NULL);
+    }
+
+    pthread_mutex_destroy(&simulation->code_lock);
+    sem_destroy(&simulation->inputs_ready);
+    free_triple_buffer(&simulation->frames);
+    free_ring_queue(&simulation->inputs);
+}
+
+// Never blocks. Returns false if the simulation is so far behind that the
+// queue is full; that tick's input is dropped.
+static bool queue_tick_input(struct Simulation *simulation, struct TickInput *tick_input)
+{
+    if (!push_ring_queue(&simulation->inputs, tick_input))
+    {
+        fprintf(stderr, "[ERROR] Simulation is %u ticks behind, dropping input.\n", simulation->inputs.capacity);
+        return false;
+    }
+
+    if (simulation->threaded)
+        sem_post(&simulation->inputs_ready);
+
+    return true;
+}
+
+static void record_latency(struct LatencyStats *stats, double latency)
+{
+    stats->total += latency;
+    stats->max = max_double(stats->max, latency);
+    ++stats->count;
+}
+
 static struct GameWindow create_window(const char *title, uint32 width, uint32 height)
 {
     glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
@@ -55,6 +419,67 @@ static struct GameWindow create_window(const char *title, uint32 width, uint32 h
 
 int main(int argc, char *argv[])
 {
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *trace_path = NULL;
+    const char *telemetry_path = NULL;
+    const char *scenario_name = DEFAULT_SCENARIO;
+    uint32 seed = 23932487;
+    bool threaded = true;
+    bool perf_counters = false;
+    uintptr_t memory_base_address = GAME_MEMORY_BASE_ADDRESS;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--record") && (i + 1 < argc))
+        {
+            record_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--replay") && (i + 1 < argc))
+        {
+            replay_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--trace") && (i + 1 < argc))
+        {
+            trace_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--telemetry") && (i + 1 < argc))
+        {
+            telemetry_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--scenario") && (i + 1 < argc))
+        {
+            scenario_name = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--seed") && (i + 1 < argc))
+        {
+            seed = (uint32)strtoul(argv[++i], NULL, 0);
+        }
+        else if (!strcmp(argv[i], "--perf-counters"))
+        {
+            perf_counters = true;
+        }
+        else if (!strcmp(argv[i], "--single-thread"))
+        {
+            threaded = false;
+        }
+        else if (!strcmp(argv[i], "--memory-base") && (i + 1 < argc))
+        {
+            memory_base_address = (uintptr_t)strtoull(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--record FILE | --replay FILE] [--scenario NAME] [--seed N] [--trace FILE] [--telemetry FILE] [--perf-counters] [--single-thread] [--memory-base ADDRESS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    init_profiler();
+    if (perf_counters)
+        enable_profile_counters();
+    register_profile_thread("main");
+
+
     //
     // glfw
     //
@@ -95,36 +520,148 @@ int main(int argc, char *argv[])
     // init
     //
 
-    init_random(23932487);
+    struct GameCode game_code = {0};
+    if (!load_game_code(&game_code, GAME_LIBRARY_PATH))
+        return 1;
 
-    struct Input input = {0};
-    struct Renderer renderer = init_renderer();
+    struct MemoryConfig memory_config = {0};
+    // GameState grows with the entity caps (make STRESS=1).
+    memory_config.permanent_size = (sizeof(struct GameState) > MEGABYTES(8)) ? sizeof(struct GameState) : MEGABYTES(8);
+    memory_config.transient_size = GAME_TRANSIENT_SIZE;
+    memory_config.render_size = MEGABYTES(1);
+    memory_config.frame_size = MEGABYTES(1);
+    memory_config.base_address = memory_base_address;
+    memory_config.huge_pages = true;
+    memory_config.prefault = true;
 
     struct GameMemory game_memory = {0};
-    game_memory.game_memory_size = MEGABYTES(8);
-    game_memory.render_memory_size = MEGABYTES(1);
-    game_memory.game_memory = calloc(1, game_memory.game_memory_size);
-    game_memory.render_memory = calloc(1, game_memory.render_memory_size);
+    if (!allocate_game_memory(&game_memory, &memory_config))
+        return 1;
 
-    init_game(&game_memory);
+    // Render memory belongs to the main thread; the simulation never touches it.
+    struct RenderBuffer *render_buffer = push_struct(&game_memory.render_arena, struct RenderBuffer);
+
+    struct Input input = {0};
+    struct Renderer renderer = init_renderer(&game_memory.render_arena, &game_memory.frame_arena);
+
+    struct GameConfig game_config = {0};
+    game_config.seed = seed;
+    game_config.worker_count = 1;
+    game_config.deterministic = false;
+
+    if (!replay_path && !parse_scenario(scenario_name, &game_config.scenario))
+        return 1;
+
+    // The simulation runs well below the display rate; render_game
+    // interpolates between ticks to keep motion smooth.
+    double tick_dt = 1.0 / 30.0;
+
+    // Replays carry their own config, tick rate and screen size, so selection
+    // boxes and move orders land where they did when recorded.
+    uint32 tick_width = window.width;
+    uint32 tick_height = window.height;
+
+    struct ReplayPlayer replay_player = {0};
+    if (replay_path)
+    {
+        if (!open_replay(&replay_player, replay_path))
+            return 1;
+
+        game_config = replay_player.header.config;
+        tick_width = replay_player.header.screen_width;
+        tick_height = replay_player.header.screen_height;
+        tick_dt = replay_player.header.tick_dt;
+    }
+
+    const uint32 ticks_per_second = (uint32)(1.0 / tick_dt + 0.5);
+
+    struct ReplayRecorder replay_recorder = {0};
+    if (record_path)
+    {
+        struct ReplayHeader header = create_replay_header(&game_config, window.width, window.height, (float)tick_dt);
+        if (!begin_replay_recording(&replay_recorder, record_path, &header))
+            return 1;
+    }
+
+    game_code.init_game(&game_memory, &game_config);
+
+    // Ten seconds of history; backspace steps back one second.
+    struct RewindBuffer rewind_buffer = {0};
+    if (!init_rewind_buffer(&rewind_buffer, sizeof(struct GameState), 10 * ticks_per_second, MEGABYTES(64)))
+        return 1;
+
+    size_t static_offset, static_size;
+    game_code.get_static_state_range(&static_offset, &static_size);
+    mark_rewind_range_static(&rewind_buffer, static_offset, static_size);
+
+    struct GameState *game_state = (struct GameState *)game_memory.game_memory;
+    push_rewind_snapshot(&rewind_buffer, game_state, game_state->tick_count, NULL);
+
+    struct Simulation simulation = {0};
+    simulation.game_code = &game_code;
+    simulation.memory = &game_memory;
+    simulation.rewind_buffer = &rewind_buffer;
+    simulation.screen_width = tick_width;
+    simulation.screen_height = tick_height;
+    simulation.tick_dt = (float)tick_dt;
+    simulation.ticks_per_second = ticks_per_second;
+
+    struct TelemetryWriter telemetry = {0};
+    if (telemetry_path)
+    {
+        if (!open_telemetry(&telemetry, telemetry_path, get_profile_ticks_per_second()))
+            return 1;
+
+        simulation.telemetry = &telemetry;
+    }
+
+    if (!start_simulation(&simulation, threaded))
+        return 1;
 
 
     //
     // main loop
     //
 
-    const double tick_dt = 1.0 / 60.0;
     double time = glfwGetTime();
     double tick_accumulator = 0.0;
+    uint64 queued_ticks = 0;
+
+    uint64 presented_tick = 0;
+    struct LatencyStats latency = {0};
+    bool allocation_check_armed = false;
+
+    static struct PerformanceOverlay overlay;
+    bool overlay_key_was_down = false;
+
+    // --trace captures from the first frame; F4 captures again to the same file.
+    struct TraceCapture trace_capture = {0};
+    bool trace_key_was_down = false;
+    if (trace_path)
+        start_trace_capture(&trace_capture, trace_path, TRACE_CAPTURE_FRAMES);
+    else
+        trace_path = "trace.json";
 
     while (!glfwWindowShouldClose(window.glfw))
     {
+        BEGIN_PROFILE_ZONE(PROFILE_FRAME);
+
         //
         // tick
         //
 
         glfwPollEvents();
 
+        // Picks up 'make game' between frames. State lives in game_memory, so
+        // the new code continues from where the old code left off.
+        if (game_code_changed(&game_code, GAME_LIBRARY_PATH))
+        {
+            pthread_mutex_lock(&simulation.code_lock);
+            if (load_game_code(&game_code, GAME_LIBRARY_PATH))
+                fprintf(stderr, "Reloaded game code (%u).\n", game_code.load_count);
+            pthread_mutex_unlock(&simulation.code_lock);
+        }
+
         double new_time = glfwGetTime();
         double frame_time = new_time - time;
         time = new_time;
@@ -134,27 +671,100 @@ int main(int argc, char *argv[])
 
         tick_accumulator += frame_time;
 
+        if (!allocation_check_armed && (queued_ticks >= ALLOCATION_WARMUP_TICKS))
+        {
+            arm_allocation_check();
+            allocation_check_armed = true;
+        }
+
+        set_allocation_phase(ALLOCATION_PHASE_INPUT);
         while (tick_accumulator >= tick_dt)
         {
-            process_input(window.glfw, &input);
+            if (replay_path)
+            {
+                if (!play_replay_tick(&replay_player, &input))
+                {
+                    glfwSetWindowShouldClose(window.glfw, GL_TRUE);
+                    break;
+                }
+            }
+            else
+            {
+                process_input(window.glfw, &input);
+            }
+
+            struct TickInput tick_input;
+            tick_input.input = input;
+            tick_input.sample_time = glfwGetTime();
+
+            if (queue_tick_input(&simulation, &tick_input))
+            {
+                ++queued_ticks;
+                if (record_path)
+                    record_replay_tick(&replay_recorder, &input);
+            }
 
-            tick_game(&game_memory, &input, window.width, window.height, tick_dt);
             clear_input(&input);
-
             tick_accumulator -= tick_dt;
         }
+        set_allocation_phase(ALLOCATION_PHASE_NONE);
+
+        if (!simulation.threaded)
+            simulate_queued_ticks(&simulation);
 
 
         //
         // render
         //
 
+        reset_arena(&game_memory.frame_arena);
+
         glViewport(0, 0, window.width, window.height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        render_game(&game_memory, &renderer, window.width, window.height);
+        // How far the main clock is past the tick in the frame. That is under
+        // one tick unless the simulation is running behind, in which case
+        // render_game clamps it and shows the newest state as is.
+        struct RenderFrame *frame = (struct RenderFrame *)acquire_triple_buffer(&simulation.frames);
+        float alpha = (float)((double)(queued_ticks - frame->tick_sequence) + tick_accumulator / tick_dt);
+        set_allocation_phase(ALLOCATION_PHASE_RENDER);
+
+        // Edge detected per frame; input edges are per tick and ticks are rarer.
+        bool overlay_key_down = key_down(KEY_F3, &input);
+        if (overlay_key_down && !overlay_key_was_down)
+            overlay.visible = !overlay.visible;
+        overlay_key_was_down = overlay_key_down;
+
+        bool trace_key_down = key_down(KEY_F4, &input);
+        if (trace_key_down && !trace_key_was_down && !start_trace_capture(&trace_capture, trace_path, TRACE_CAPTURE_FRAMES))
+            fprintf(stderr, "A trace is already being captured or written.\n");
+        trace_key_was_down = trace_key_down;
+
+        uint32 draw_call_count = renderer.draw_call_count + renderer.sprite_batch.draw_call_count;
+        renderer.draw_call_count = 0;
+        renderer.sprite_batch.draw_call_count = 0;
+        update_overlay(&overlay, time, frame_time, &frame->state, draw_call_count);
+
+        uint64 render_start = __rdtsc();
+        game_code.extract_render_buffer(&frame->state, &input, render_buffer, alpha);
+        draw_overlay(&overlay, render_buffer, window.width, window.height);
+        game_code.render_game(&frame->state, render_buffer, &renderer, window.width, window.height, alpha);
+        atomic_store_explicit(&simulation.render_time, __rdtsc() - render_start, memory_order_relaxed);
+        set_allocation_phase(ALLOCATION_PHASE_NONE);
 
         glfwSwapBuffers(window.glfw);
+
+        // Input-to-photon latency: from sampling a tick's input to the first
+        // swap that shows its result. The swap returning is the closest to
+        // scanout we can see from here.
+        if (frame->tick_sequence != presented_tick)
+        {
+            record_latency(&latency, glfwGetTime() - frame->input_time);
+            presented_tick = frame->tick_sequence;
+        }
+
+        END_PROFILE_ZONE(PROFILE_FRAME);
+        update_trace_capture(&trace_capture, frame->state.ship_count + frame->state.projectile_count);
     }
 
 
@@ -162,9 +772,31 @@ int main(int argc, char *argv[])
     // cleanup
     //
 
-    free(game_memory.render_memory);
-    free(game_memory.game_memory);
+    stop_simulation(&simulation);
+    finish_trace_capture(&trace_capture);
+    close_telemetry(&telemetry);
+
+    if (latency.count > 0)
+    {
+        fprintf(stderr, "Input-to-photon latency (%s): mean %.2f ms, max %.2f ms over %llu ticks.\n",
+                threaded ? "simulation thread" : "single thread",
+                latency.total / (double)latency.count * 1000.0, latency.max * 1000.0, (unsigned long long)latency.count);
+    }
+
+    print_arena_usage(&game_memory.permanent_arena);
+    print_arena_usage(&game_memory.transient_arena);
+    print_arena_usage(&game_memory.render_arena);
+    print_arena_usage(&game_memory.frame_arena);
+    report_allocation_check();
+    print_profile_summary();
+
+    end_replay_recording(&replay_recorder);
+    close_replay(&replay_player);
+
+    free_rewind_buffer(&rewind_buffer);
     clean_renderer(&renderer);
+    free_game_memory(&game_memory);
+    unload_game_code(&game_code);
 
     glfwDestroyWindow(window.glfw);
     glfwTerminate();
@@ -0,0 +1,530 @@
+// Runs two copies of the simulation side by side on the same input stream and
+// reports the first tick where their state hashes disagree. The stream is
+// either synthetic or a replay recorded with --record, which makes this the
+// standard way to time the simulation on a fixed workload.
+//
+// usage: gx_headless [--ticks N] [--seed N] [--scenario NAME] [--workers A B] [--record FILE | --replay FILE]
+//                    [--load SNAPSHOT] [--save SNAPSHOT] [--rewind TICKS] [--trace FILE] [--telemetry FILE]
+//                    [--perf-counters]
+//
+// --scenario picks what init_game builds, see gx_scenario.h; with --seed it
+// fixes the whole run.
+//
+// --rewind keeps a rewind history for the first game and periodically rolls
+// it back TICKS ticks and simulates forward again, which must land on the
+// same hash.
+//
+// --trace writes a trace of the first TRACE_CAPTURE_FRAMES ticks, counting
+// each tick as a frame. --perf-counters adds hardware counters to the zones
+// where the kernel allows them.
+//
+// --telemetry logs every tick of the first game, see gx_telemetry.h.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gx_define.h"
+#include "gx_alloc_check.h"
+#include "gx_io.h"
+#include "gx_math.h"
+#include "gx_memory.h"
+#include "gx_profile.h"
+#include "gx_replay.h"
+#include "gx_rewind.h"
+#include "gx_scenario.h"
+#include "gx_snapshot.h"
+#include "gx_telemetry.h"
+#include "gx_trace.h"
+#include "gx.h"
+
+#define SCREEN_WIDTH  1280
+#define SCREEN_HEIGHT 720
+
+struct Simulation
+{
+    struct GameMemory memory;
+    double tick_time;
+};
+
+static double get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void init_simulation(struct Simulation *simulation, struct GameConfig *config)
+{
+    memset(simulation, 0, sizeof(*simulation));
+
+    // Nothing is rendered, so the render arenas are left minimal. Both
+    // simulations exist at once, so the kernel picks their addresses.
+    struct MemoryConfig memory_config = {0};
+    // GameState grows with the entity caps (make STRESS=1).
+    memory_config.permanent_size = (sizeof(struct GameState) > MEGABYTES(8)) ? sizeof(struct GameState) : MEGABYTES(8);
+    memory_config.transient_size = GAME_TRANSIENT_SIZE;
+    memory_config.render_size = 1;
+    memory_config.frame_size = 1;
+    memory_config.huge_pages = true;
+    memory_config.prefault = true;
+
+    bool allocated = allocate_game_memory(&simulation->memory, &memory_config);
+    ASSERT(allocated);
+
+    init_game(&simulation->memory, config);
+}
+
+static void free_simulation(struct Simulation *simulation)
+{
+    free_game_memory(&simulation->memory);
+}
+
+//
+// synthetic input
+//
+
+// Raw device state for one tick, before edge detection.
+struct InputFrame
+{
+    bool keys[4];
+    bool mouse_buttons[2];
+    vec2 mouse_position;
+};
+
+static const uint32 input_frame_keys[] = {KEY_W, KEY_A, KEY_S, KEY_D};
+
+// Alternates drag selections, move orders and camera pans in phases of a few
+// dozen ticks, so every input path in tick_game is exercised. Pans wander
+// randomly but lean back toward 'focus' so the ships stay on screen.
+static struct InputFrame generate_input_frame(struct Random *random, struct InputFrame *previous, uint32 tick, vec2 camera_position, vec2 focus)
+{
+    struct InputFrame frame = {0};
+    frame.mouse_position = previous->mouse_position;
+
+    const uint32 phase_length = 30;
+    uint32 phase = (tick / phase_length) % 4;
+    bool phase_start = (tick % phase_length) == 0;
+
+    switch (phase)
+    {
+        case 0:
+        {
+            // Drag a selection box: press at a random spot, drift, release at the end.
+            if (phase_start)
+                frame.mouse_position = vec2_new(random_int_r(random, 0, SCREEN_WIDTH - 1), random_int_r(random, 0, SCREEN_HEIGHT - 1));
+            else
+                frame.mouse_position = vec2_add(frame.mouse_position, vec2_new(random_int_r(random, 0, 16), random_int_r(random, 0, 10)));
+
+            frame.mouse_buttons[MOUSE_LEFT] = (tick % phase_length) != phase_length - 1;
+            break;
+        }
+
+        case 1:
+        {
+            // Issue a move order somewhere on screen.
+            if (phase_start)
+                frame.mouse_position = vec2_new(random_int_r(random, 0, SCREEN_WIDTH - 1), random_int_r(random, 0, SCREEN_HEIGHT - 1));
+
+            frame.mouse_buttons[MOUSE_RIGHT] = (tick % phase_length) < 2;
+            break;
+        }
+
+        case 2:
+        {
+            // Pan the camera.
+            vec2 offset = vec2_sub(focus, camera_position);
+            if ((random_r(random) < 0.5f) && (vec2_length2(offset) > 1.0f))
+            {
+                if (abs_float(offset.x) > abs_float(offset.y))
+                    frame.keys[(offset.x > 0.0f) ? 3 : 1] = true;
+                else
+                    frame.keys[(offset.y > 0.0f) ? 0 : 2] = true;
+            }
+            else
+            {
+                frame.keys[random_int_r(random, 0, ARRAY_SIZE(frame.keys) - 1)] = true;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    frame.mouse_position.x = clamp_float(frame.mouse_position.x, 0.0f, SCREEN_WIDTH - 1);
+    frame.mouse_position.y = clamp_float(frame.mouse_position.y, 0.0f, SCREEN_HEIGHT - 1);
+    return frame;
+}
+
+// Mirrors process_input for a frame that did not come from GLFW.
+static void apply_input_frame(struct Input *input, struct InputFrame *frame)
+{
+    for (uint32 i = 0; i < ARRAY_SIZE(input->keys); ++i)
+        input->keys[i] <<= 1;
+
+    for (uint32 i = 0; i < ARRAY_SIZE(frame->keys); ++i)
+    {
+        if (frame->keys[i])
+            input->keys[input_frame_keys[i]] |= 0x01;
+    }
+
+    input->mouse_delta = vec2_sub(input->mouse_position, frame->mouse_position);
+    input->mouse_position = frame->mouse_position;
+
+    for (uint32 i = 0; i < ARRAY_SIZE(input->mouse_buttons); ++i)
+    {
+        input->mouse_buttons[i] <<= 1;
+
+        if ((i < ARRAY_SIZE(frame->mouse_buttons)) && frame->mouse_buttons[i])
+            input->mouse_buttons[i] |= 0x01;
+
+        if (mouse_down_new(i, input))
+            input->mouse_down_positions[i] = input->mouse_position;
+    }
+}
+
+static uint32 parse_uint32(const char *text)
+{
+    char *end = NULL;
+    unsigned long value = strtoul(text, &end, 10);
+    if ((end == text) || (*end != '\0'))
+    {
+        fprintf(stderr, "[ERROR] Expected a number, got '%s'.\n", text);
+        exit(2);
+    }
+
+    return (uint32)value;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32 tick_count = 3600;
+    uint32 seed = 23932487;
+    const char *scenario_name = DEFAULT_SCENARIO;
+    uint32 worker_counts[2] = {1, 1};
+    bool workers_given = false;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *load_path = NULL;
+    const char *save_path = NULL;
+    const char *trace_path = NULL;
+    const char *telemetry_path = NULL;
+    bool perf_counters = false;
+    uint32 rewind_ticks = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--ticks") && (i + 1 < argc))
+        {
+            tick_count = parse_uint32(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--seed") && (i + 1 < argc))
+        {
+            seed = parse_uint32(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--scenario") && (i + 1 < argc))
+        {
+            scenario_name = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--workers") && (i + 2 < argc))
+        {
+            worker_counts[0] = parse_uint32(argv[++i]);
+            worker_counts[1] = parse_uint32(argv[++i]);
+            workers_given = true;
+        }
+        else if (!strcmp(argv[i], "--record") && (i + 1 < argc))
+        {
+            record_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--replay") && (i + 1 < argc))
+        {
+            replay_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--load") && (i + 1 < argc))
+        {
+            load_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--save") && (i + 1 < argc))
+        {
+            save_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--rewind") && (i + 1 < argc))
+        {
+            rewind_ticks = parse_uint32(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--trace") && (i + 1 < argc))
+        {
+            trace_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--telemetry") && (i + 1 < argc))
+        {
+            telemetry_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--perf-counters"))
+        {
+            perf_counters = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--ticks N] [--seed N] [--scenario NAME] [--workers A B] [--record FILE | --replay FILE] [--load SNAPSHOT] [--save SNAPSHOT] [--rewind TICKS] [--trace FILE] [--telemetry FILE] [--perf-counters]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (uint32 i = 0; i < ARRAY_SIZE(worker_counts); ++i)
+    {
+        if ((worker_counts[i] == 0) || (worker_counts[i] > MAX_SIMULATION_WORKERS))
+        {
+            fprintf(stderr, "[ERROR] Worker count must be between 1 and %u.\n", MAX_SIMULATION_WORKERS);
+            return 2;
+        }
+    }
+
+    const float default_tick_dt = 1.0f / 30.0f; // Matches the game.
+
+    struct GameConfig config = {0};
+    config.seed = seed;
+    config.worker_count = worker_counts[0];
+    config.deterministic = true;
+
+    if (!replay_path && !parse_scenario(scenario_name, &config.scenario))
+        return 2;
+
+    uint32 screen_width = SCREEN_WIDTH;
+    uint32 screen_height = SCREEN_HEIGHT;
+    float tick_dt = default_tick_dt;
+
+    // A replay fixes the config and length; only the worker counts can be overridden.
+    struct ReplayPlayer replay_player = {0};
+    if (replay_path)
+    {
+        if (!open_replay(&replay_player, replay_path))
+            return 2;
+
+        config = replay_player.header.config;
+        screen_width = replay_player.header.screen_width;
+        screen_height = replay_player.header.screen_height;
+        tick_dt = replay_player.header.tick_dt;
+        tick_count = (replay_player.header.tick_count > 0) ? replay_player.header.tick_count : UINT32_MAX;
+
+        if (!workers_given)
+            worker_counts[0] = worker_counts[1] = config.worker_count;
+    }
+
+    struct ReplayRecorder replay_recorder = {0};
+    if (record_path)
+    {
+        struct ReplayHeader header = create_replay_header(&config, screen_width, screen_height, tick_dt);
+        if (!begin_replay_recording(&replay_recorder, record_path, &header))
+            return 2;
+    }
+
+    init_profiler();
+    if (perf_counters)
+        enable_profile_counters();
+    register_profile_thread("main");
+
+    // Large, so keep them off the stack.
+    static struct Simulation simulations[2];
+    for (uint32 i = 0; i < ARRAY_SIZE(simulations); ++i)
+    {
+        struct GameConfig simulation_config = config;
+        simulation_config.worker_count = worker_counts[i];
+        init_simulation(&simulations[i], &simulation_config);
+
+        // Both games continue from the snapshot, but keep their own worker counts.
+        if (load_path)
+        {
+            double start = get_time();
+            if (!load_game_snapshot(&simulations[i].memory, load_path))
+                return 2;
+
+            double load_time = get_time() - start;
+            struct GameState *game_state = (struct GameState *)simulations[i].memory.game_memory;
+            game_state->worker_count = worker_counts[i];
+
+            fprintf(stderr, "Loaded tick %u in %.3f ms.\n", game_state->tick_count, load_time * 1000.0);
+        }
+    }
+
+    // The first game is the one traced, recorded and rewound; the second only checks its hash.
+    struct GameState *game_state = (struct GameState *)simulations[0].memory.game_memory;
+    struct GameState *other_state = (struct GameState *)simulations[1].memory.game_memory;
+
+    const uint32 rewind_interval = 97;
+    uint32 rewind_count = 0;
+    struct RewindBuffer rewind_buffer = {0};
+    if (rewind_ticks > 0)
+    {
+        if (!init_rewind_buffer(&rewind_buffer, sizeof(struct GameState), rewind_ticks, MEGABYTES(256)))
+            return 2;
+
+        size_t static_offset, static_size;
+        get_static_state_range(&static_offset, &static_size);
+        mark_rewind_range_static(&rewind_buffer, static_offset, static_size);
+
+        push_rewind_snapshot(&rewind_buffer, game_state, game_state->tick_count, NULL);
+    }
+
+    struct Random input_random = create_random(seed ^ 0x9e3779b9);
+    struct InputFrame frame = {0};
+    frame.mouse_position = vec2_new(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+
+    struct Input input = {0};
+    int result = 0;
+    uint32 tick = 0;
+    uint64 tier_totals[SIMULATION_TIER_COUNT] = {0};
+
+#ifdef GX_ALLOC_CHECK
+    // Nothing is drawn, but extracting exercises the game's render-side code.
+    static struct RenderState render_state;
+    static struct RenderBuffer render_buffer;
+#endif
+
+    struct TraceCapture trace_capture = {0};
+    if (trace_path)
+        start_trace_capture(&trace_capture, trace_path, TRACE_CAPTURE_FRAMES);
+
+    struct TelemetryWriter telemetry = {0};
+    if (telemetry_path && !open_telemetry(&telemetry, telemetry_path, get_profile_ticks_per_second()))
+        return 2;
+
+    for (; tick < tick_count; ++tick)
+    {
+        if (tick == ALLOCATION_WARMUP_TICKS)
+            arm_allocation_check();
+
+        set_allocation_phase(ALLOCATION_PHASE_INPUT);
+        if (replay_path)
+        {
+            if (!play_replay_tick(&replay_player, &input))
+                break;
+        }
+        else
+        {
+            vec2 focus = vec2_zero();
+            for (uint32 i = 0; i < game_state->ship_count; ++i)
+                focus = vec2_add(focus, vec2_div(game_state->ships[i].position, (float)game_state->ship_count));
+
+            frame = generate_input_frame(&input_random, &frame, tick, game_state->camera.position, focus);
+            apply_input_frame(&input, &frame);
+        }
+
+        if (record_path)
+            record_replay_tick(&replay_recorder, &input);
+
+        set_allocation_phase(ALLOCATION_PHASE_TICK);
+        for (uint32 i = 0; i < ARRAY_SIZE(simulations); ++i)
+        {
+            struct Simulation *simulation = &simulations[i];
+            struct Input simulation_input = input;
+
+            double start = get_time();
+            uint64 tick_start = rdtsc();
+            tick_game(&simulation->memory, &simulation_input, screen_width, screen_height, tick_dt);
+            uint64 tick_time = rdtsc() - tick_start;
+            simulation->tick_time += get_time() - start;
+
+            if (telemetry_path && (i == 0))
+                write_telemetry(&telemetry, game_state, tick_time, 0);
+        }
+
+        if (rewind_ticks > 0)
+        {
+            push_rewind_snapshot(&rewind_buffer, game_state, game_state->tick_count, &input);
+
+            uint32 now = game_state->tick_count;
+            if ((tick % rewind_interval == rewind_interval - 1) && (now - get_oldest_rewind_tick(&rewind_buffer) >= rewind_ticks))
+            {
+                uint64 expected_hash = game_state->state_hash;
+
+                bool rewound = rewind_to_tick(&rewind_buffer, game_state, now - rewind_ticks);
+                ASSERT(rewound);
+                resimulate_to_tick(&rewind_buffer, &simulations[0].memory, tick_game, now, screen_width, screen_height, tick_dt);
+                ++rewind_count;
+
+                if (game_state->state_hash != expected_hash)
+                {
+                    fprintf(stderr, "Rollback of %u ticks at tick %u did not reproduce the state.\n", rewind_ticks, tick);
+                    result = 1;
+                    break;
+                }
+            }
+        }
+
+#ifdef GX_ALLOC_CHECK
+        set_allocation_phase(ALLOCATION_PHASE_RENDER);
+        copy_render_state(&simulations[0].memory, &render_state);
+        extract_render_buffer(&render_state, &input, &render_buffer, 1.0f);
+#endif
+        set_allocation_phase(ALLOCATION_PHASE_NONE);
+
+        clear_input(&input);
+        update_trace_capture(&trace_capture, game_state->ship_count + game_state->projectile_count);
+
+        for (uint32 i = 0; i < SIMULATION_TIER_COUNT; ++i)
+            tier_totals[i] += game_state->tier_counts[i];
+
+        if (game_state->state_hash != other_state->state_hash)
+        {
+            fprintf(stderr, "Diverged at tick %u: %016llx != %016llx (%u/%u ships, %u/%u projectiles).\n",
+                    tick, (unsigned long long)game_state->state_hash, (unsigned long long)other_state->state_hash,
+                    game_state->ship_count, other_state->ship_count, game_state->projectile_count, other_state->projectile_count);
+            result = 1;
+            break;
+        }
+    }
+    set_allocation_phase(ALLOCATION_PHASE_NONE);
+
+    if (result == 0)
+    {
+        fprintf(stderr, "No divergence in %u ticks, final hash %016llx.\n", tick, (unsigned long long)game_state->state_hash);
+    }
+
+    for (uint32 i = 0; i < ARRAY_SIZE(simulations); ++i)
+    {
+        double tick_time = simulations[i].tick_time;
+        fprintf(stdout, "simulation %u (%u workers): %.3f ms total, %.4f ms/tick\n",
+                i, worker_counts[i], tick_time * 1000.0, (tick > 0) ? tick_time * 1000.0 / tick : 0.0);
+    }
+
+    if (tick > 0)
+    {
+        fprintf(stdout, "lod: %.1f active, %.1f distant, %.1f sleeping ships per tick\n",
+                (double)tier_totals[TIER_ACTIVE] / tick, (double)tier_totals[TIER_DISTANT] / tick, (double)tier_totals[TIER_SLEEPING] / tick);
+    }
+
+    if (rewind_ticks > 0)
+    {
+        struct RewindBuffer *buffer = &rewind_buffer;
+        double ticks = (buffer->snapshot_count > 0) ? (double)buffer->snapshot_count : 1.0;
+        fprintf(stdout, "rewind: %u rollbacks of %u ticks, snapshot %.1f us/tick, %.1f KB/tick, %.2f MB per second of history (+%.2f MB shadow)\n",
+                rewind_count, rewind_ticks, buffer->snapshot_seconds * 1e6 / ticks, (double)buffer->snapshot_bytes / ticks / 1024.0,
+                (double)get_rewind_memory_per_second(buffer, (uint32)(1.0f / tick_dt + 0.5f)) / (1024.0 * 1024.0),
+                (double)buffer->state_size / (1024.0 * 1024.0));
+        free_rewind_buffer(buffer);
+    }
+
+    finish_trace_capture(&trace_capture);
+    close_telemetry(&telemetry);
+    print_profile_summary();
+    print_arena_usage(&simulations[0].memory.permanent_arena);
+    print_arena_usage(&simulations[0].memory.transient_arena);
+
+    if (!report_allocation_check())
+        result = 1;
+
+    if (save_path && !save_game_snapshot(&simulations[0].memory, save_path))
+        result = 2;
+
+    end_replay_recording(&replay_recorder);
+    close_replay(&replay_player);
+
+    for (uint32 i = 0; i < ARRAY_SIZE(simulations); ++i)
+        free_simulation(&simulations[i]);
+
+    return result;
+}
@@ -0,0 +1,118 @@
+// Converts a telemetry log written with --telemetry to CSV on stdout, one row
+// per record. Durations are in milliseconds; the grid hit rate is the share
+// of projectile-building queries the occupancy grid answered on its own.
+// Logs still being written can be read; only complete records are shown.
+//
+// usage: gx_telemetry_csv LOG [--from TICK] [--to TICK]
+//
+// --from and --to keep records whose tick is in [FROM, TO]. Rewinds repeat
+// ticks, so a range can include a tick more than once.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gx_define.h"
+#include "gx_telemetry.h"
+
+static uint32 parse_uint32(const char *text)
+{
+    char *end = NULL;
+    unsigned long value = strtoul(text, &end, 10);
+    if ((end == text) || (*end != '\0'))
+    {
+        fprintf(stderr, "[ERROR] Expected a number, got '%s'.\n", text);
+        exit(2);
+    }
+
+    return (uint32)value;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    uint32 first_tick = 0;
+    uint32 last_tick = UINT32_MAX;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--from") && (i + 1 < argc))
+        {
+            first_tick = parse_uint32(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--to") && (i + 1 < argc))
+        {
+            last_tick = parse_uint32(argv[++i]);
+        }
+        else if (!path && (argv[i][0] != '-'))
+        {
+            path = argv[i];
+        }
+        else
+        {
+            path = NULL;
+            break;
+        }
+    }
+
+    if (!path)
+    {
+        fprintf(stderr, "usage: %s LOG [--from TICK] [--to TICK]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "[ERROR] Failed to open telemetry log '%s'.\n", path);
+        return 1;
+    }
+
+    struct TelemetryHeader header;
+    if ((fread(&header, sizeof(header), 1, file) != 1) || (header.magic != TELEMETRY_MAGIC) ||
+        (header.version != TELEMETRY_VERSION) || (header.record_size != sizeof(struct TelemetryRecord)))
+    {
+        fprintf(stderr, "[ERROR] '%s' is not a telemetry log this build can read.\n", path);
+        fclose(file);
+        return 1;
+    }
+
+    if (fseek(file, (long)header.header_size, SEEK_SET) != 0)
+    {
+        fprintf(stderr, "[ERROR] Failed to read telemetry log '%s'.\n", path);
+        fclose(file);
+        return 1;
+    }
+
+    double milliseconds_per_tick = 1000.0 / header.ticks_per_second;
+    uint64 record_count = atomic_load(&header.record_count);
+
+    fprintf(stdout, "tick,tick_ms,render_ms,ships,active_ships,projectiles,pair_tests,pairs_resolved,"
+                    "projectile_tests,projectile_hits,path_requests,path_nodes_expanded,building_queries,grid_hit_rate\n");
+
+    for (uint64 i = 0; i < record_count; ++i)
+    {
+        struct TelemetryRecord record;
+        if (fread(&record, sizeof(record), 1, file) != 1)
+        {
+            fprintf(stderr, "[ERROR] Telemetry log '%s' ends after %llu of %llu records.\n",
+                    path, (unsigned long long)i, (unsigned long long)record_count);
+            fclose(file);
+            return 1;
+        }
+
+        if ((record.tick < first_tick) || (record.tick > last_tick))
+            continue;
+
+        struct TickStats *stats = &record.stats;
+        double grid_hit_rate = stats->building_queries ? (double)stats->building_grid_hits / (double)stats->building_queries : 0.0;
+
+        fprintf(stdout, "%u,%.4f,%.4f,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.4f\n",
+                record.tick, (double)record.tick_time * milliseconds_per_tick, (double)record.render_time * milliseconds_per_tick,
+                record.ship_count, record.active_ship_count, record.projectile_count,
+                stats->pair_tests, stats->pairs_resolved, stats->projectile_tests, stats->projectile_hits,
+                stats->path_requests, stats->path_nodes_expanded, stats->building_queries, grid_hit_rate);
+    }
+
+    fclose(file);
+    return 0;
+}